@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <format>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "builtins.h"
+#include "error_manager.h"
+#include "operators.h"
+#include "runtime_values.h"
+#include "std.h"
+#include "utilities.h"
+
+// Runtime support for the C++ that Transpiler writes ('olm --compilar').
+// Each helper does, and fails, like the matching step of the interpreter;
+// generated code calls them directly, with no dispatch in between.
+namespace aot {
+
+[[noreturn]] inline auto fail(const std::string& msg) -> Value {
+  throw RuntimeError(msg);
+}
+
+[[noreturn]] inline auto overflow(std::string_view op) -> int64_t {
+  throw RuntimeError(std::format("desbordamiento de entero en '{}'", op));
+}
+
+// Operators on values Sema proved to be ints or floats.
+inline auto add(int64_t a, int64_t b) -> int64_t {
+  int64_t out;
+  return __builtin_add_overflow(a, b, &out) ? overflow("+") : out;
+}
+inline auto sub(int64_t a, int64_t b) -> int64_t {
+  int64_t out;
+  return __builtin_sub_overflow(a, b, &out) ? overflow("-") : out;
+}
+inline auto mul(int64_t a, int64_t b) -> int64_t {
+  int64_t out;
+  return __builtin_mul_overflow(a, b, &out) ? overflow("*") : out;
+}
+inline auto div(int64_t a, int64_t b) -> int64_t {
+  if (b == 0) throw RuntimeError("division por cero");
+  if (a == std::numeric_limits<int64_t>::min() && b == -1) overflow("/");
+  return a / b;
+}
+inline auto neg(int64_t a) -> int64_t {
+  return a == std::numeric_limits<int64_t>::min() ? overflow("-") : -a;
+}
+inline auto div(double a, double b) -> double {
+  if (b == 0.0) throw RuntimeError("division por cero");
+  return a / b;
+}
+
+// Top-level variables seen from inside a function, which may run before
+// the declaration does.
+template <class T>
+inline auto global(const T& var, bool defined, std::string_view name) -> const T& {
+  if (!defined) throw RuntimeError(std::format("variable '{}' no definida", name));
+  return var;
+}
+template <class T, class V>
+inline auto assign(T& var, bool defined, V&& value, std::string_view name) -> void {
+  if (!defined) throw RuntimeError(std::format("asignacion a variable no declarada '{}'", name));
+  var = std::forward<V>(value);
+}
+
+// Placeholder for a nested function until its declaration runs.
+inline auto undefined(std::string_view name) {
+  return [name](auto&&...) -> Value {
+    fail(std::format("funcion '{}' no definida", name));
+  };
+}
+
+inline auto builtin(const NativeMethodDesc& desc, std::initializer_list<Value> args) -> Value {
+  return desc.fn({}, std::span<const Value>(args.begin(), args.size()));
+}
+
+// Layout of a class, built the way Interpreter::exec_class_decl does.
+inline auto make_class(std::string name, std::initializer_list<std::string_view> fields) -> std::shared_ptr<ClassDef> {
+  auto def  = std::make_shared<ClassDef>();
+  def->name = std::move(name);
+  for (auto f : fields)
+    def->add_field(intern(f), nullptr);
+  return def;
+}
+
+inline auto instance(const Value& obj) -> Instance& {
+  if (!obj.is_instance())
+    throw RuntimeError(std::format("'{}' no es una instancia", obj.to_string()));
+  return *obj.as_instance();
+}
+
+inline auto get_field(const Value& obj, const std::string* name) -> Value {
+  auto* value = instance(obj).field(name);
+  if (!value)
+    throw RuntimeError(std::format("la instancia no tiene campo '{}'", *name));
+  return *value;
+}
+
+inline auto set_field(const Value& obj, const std::string* name, Value value) -> void {
+  instance(obj).set_field(name, std::move(value));
+}
+
+// Methods of arrays and strings; instances go through generated dispatchers.
+inline auto invoke(const Value& recv, std::string_view name, std::initializer_list<Value> args) -> Value {
+  std::span<const NativeMethodDesc> methods;
+  if (recv.is_array())
+    methods = ARRAY_METHODS;
+  else if (recv.is_string())
+    methods = STRING_METHODS;
+  else
+    throw RuntimeError("Metodo Invalido");
+
+  auto* method = find_builtin(methods, name);
+  if (!method)
+    throw RuntimeError("Invalido metodo");
+  if (!method->variadic && args.size() != method->arity)
+    throw RuntimeError("argumento(s) invalido(s)");
+  return method->fn(recv, std::span<const Value>(args.begin(), args.size()));
+}
+
+}
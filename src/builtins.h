@@ -28,14 +28,6 @@ static constexpr NativeMethodDesc FREE_FUNCTIONS[] {
   { "min", 2, false, std_min},
 };
 
-constexpr static inline auto is_builtin(std::string_view name) -> bool {
-  for (auto i{0uz}; i < countof(FREE_FUNCTIONS); i++) {
-    if (name == FREE_FUNCTIONS[i].name)
-      return true;
-  }
-  return false;
-}
-
 static constexpr NativeMethodDesc ARRAY_METHODS[] {
   { "insertar", 1, false, array_insertar },
   { "insertar_en", 2, false, array_insertar_en },
@@ -0,0 +1,105 @@
+#include "bytecode.h"
+#include <format>
+#include <limits>
+#include <print>
+#include "error_manager.h"
+
+auto Chunk::emit_u16(uint16_t v) -> void {
+  code.push_back(static_cast<uint8_t>(v & 0xff));
+  code.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+auto Chunk::patch_u16(std::size_t at, uint16_t v) -> void {
+  code[at]     = static_cast<uint8_t>(v & 0xff);
+  code[at + 1] = static_cast<uint8_t>(v >> 8);
+}
+
+auto Chunk::add_constant(Value v) -> uint16_t {
+  if (constants.size() > std::numeric_limits<uint16_t>::max())
+    throw RuntimeError("demasiadas constantes en una funcion");
+  constants.push_back(std::move(v));
+  return static_cast<uint16_t>(constants.size() - 1);
+}
+
+// UNUSED:
+
+namespace {
+auto read_u16(const Chunk& chunk, std::size_t at) -> uint16_t {
+  return static_cast<uint16_t>(chunk.code[at] | (chunk.code[at + 1] << 8));
+}
+
+auto debug_see_chunk(const Program& program, const Function& fn) -> void {
+  std::println("== {} (aridad {}, locales {}) ==", fn.name, fn.arity, fn.num_locals);
+  const auto& chunk = fn.chunk;
+
+  for (auto i{0uz}; i < chunk.code.size();) {
+    auto op = static_cast<OpCode>(chunk.code[i]);
+    std::print("{:04} ", i);
+    i++;
+    switch (op) {
+      using enum OpCode;
+      case CONSTANT:
+        std::println("CONSTANT      {}", chunk.constants[read_u16(chunk, i)].to_string()); i += 2; break;
+      case GET_LOCAL:     std::println("GET_LOCAL     {}", read_u16(chunk, i)); i += 2; break;
+      case SET_LOCAL:     std::println("SET_LOCAL     {}", read_u16(chunk, i)); i += 2; break;
+      case GET_GLOBAL:    std::println("GET_GLOBAL    {}", program.globals[read_u16(chunk, i)]); i += 2; break;
+      case SET_GLOBAL:    std::println("SET_GLOBAL    {}", program.globals[read_u16(chunk, i)]); i += 2; break;
+      case GET_OUTER:
+        std::println("GET_OUTER     {} ({})", read_u16(chunk, i), chunk.code[i + 2]); i += 3; break;
+      case SET_OUTER:
+        std::println("SET_OUTER     {} ({})", read_u16(chunk, i), chunk.code[i + 2]); i += 3; break;
+      case DEFINE_GLOBAL: std::println("DEFINE_GLOBAL {}", program.globals[read_u16(chunk, i)]); i += 2; break;
+      case APPEND_LOCAL:
+        std::println("APPEND_LOCAL  {} ({})", read_u16(chunk, i), chunk.code[i + 2]); i += 3; break;
+      case APPEND_GLOBAL:
+        std::println("APPEND_GLOBAL {} ({})", program.globals[read_u16(chunk, i)], chunk.code[i + 2]); i += 3; break;
+      case GET_FIELD:     std::println("GET_FIELD     {}", *program.names[read_u16(chunk, i)]); i += 2; break;
+      case SET_FIELD:     std::println("SET_FIELD     {}", *program.names[read_u16(chunk, i)]); i += 2; break;
+      case ARRAY:         std::println("ARRAY         {}", read_u16(chunk, i)); i += 2; break;
+      case JUMP:          std::println("JUMP          -> {}", i + 2 + read_u16(chunk, i)); i += 2; break;
+      case JUMP_IF_FALSE: std::println("JUMP_IF_FALSE -> {}", i + 2 + read_u16(chunk, i)); i += 2; break;
+      case JUMP_IF_TRUE:  std::println("JUMP_IF_TRUE  -> {}", i + 2 + read_u16(chunk, i)); i += 2; break;
+      case LOOP:          std::println("LOOP          -> {}", i + 2 - read_u16(chunk, i)); i += 2; break;
+      case CALL:
+        std::println("CALL          {} ({})", program.functions[read_u16(chunk, i)].name, chunk.code[i + 2]); i += 3; break;
+      case TAIL_CALL:
+        std::println("TAIL_CALL     {} ({})", program.functions[read_u16(chunk, i)].name, chunk.code[i + 2]); i += 3; break;
+      case CALL_BUILTIN:
+        std::println("CALL_BUILTIN  #{} ({})", read_u16(chunk, i), chunk.code[i + 2]); i += 3; break;
+      case NEW:
+        std::println("NEW           {} ({})", program.classes[read_u16(chunk, i)].def->name, chunk.code[i + 2]); i += 3; break;
+      case INVOKE:
+        std::println("INVOKE        {} ({})", *program.names[read_u16(chunk, i)], chunk.code[i + 2]); i += 3; break;
+      case PUSH_NIL:      std::println("PUSH_NIL");      break;
+      case PUSH_TRUE:     std::println("PUSH_TRUE");     break;
+      case PUSH_FALSE:    std::println("PUSH_FALSE");    break;
+      case POP:           std::println("POP");           break;
+      case GET_SELF:      std::println("GET_SELF");      break;
+      case GET_INDEX:     std::println("GET_INDEX");     break;
+      case SET_INDEX:     std::println("SET_INDEX");     break;
+      case ADD:           std::println("ADD");           break;
+      case SUB:           std::println("SUB");           break;
+      case MUL:           std::println("MUL");           break;
+      case DIV:           std::println("DIV");           break;
+      case EQUAL:         std::println("EQUAL");         break;
+      case NOT_EQUAL:     std::println("NOT_EQUAL");     break;
+      case LESS:          std::println("LESS");          break;
+      case GREATER:       std::println("GREATER");       break;
+      case LESS_EQUAL:    std::println("LESS_EQUAL");    break;
+      case GREATER_EQUAL: std::println("GREATER_EQUAL"); break;
+      case NEGATE:        std::println("NEGATE");        break;
+      case NOT:           std::println("NOT");           break;
+      case TO_BOOL:       std::println("TO_BOOL");       break;
+      case RETURN:        std::println("RETURN");        break;
+      case HALT:          std::println("HALT");          break;
+      default:            std::println("ILEGAL");        break;
+    }
+  }
+}
+}
+
+auto debug_see_bytecode(const Program& program) -> void {
+  debug_see_chunk(program, program.script);
+  for (const auto& fn : program.functions)
+    debug_see_chunk(program, fn);
+}
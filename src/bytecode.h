@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <flat_map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "runtime_values.h"
+
+// Operands are little endian. u16 = 2 bytes, u8 = 1 byte.
+enum class OpCode : uint8_t {
+  CONSTANT,        // [u16 constant]
+  PUSH_NIL, PUSH_TRUE, PUSH_FALSE,
+  POP,
+  GET_LOCAL,       // [u16 slot]
+  SET_LOCAL,       // [u16 slot]
+  GET_GLOBAL,      // [u16 global]
+  SET_GLOBAL,      // [u16 global]
+  GET_OUTER,       // [u16 slot] [u8 hops]  local of an enclosing function (see Function::enclosing)
+  SET_OUTER,       // [u16 slot] [u8 hops]
+  DEFINE_GLOBAL,   // [u16 global]
+  APPEND_LOCAL,    // [u16 slot]   [u8 count]  addends ->   (see Assignment::appends)
+  APPEND_GLOBAL,   // [u16 global] [u8 count]  addends ->
+  GET_SELF,
+  GET_FIELD,       // [u16 name]       obj           -> value
+  SET_FIELD,       // [u16 name]       value, obj    ->
+  GET_INDEX,       //                  obj, idx      -> value
+  SET_INDEX,       //                  value, obj, idx ->
+  ADD, SUB, MUL, DIV,
+  EQUAL, NOT_EQUAL, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL,
+  NEGATE, NOT, TO_BOOL,
+  JUMP,            // [u16 forward offset]
+  JUMP_IF_FALSE,   // [u16 forward offset] pops the condition
+  JUMP_IF_TRUE,    // [u16 forward offset] pops the condition
+  LOOP,            // [u16 backward offset]
+  CALL,            // [u16 function] [u8 argc]
+  TAIL_CALL,       // [u16 function] [u8 argc]  CALL that replaces the current frame
+  CALL_BUILTIN,    // [u16 builtin]  [u8 argc]
+  NEW,             // [u16 class]    [u8 argc]
+  INVOKE,          // [u16 name]     [u8 argc]  receiver, args -> value
+  ARRAY,           // [u16 count]
+  RETURN,
+  HALT,
+};
+
+struct Chunk final {
+  std::vector<uint8_t>  code{};
+  std::vector<Value> constants{};
+
+  auto emit(OpCode op)                  -> void { code.push_back(static_cast<uint8_t>(op)); }
+  auto emit_u8(uint8_t v)               -> void { code.push_back(v); }
+  auto emit_u16(uint16_t v)             -> void;
+  auto patch_u16(std::size_t at, uint16_t v) -> void;
+  auto add_constant(Value v)         -> uint16_t;
+};
+
+struct Function final {
+  static constexpr std::size_t TOP_LEVEL = SIZE_MAX;
+
+  std::string name{};
+  std::size_t arity{};
+  std::size_t num_locals{};  // parameters included
+  // Function the declaration is nested in (for methods and initializers,
+  // the one the class is), TOP_LEVEL for the script. A call links its
+  // frame to the innermost live frame of that function, which is where
+  // GET_OUTER and SET_OUTER find the enclosing locals.
+  std::size_t enclosing{TOP_LEVEL};
+  Chunk chunk{};
+};
+
+struct CompiledClass final {
+  std::shared_ptr<ClassDef> def{};
+  std::size_t init{};                  // synthetic function: field initializers + 'crear'
+  bool has_ctor{};
+  std::flat_map<uint16_t, std::size_t> methods{}; // name index -> function index
+};
+
+struct Program final {
+  Function script{};
+  std::vector<Function>      functions{};
+  std::vector<CompiledClass> classes{};
+  std::vector<std::string>   globals{};
+  std::vector<const std::string*> names{};  // interned
+};
+
+[[maybe_unused]] auto debug_see_bytecode(const Program& program) -> void;
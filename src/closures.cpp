@@ -0,0 +1,317 @@
+// Closure mode of the Interpreter (InterpreterOptions::closures). Each node
+// is converted once into a C++ callable that holds its children's
+// callables and everything decided from the node alone (operator, slot,
+// the routine for operand types Sema proved); running the program then
+// only calls closures, with no switch on node_type. Semantics are the
+// tree walker's: both share the helpers in interpreter.cpp. Function
+// bodies and field initializers are converted on first use.
+#include "interpreter.h"
+#include <format>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "error_manager.h"
+#include "nodes.h"
+#include "operators.h"
+#include "runtime_values.h"
+using enum NodeType;
+
+namespace {
+// Evaluates 'args' in order onto the top of 'stack', where a called
+// function takes them as the start of its frame, and passes them to 'use'.
+template <class Args, class Use>
+auto with_args(ValueStack& stack, const Args& args, Use use) -> Value {
+  ValueStack::Scope scope{stack};
+  auto values = stack.push(args.size());
+  for (auto i {0uz}; i < args.size(); ++i)
+    values[i] = args[i]();
+  return use(values);
+}
+}
+
+auto Interpreter::exec_body(const FunctionDecl* fn) -> Flow {
+  if (!_options.closures)
+    return exec_stmts(fn->body);
+  auto it = _bodies.find(fn);
+  if (it == _bodies.end())
+    it = _bodies.emplace(fn, close_stmts(fn->body)).first;
+  return it->second();
+}
+
+auto Interpreter::eval_init(const IAST* init) -> Value {
+  if (!_options.closures)
+    return eval(init);
+  auto it = _inits.find(init);
+  if (it == _inits.end())
+    it = _inits.emplace(init, close_expr(init)).first;
+  return it->second();
+}
+
+auto Interpreter::close_stmts(const StmtsPtr& stmts) -> StmtClosure {
+  std::vector<StmtClosure> list;
+  list.reserve(stmts.size());
+  for (const auto& s : stmts)
+    list.push_back(close_stmt(s.get()));
+
+  switch (list.size()) {
+    case 0:  return [] { return Flow::NORMAL; };
+    case 1:  return std::move(list.front());
+    default:
+      return [list = std::move(list)] {
+        for (const auto& s : list)
+          if (auto flow = s(); flow != Flow::NORMAL)
+            return flow;
+        return Flow::NORMAL;
+      };
+  }
+}
+
+auto Interpreter::close_stmt(const IAST* node) -> StmtClosure {
+  if (!node)
+    return [] { return Flow::NORMAL; };
+  switch (node->node_type) {
+    case VARIABLEDECL: {
+      auto* vd   = static_cast<const VariableDecl*>(node);
+      auto value = close_expr(vd->expr.get());
+      return [this, slot = vd->slot, value = std::move(value)] {
+        _env.define(slot, value());
+        return Flow::NORMAL;
+      };
+    }
+    case FUNCTIONDECL:
+      return [this, fn = static_cast<const FunctionDecl*>(node)] {
+        exec_func_decl(fn);
+        return Flow::NORMAL;
+      };
+    case CLASSDECL:
+      return [this, klass = static_cast<const ClassDecl*>(node)] {
+        exec_class_decl(klass);
+        return Flow::NORMAL;
+      };
+    case ASSIGNMENT:      return close_assignment(static_cast<const Assignment*>(node));
+    case IFSTATEMENT:     return close_if(static_cast<const IfStatement*>(node));
+    case RETURNSTATEMENT: return close_return(static_cast<const ReturnStatement*>(node));
+    case CONTINUESTMT:    return [] { return Flow::CONTINUE; };
+    case WHILESTATEMENT: {
+      auto* loop = static_cast<const WhileStatement*>(node);
+      return [cond = close_expr(loop->condition.get()), body = close_stmts(loop->body)] {
+        while (cond().truthy())
+          if (body() == Flow::RETURN)
+            return Flow::RETURN;
+        return Flow::NORMAL;
+      };
+    }
+    case FUNCTIONCALL:
+    case METHODCALL:
+      return [call = close_expr(node)] {
+        call();
+        return Flow::NORMAL;
+      };
+    default:
+      return []() -> Flow { throw RuntimeError("nodo de declaracion desconocido"); };
+  }
+}
+
+auto Interpreter::close_if(const IfStatement* node) -> StmtClosure {
+  auto cond = close_expr(node->condition.get());
+  auto then = close_stmts(node->then_body);
+  StmtClosure other;
+  if (auto* els = std::get_if<StmtsPtr>(&node->next))
+    other = close_stmts(*els);
+  else if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&node->next))
+    other = close_if(elif->get());
+
+  if (!other)
+    return [cond = std::move(cond), then = std::move(then)] {
+      return cond().truthy() ? then() : Flow::NORMAL;
+    };
+  return [cond = std::move(cond), then = std::move(then), other = std::move(other)] {
+    return cond().truthy() ? then() : other();
+  };
+}
+
+// The value is computed before the target's object, as exec_assignment does.
+auto Interpreter::close_assignment(const Assignment* node) -> StmtClosure {
+  auto value = close_expr(node->expr.get());
+  switch (node->target->node_type) {
+    case LITERAL: {
+      auto* lit = static_cast<const Literal*>(node->target.get());
+      if (node->appends)
+        return [this, node, value = std::move(value), slot = lit->slot, name = std::string_view(lit->token.literal)] {
+          if (!append_in_place(node))
+            _env.set(slot, name, value());
+          return Flow::NORMAL;
+        };
+      return [this, value = std::move(value), slot = lit->slot, name = std::string_view(lit->token.literal)] {
+        _env.set(slot, name, value());
+        return Flow::NORMAL;
+      };
+    }
+    case MEMBERACCESS: {
+      auto* member = static_cast<const MemberAccess*>(node->target.get());
+      return [this, member, value = std::move(value), obj = close_expr(member->object.get())] {
+        auto val = value();
+        assign_member(member, obj(), std::move(val));
+        return Flow::NORMAL;
+      };
+    }
+    case INDEXEXPR: {
+      auto* idx = static_cast<const IndexExpr*>(node->target.get());
+      return [value = std::move(value), obj = close_expr(idx->object.get()), index = close_expr(idx->index.get())] {
+        auto val = value();
+        auto o   = obj();
+        auto i   = index();
+        assign_index(o, i, std::move(val));
+        return Flow::NORMAL;
+      };
+    }
+    default:
+      return []() -> Flow { throw RuntimeError("asignacion a objetivo invalido"); };
+  }
+}
+
+auto Interpreter::close_return(const ReturnStatement* node) -> StmtClosure {
+  auto value = close_expr(node->expr.get());
+  if (!node->tail_call)
+    return [this, value = std::move(value)] {
+      _return_value = value();
+      return Flow::RETURN;
+    };
+
+  auto* call = static_cast<const FunctionCall*>(node->expr.get());
+  return [this, call, args = close_args(call->exprs), value = std::move(value)] {
+    if (auto* callee = tail_callee(call)) {
+      auto mark   = _values.mark();
+      auto values = _values.push(args.size());
+      for (auto i {0uz}; i < args.size(); ++i)
+        values[i] = args[i]();
+      _tail = {.callee = callee, .args = values, .mark = mark};
+      return Flow::RETURN;
+    }
+    _return_value = value();
+    return Flow::RETURN;
+  };
+}
+
+auto Interpreter::close_expr(const IAST* node) -> ExprClosure {
+  if (!node)
+    return [] { return make_null(); };
+  switch (node->node_type) {
+    case LITERAL: {
+      auto* lit = static_cast<const Literal*>(node);
+      switch (lit->token.type) {
+        case TokenType::INTEGER:
+        case TokenType::FLOAT:
+        case TokenType::BOOL:
+        case TokenType::STRING:
+        case TokenType::NIL:
+          return [value = lit->value] { return value; };
+        case TokenType::SELF:
+          return [this] { return _env.self(); };
+        case TokenType::IDENTIFIER:
+          return [this, slot = lit->slot, name = std::string_view(lit->token.literal)] {
+            return _env.get(slot, name);
+          };
+        default:
+          return [msg = std::format("literal desconocido '{}'", lit->token.literal)]() -> Value {
+            throw RuntimeError(msg);
+          };
+      }
+    }
+    case BINARYOP:     return close_binary(static_cast<const BinaryOp*>(node));
+    case FUNCTIONCALL: return close_call(static_cast<const FunctionCall*>(node));
+    case METHODCALL:   return close_method_call(static_cast<const MethodCall*>(node));
+    case UNARYOP: {
+      auto* un = static_cast<const UnaryOp*>(node);
+      return [op = un->op, operand = close_expr(un->operand.get())] { return unary_op(op, operand()); };
+    }
+    case ARRAYDECL:
+      return [items = close_args(static_cast<const ArrayDecl*>(node)->data)] {
+        std::vector<Value> values;
+        values.reserve(items.size());
+        for (const auto& item : items)
+          values.push_back(item());
+        return make(std::move(values));
+      };
+    case INDEXEXPR: {
+      auto* idx = static_cast<const IndexExpr*>(node);
+      return [idx, obj = close_expr(idx->object.get()), index = close_expr(idx->index.get())] {
+        auto o = obj();
+        auto i = index();
+        return apply_index(idx, o, i);
+      };
+    }
+    case MEMBERACCESS: {
+      auto* member = static_cast<const MemberAccess*>(node);
+      return [this, member, obj = close_expr(member->object.get())] { return member_value(member, obj()); };
+    }
+    default:
+      return []() -> Value { throw RuntimeError("nodo de expresion desconocido"); };
+  }
+}
+
+// Operands Sema proved to be ints or floats get their routine now; other
+// sites stay quickened on the types they see, as in the walker.
+auto Interpreter::close_binary(const BinaryOp* node) -> ExprClosure {
+  auto l = close_expr(node->left.get());
+  auto r = close_expr(node->right.get());
+  switch (node->op.type) {
+    case TokenType::AND:
+      return [l = std::move(l), r = std::move(r)] {
+        if (!l().truthy()) return make(false);
+        return make(r().truthy());
+      };
+    case TokenType::OR:
+      return [l = std::move(l), r = std::move(r)] {
+        if (l().truthy()) return make(true);
+        return make(r().truthy());
+      };
+    default: break;
+  }
+
+  if (node->operands == StaticType::INT || node->operands == StaticType::FLOAT) {
+    auto type = node->operands == StaticType::INT ? ValueType::INT : ValueType::FLOAT;
+    if (auto fn = specialize_binary(node->op.type, type, type))
+      return [fn, l = std::move(l), r = std::move(r)] {
+        auto lv = l();
+        auto rv = r();
+        return fn(lv, rv);
+      };
+  }
+  return [node, l = std::move(l), r = std::move(r)] {
+    auto lv = l();
+    auto rv = r();
+    return apply_binary(node, lv, rv);
+  };
+}
+
+auto Interpreter::close_call(const FunctionCall* node) -> ExprClosure {
+  return [this, node, args = close_args(node->exprs)] {
+    // By value: evaluating the arguments may rebind names.
+    const auto target = resolve_call(node);
+    if (target.kind == CallTarget::Kind::INDEX) {
+      auto arr = args[0]();
+      auto idx = args[1]();
+      return index_call(arr, idx);
+    }
+    return with_args(_values, args, [&](std::span<Value> values) { return call_target(target, values); });
+  };
+}
+
+auto Interpreter::close_method_call(const MethodCall* node) -> ExprClosure {
+  return [this, node, obj = close_expr(node->object.get()), args = close_args(node->args)] {
+    auto recv  = obj();
+    auto entry = method_entry(recv, node);
+    return with_args(_values, args, [&](std::span<Value> values) { return call_method(entry, recv, values); });
+  };
+}
+
+auto Interpreter::close_args(const ExprsPtr& args) -> std::vector<ExprClosure> {
+  std::vector<ExprClosure> out;
+  out.reserve(args.size());
+  for (const auto& a : args)
+    out.push_back(close_expr(a.get()));
+  return out;
+}
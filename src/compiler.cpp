@@ -0,0 +1,593 @@
+#include "compiler.h"
+#include <format>
+#include <limits>
+#include <string>
+#include <variant>
+#include "builtins.h"
+#include "error_manager.h"
+#include "nodes.h"
+#include "std.h"
+using enum NodeType;
+
+auto Compiler::compile(const StmtsPtr& program) -> Program {
+  _program = {};
+  _function_ids.clear();
+  _class_ids.clear();
+  _global_ids.clear();
+  _name_ids.clear();
+  _decl_functions.clear();
+  _decl_classes.clear();
+  _program.script.name = "<script>";
+  _state   = {.fn = &_program.script};
+
+  // Functions and classes get their indices up front so calls can be
+  // resolved no matter where the declaration sits.
+  declare(program, Function::TOP_LEVEL);
+
+  compile_stmts(program);
+  emit(OpCode::HALT);
+  _program.script.num_locals = _state.max_locals;
+  return std::move(_program);
+}
+
+auto Compiler::declare(const StmtsPtr& stmts, std::size_t enclosing) -> void {
+  for (const auto& s : stmts) {
+    if (!s) continue;
+    switch (s->node_type) {
+      case FUNCTIONDECL: {
+        auto* fn = static_cast<const FunctionDecl*>(s.get());
+        auto  id = declare_function(fn, enclosing);
+        if (enclosing == Function::TOP_LEVEL)
+          _function_ids[fn->id] = static_cast<uint16_t>(id);
+        declare(fn->body, id);
+        break;
+      }
+      case CLASSDECL:
+        declare_class(static_cast<const ClassDecl*>(s.get()), enclosing);
+        break;
+      case IFSTATEMENT: {
+        auto* node = static_cast<const IfStatement*>(s.get());
+        while (node) {
+          declare(node->then_body, enclosing);
+          if (auto* els = std::get_if<StmtsPtr>(&node->next)) {
+            declare(*els, enclosing);
+            break;
+          }
+          auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&node->next);
+          node = elif ? elif->get() : nullptr;
+        }
+        break;
+      }
+      case WHILESTATEMENT:
+        declare(static_cast<const WhileStatement*>(s.get())->body, enclosing);
+        break;
+      default: break;
+    }
+  }
+}
+
+auto Compiler::declare_function(const FunctionDecl* node, std::size_t enclosing) -> std::size_t {
+  if (_program.functions.size() > std::numeric_limits<uint16_t>::max())
+    throw RuntimeError("demasiadas funciones en el programa");
+  _program.functions.push_back({.name = node->id, .arity = node->params.size(), .enclosing = enclosing});
+  _decl_functions[node] = _program.functions.size() - 1;
+  return _program.functions.size() - 1;
+}
+
+auto Compiler::declare_class(const ClassDecl* node, std::size_t enclosing) -> void {
+  auto def  = std::make_shared<ClassDef>();
+  def->name = node->id;
+  def->id   = _program.classes.size();
+  def->decl = node;
+
+  CompiledClass klass{.def = def};
+  std::size_t ctor_arity = 0;
+
+  for (const auto& m : node->members) {
+    if (m->node_type == VARIABLEDECL) {
+      auto* vd = static_cast<const VariableDecl*>(m.get());
+      def->add_field(intern(vd->id), vd->expr.get());
+    } else if (m->node_type == FUNCTIONDECL) {
+      auto* fn = static_cast<const FunctionDecl*>(m.get());
+      def->methods[fn->id] = fn;
+      auto id = declare_function(fn, enclosing);
+      klass.methods[name_id(fn->id)] = id;
+      _program.functions.back().name = node->id + "." + fn->id;
+      if (fn->id == "crear") {
+        klass.has_ctor = true;
+        ctor_arity     = fn->params.size();
+      }
+      declare(fn->body, id);
+    }
+  }
+
+  _program.functions.push_back({.name = node->id, .arity = ctor_arity, .enclosing = enclosing});
+  klass.init = _program.functions.size() - 1;
+
+  _decl_classes[node] = _program.classes.size();
+  if (enclosing == Function::TOP_LEVEL)
+    _class_ids[node->id] = static_cast<uint16_t>(_program.classes.size());
+  _program.classes.push_back(std::move(klass));
+}
+
+auto Compiler::chunk() -> Chunk& { return _state.fn->chunk; }
+
+auto Compiler::emit(OpCode op) -> void { chunk().emit(op); }
+
+auto Compiler::emit(OpCode op, uint16_t operand) -> void {
+  chunk().emit(op);
+  chunk().emit_u16(operand);
+}
+
+auto Compiler::emit_jump(OpCode op) -> std::size_t {
+  emit(op, 0xffff);
+  return chunk().code.size() - 2;
+}
+
+auto Compiler::patch_jump(std::size_t at) -> void {
+  auto offset = chunk().code.size() - (at + 2);
+  if (offset > std::numeric_limits<uint16_t>::max())
+    throw RuntimeError("salto demasiado largo");
+  chunk().patch_u16(at, static_cast<uint16_t>(offset));
+}
+
+auto Compiler::emit_loop(std::size_t start) -> void {
+  auto offset = chunk().code.size() + 3 - start;
+  if (offset > std::numeric_limits<uint16_t>::max())
+    throw RuntimeError("cuerpo de bucle demasiado largo");
+  emit(OpCode::LOOP, static_cast<uint16_t>(offset));
+}
+
+auto Compiler::emit_constant(Value v) -> void {
+  emit(OpCode::CONSTANT, chunk().add_constant(std::move(v)));
+}
+
+auto Compiler::begin_scope() -> void { ++_state.scope_depth; }
+
+auto Compiler::end_scope() -> void {
+  --_state.scope_depth;
+  while (!_state.locals.empty() && _state.locals.back().depth > _state.scope_depth)
+    _state.locals.pop_back();
+}
+
+auto Compiler::add_local(std::string_view name) -> uint16_t {
+  for (auto it = _state.locals.rbegin(); it != _state.locals.rend() && it->depth == _state.scope_depth; ++it)
+    if (!name.empty() && it->name == name)
+      return it->slot;
+
+  if (_state.locals.size() > std::numeric_limits<uint16_t>::max())
+    throw RuntimeError("demasiadas variables locales");
+  auto slot = static_cast<uint16_t>(_state.locals.size());
+  _state.locals.push_back({name, _state.scope_depth, slot});
+  _state.max_locals = std::max(_state.max_locals, _state.locals.size());
+  return slot;
+}
+
+auto Compiler::find_local(std::string_view name) const -> int {
+  for (auto it = _state.locals.rbegin(); it != _state.locals.rend(); ++it)
+    if (it->name == name) return it->slot;
+  return -1;
+}
+
+auto Compiler::find_outer(std::string_view name) const -> std::optional<Outer> {
+  std::size_t hops = 0;
+  for (const auto* state = _state.enclosing; state; state = state->enclosing) {
+    ++hops;
+    for (auto it = state->locals.rbegin(); it != state->locals.rend(); ++it) {
+      if (it->name != name) continue;
+      if (hops > std::numeric_limits<uint8_t>::max())
+        throw RuntimeError("demasiadas funciones anidadas");
+      return Outer{.slot = it->slot, .hops = static_cast<uint8_t>(hops)};
+    }
+  }
+  return std::nullopt;
+}
+
+auto Compiler::global_id(std::string_view name) -> uint16_t {
+  if (auto it = _global_ids.find(name); it != _global_ids.end())
+    return it->second;
+  if (_program.globals.size() > std::numeric_limits<uint16_t>::max())
+    throw RuntimeError("demasiadas variables globales");
+  _program.globals.emplace_back(name);
+  auto id = static_cast<uint16_t>(_program.globals.size() - 1);
+  _global_ids.emplace(name, id);
+  return id;
+}
+
+auto Compiler::name_id(std::string_view name) -> uint16_t {
+  if (auto it = _name_ids.find(std::string(name)); it != _name_ids.end())
+    return it->second;
+  _program.names.push_back(intern(name));
+  auto id = static_cast<uint16_t>(_program.names.size() - 1);
+  _name_ids.emplace(std::string(name), id);
+  return id;
+}
+
+auto Compiler::emit_load(std::string_view name) -> void {
+  if (name == "este")
+    return emit(OpCode::GET_SELF);
+  if (auto slot = find_local(name); slot >= 0)
+    return emit(OpCode::GET_LOCAL, static_cast<uint16_t>(slot));
+  if (auto outer = find_outer(name)) {
+    emit(OpCode::GET_OUTER, outer->slot);
+    return chunk().emit_u8(outer->hops);
+  }
+  emit(OpCode::GET_GLOBAL, global_id(name));
+}
+
+auto Compiler::emit_store(std::string_view name) -> void {
+  if (auto slot = find_local(name); slot >= 0)
+    return emit(OpCode::SET_LOCAL, static_cast<uint16_t>(slot));
+  if (auto outer = find_outer(name)) {
+    emit(OpCode::SET_OUTER, outer->slot);
+    return chunk().emit_u8(outer->hops);
+  }
+  emit(OpCode::SET_GLOBAL, global_id(name));
+}
+
+auto Compiler::emit_append(std::string_view name, uint8_t count) -> void {
+  if (auto slot = find_local(name); slot >= 0)
+    emit(OpCode::APPEND_LOCAL, static_cast<uint16_t>(slot));
+  else
+    emit(OpCode::APPEND_GLOBAL, global_id(name));
+  chunk().emit_u8(count);
+}
+
+auto Compiler::compile_function(const FunctionDecl* node, std::size_t index) -> void {
+  auto saved = std::move(_state);
+  _state = {.fn = &_program.functions[index], .index = index, .enclosing = &saved, .scope_depth = 1};
+
+  for (const auto& p : node->params)
+    add_local(p);
+
+  compile_stmts(node->body);
+  emit(OpCode::PUSH_NIL);
+  emit(OpCode::RETURN);
+
+  _state.fn->num_locals = _state.max_locals;
+  _state = std::move(saved);
+}
+
+auto Compiler::compile_class(const ClassDecl* node) -> void {
+  const auto& klass = _program.classes[_decl_classes.at(node)];
+
+  for (const auto& m : node->members)
+    if (m->node_type == FUNCTIONDECL) {
+      auto* fn = static_cast<const FunctionDecl*>(m.get());
+      compile_function(fn, _decl_functions.at(fn));
+    }
+
+  compile_initializer(node, klass);
+}
+
+// Field initializers see 'este' and whatever encloses the class; the
+// constructor arguments sit in unnamed slots and are forwarded to 'crear'.
+auto Compiler::compile_initializer(const ClassDecl* node, const CompiledClass& klass) -> void {
+  auto saved = std::move(_state);
+  auto& fn   = _program.functions[klass.init];
+  _state = {.fn = &fn, .index = klass.init, .enclosing = &saved, .scope_depth = 1};
+
+  for (auto i{0uz}; i < fn.arity; i++)
+    add_local("");
+
+  for (const auto& m : node->members) {
+    if (m->node_type != VARIABLEDECL) continue;
+    auto* vd = static_cast<const VariableDecl*>(m.get());
+    compile_expr(vd->expr.get());
+    emit(OpCode::GET_SELF);
+    emit(OpCode::SET_FIELD, name_id(vd->id));
+  }
+
+  if (klass.has_ctor) {
+    emit(OpCode::GET_SELF);
+    for (auto i{0uz}; i < fn.arity; i++)
+      emit(OpCode::GET_LOCAL, static_cast<uint16_t>(i));
+    emit(OpCode::INVOKE, name_id("crear"));
+    chunk().emit_u8(static_cast<uint8_t>(fn.arity));
+    emit(OpCode::POP);
+  }
+  emit(OpCode::GET_SELF);
+  emit(OpCode::RETURN);
+
+  fn.num_locals = _state.max_locals;
+  _state = std::move(saved);
+}
+
+auto Compiler::compile_stmts(const StmtsPtr& stmts) -> void {
+  for (const auto& s : stmts)
+    compile_stmt(s.get());
+}
+
+auto Compiler::compile_stmt(const IAST* node) -> void {
+  if (!node)
+    return;
+  switch (node->node_type) {
+    case VARIABLEDECL:    compile_var_decl  (static_cast<const VariableDecl*>     (node)); break;
+    case FUNCTIONDECL: {
+      auto* fn = static_cast<const FunctionDecl*>(node);
+      compile_function(fn, _decl_functions.at(fn));
+      break;
+    }
+    case CLASSDECL:       compile_class     (static_cast<const ClassDecl*>        (node)); break;
+    case ASSIGNMENT:      compile_assignment(static_cast<const Assignment*>       (node)); break;
+    case IFSTATEMENT:     compile_if        (static_cast<const IfStatement*>      (node)); break;
+    case WHILESTATEMENT:  compile_while     (static_cast<const WhileStatement*>   (node)); break;
+    case RETURNSTATEMENT: compile_return    (static_cast<const ReturnStatement*>  (node)); break;
+    case CONTINUESTMT:    compile_continue  (static_cast<const ContinueStatement*>(node)); break;
+    case FUNCTIONCALL:
+    case METHODCALL:
+      compile_expr(node);
+      emit(OpCode::POP);
+      break;
+    default:
+      throw RuntimeError("nodo de declaracion desconocido");
+  }
+}
+
+auto Compiler::compile_var_decl(const VariableDecl* node) -> void {
+  compile_expr(node->expr.get());
+  if (_state.scope_depth == 0)
+    emit(OpCode::DEFINE_GLOBAL, global_id(node->id));
+  else
+    emit(OpCode::SET_LOCAL, add_local(node->id));
+}
+
+auto Compiler::compile_assignment(const Assignment* node) -> void {
+  // 'x se x + a + b ...': only the addends go on the stack, so x's string
+  // is not copied there and stays free to grow in place. Locals of an
+  // enclosing function take the plain path.
+  auto* target = static_cast<const Literal*>(node->target.get());
+  if (node->appends && static_cast<const BinaryOp*>(node->expr.get())->operands == StaticType::UNKNOWN &&
+      (find_local(target->token.literal) >= 0 || !find_outer(target->token.literal))) {
+    const IAST* addends[Assignment::MAX_APPENDS];
+    const IAST* expr = node->expr.get();
+    for (auto i = node->appends; i-- > 0;) {
+      auto* sum  = static_cast<const BinaryOp*>(expr);
+      addends[i] = sum->right.get();
+      expr       = sum->left.get();
+    }
+    for (auto i {0uz}; i < node->appends; ++i)
+      compile_expr(addends[i]);
+    return emit_append(target->token.literal, node->appends);
+  }
+
+  compile_expr(node->expr.get());
+
+  if (node->target->node_type == LITERAL) {
+    auto* lit = static_cast<const Literal*>(node->target.get());
+    return emit_store(lit->token.literal);
+  }
+  if (node->target->node_type == MEMBERACCESS) {
+    auto* member = static_cast<const MemberAccess*>(node->target.get());
+    compile_expr(member->object.get());
+    return emit(OpCode::SET_FIELD, name_id(*member->field));
+  }
+  if (node->target->node_type == INDEXEXPR) {
+    auto* idx = static_cast<const IndexExpr*>(node->target.get());
+    compile_expr(idx->object.get());
+    compile_expr(idx->index.get());
+    return emit(OpCode::SET_INDEX);
+  }
+  throw RuntimeError("asignacion a objetivo invalido");
+}
+
+auto Compiler::compile_if(const IfStatement* node) -> void {
+  compile_expr(node->condition.get());
+  auto else_jump = emit_jump(OpCode::JUMP_IF_FALSE);
+
+  begin_scope();
+  compile_stmts(node->then_body);
+  end_scope();
+
+  if (std::holds_alternative<std::monostate>(node->next))
+    return patch_jump(else_jump);
+
+  auto end_jump = emit_jump(OpCode::JUMP);
+  patch_jump(else_jump);
+
+  if (auto* els = std::get_if<StmtsPtr>(&node->next)) {
+    begin_scope();
+    compile_stmts(*els);
+    end_scope();
+  } else {
+    compile_if(std::get<std::unique_ptr<IfStatement>>(node->next).get());
+  }
+  patch_jump(end_jump);
+}
+
+auto Compiler::compile_while(const WhileStatement* node) -> void {
+  auto start = chunk().code.size();
+  compile_expr(node->condition.get());
+  auto exit_jump = emit_jump(OpCode::JUMP_IF_FALSE);
+
+  _state.loop_starts.push_back(start);
+  begin_scope();
+  compile_stmts(node->body);
+  end_scope();
+  _state.loop_starts.pop_back();
+
+  emit_loop(start);
+  patch_jump(exit_jump);
+}
+
+auto Compiler::compile_return(const ReturnStatement* node) -> void {
+  // A function nested in this one needs this frame as its static link,
+  // so it cannot replace it.
+  if (node->tail_call) {
+    auto* call = static_cast<const FunctionCall*>(node->expr.get());
+    if (auto id = user_function(call); id && _program.functions[*id].enclosing != _state.index) {
+      auto argc = compile_args(call->exprs);
+      emit(OpCode::TAIL_CALL, *id);
+      return chunk().emit_u8(argc);
+    }
+  }
+  compile_expr(node->expr.get());
+  emit(OpCode::RETURN);
+}
+
+auto Compiler::compile_continue(const ContinueStatement*) -> void {
+  if (_state.loop_starts.empty())
+    throw RuntimeError("'continuar' usado fuera de un bucle");
+  emit_loop(_state.loop_starts.back());
+}
+
+auto Compiler::compile_expr(const IAST* node) -> void {
+  if (!node)
+    return emit(OpCode::PUSH_NIL);
+  switch (node->node_type) {
+    case LITERAL:      compile_literal    (static_cast<const Literal*>     (node)); break;
+    case BINARYOP:     compile_binary     (static_cast<const BinaryOp*>    (node)); break;
+    case UNARYOP:      compile_unary      (static_cast<const UnaryOp*>     (node)); break;
+    case FUNCTIONCALL: compile_call       (static_cast<const FunctionCall*>(node)); break;
+    case ARRAYDECL:    compile_array      (static_cast<const ArrayDecl*>   (node)); break;
+    case METHODCALL:   compile_method_call(static_cast<const MethodCall*>  (node)); break;
+    case INDEXEXPR:    compile_index      (static_cast<const IndexExpr*>   (node)); break;
+    case MEMBERACCESS: {
+      auto* member = static_cast<const MemberAccess*>(node);
+      compile_expr(member->object.get());
+      emit(OpCode::GET_FIELD, name_id(*member->field));
+      break;
+    }
+    default:
+      throw RuntimeError("nodo de expresion desconocido");
+  }
+}
+
+auto Compiler::compile_literal(const Literal* node) -> void {
+  const auto& lit = node->token.literal;
+  switch (node->token.type) {
+    case TokenType::INTEGER:
+    case TokenType::FLOAT:
+    case TokenType::STRING:  return emit_constant(node->value);
+    case TokenType::BOOL:    return emit(lit == "verdadero" ? OpCode::PUSH_TRUE : OpCode::PUSH_FALSE);
+    case TokenType::NIL:     return emit(OpCode::PUSH_NIL);
+    case TokenType::SELF:    return emit(OpCode::GET_SELF);
+    case TokenType::IDENTIFIER: return emit_load(lit);
+    default:
+      throw RuntimeError(std::format("literal desconocido '{}'", lit));
+  }
+}
+
+auto Compiler::compile_binary(const BinaryOp* node) -> void {
+  using enum TokenType;
+  auto type = node->op.type;
+
+  if (type == AND || type == OR) {
+    compile_expr(node->left.get());
+    auto short_jump = emit_jump(type == AND ? OpCode::JUMP_IF_FALSE : OpCode::JUMP_IF_TRUE);
+    compile_expr(node->right.get());
+    emit(OpCode::TO_BOOL);
+    auto end_jump = emit_jump(OpCode::JUMP);
+    patch_jump(short_jump);
+    emit(type == AND ? OpCode::PUSH_FALSE : OpCode::PUSH_TRUE);
+    return patch_jump(end_jump);
+  }
+
+  compile_expr(node->left.get());
+  compile_expr(node->right.get());
+  switch (type) {
+    case PLUS:             return emit(OpCode::ADD);
+    case MINUS:            return emit(OpCode::SUB);
+    case STAR:             return emit(OpCode::MUL);
+    case SLASH:            return emit(OpCode::DIV);
+    case EQUAL:            return emit(OpCode::EQUAL);
+    case NOT_EQUAL:        return emit(OpCode::NOT_EQUAL);
+    case LESSER_THAN:      return emit(OpCode::LESS);
+    case GREATER_THAN:     return emit(OpCode::GREATER);
+    case LESSER_OR_EQUAL:  return emit(OpCode::LESS_EQUAL);
+    case GREATER_OR_EQUAL: return emit(OpCode::GREATER_EQUAL);
+    default:
+      throw RuntimeError(std::format("operador binario desconocido '{}'", node->op.literal));
+  }
+}
+
+auto Compiler::compile_unary(const UnaryOp* node) -> void {
+  compile_expr(node->operand.get());
+  switch (node->op) {
+    case TokenType::MINUS: return emit(OpCode::NEGATE);
+    case TokenType::BANG:  return emit(OpCode::NOT);
+    default:
+      throw RuntimeError("operador unario desconocido");
+  }
+}
+
+auto Compiler::compile_args(const ExprsPtr& args) -> uint8_t {
+  if (args.size() > std::numeric_limits<uint8_t>::max())
+    throw RuntimeError("demasiados argumentos");
+  for (const auto& a : args)
+    compile_expr(a.get());
+  return static_cast<uint8_t>(args.size());
+}
+
+auto Compiler::compile_call(const FunctionCall* node) -> void {
+  if (node->id == "__index__") {
+    compile_expr(node->exprs[0].get());
+    compile_expr(node->exprs[1].get());
+    return emit(OpCode::GET_INDEX);
+  }
+
+  if (auto* desc = find_builtin(FREE_FUNCTIONS, node->id)) {
+    auto argc = compile_args(node->exprs);
+    emit(OpCode::CALL_BUILTIN, static_cast<uint16_t>(desc - FREE_FUNCTIONS));
+    return chunk().emit_u8(argc);
+  }
+
+  if (auto id = user_class(node)) {
+    auto argc = compile_args(node->exprs);
+    emit(OpCode::NEW, *id);
+    return chunk().emit_u8(argc);
+  }
+
+  auto id = user_function(node);
+  if (!id)
+    throw RuntimeError(std::format("funcion '{}' no definida", node->id));
+
+  auto argc = compile_args(node->exprs);
+  emit(OpCode::CALL, *id);
+  chunk().emit_u8(argc);
+}
+
+// Class a call instantiates, unless a builtin takes its name.
+auto Compiler::user_class(const FunctionCall* node) const -> std::optional<uint16_t> {
+  if (node->id == "__index__" || find_builtin(FREE_FUNCTIONS, node->id))
+    return std::nullopt;
+  if (node->decl)
+    return node->decl->node_type == CLASSDECL
+      ? std::optional{static_cast<uint16_t>(_decl_classes.at(static_cast<const ClassDecl*>(node->decl)))}
+      : std::nullopt;
+  if (auto it = _class_ids.find(node->id); it != _class_ids.end())
+    return it->second;
+  return std::nullopt;
+}
+
+// Function a call reaches, unless a builtin or a class takes it.
+auto Compiler::user_function(const FunctionCall* node) const -> std::optional<uint16_t> {
+  if (node->id == "__index__" || find_builtin(FREE_FUNCTIONS, node->id) || user_class(node))
+    return std::nullopt;
+  if (node->decl && node->decl->node_type == FUNCTIONDECL)
+    return static_cast<uint16_t>(_decl_functions.at(static_cast<const FunctionDecl*>(node->decl)));
+  if (auto it = _function_ids.find(node->id); it != _function_ids.end())
+    return it->second;
+  return std::nullopt;
+}
+
+auto Compiler::compile_method_call(const MethodCall* node) -> void {
+  compile_expr(node->object.get());
+  auto argc = compile_args(node->args);
+  emit(OpCode::INVOKE, name_id(node->name));
+  chunk().emit_u8(argc);
+}
+
+auto Compiler::compile_array(const ArrayDecl* node) -> void {
+  if (node->data.size() > std::numeric_limits<uint16_t>::max())
+    throw RuntimeError("arreglo literal demasiado grande");
+  for (const auto& el : node->data)
+    compile_expr(el.get());
+  emit(OpCode::ARRAY, static_cast<uint16_t>(node->data.size()));
+}
+
+auto Compiler::compile_index(const IndexExpr* node) -> void {
+  compile_expr(node->object.get());
+  compile_expr(node->index.get());
+  emit(OpCode::GET_INDEX);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.h"
+#include "nodes.h"
+
+// Lowers an analyzed program into bytecode for the VM.
+// Top-level variables become globals, everything else (parameters, block
+// variables, top-level block variables) gets a fixed slot in its frame.
+// A nested function reads its enclosing functions' locals through the
+// static link of its frame (see Function::enclosing). Calls go to the
+// declaration Sema resolved them to (FunctionCall::decl); only top-level
+// declarations are also found by name, for trees Sema has not seen.
+class Compiler final {
+public:
+  auto compile(const StmtsPtr& program) -> Program;
+
+private:
+  struct Local final {
+    std::string_view name{};
+    std::size_t      depth{};
+    uint16_t         slot{};
+  };
+
+  struct FunctionState final {
+    Function*                fn{};
+    std::size_t              index{Function::TOP_LEVEL};  // of fn in Program::functions
+    const FunctionState*     enclosing{};                 // state of the function fn is nested in
+    std::vector<Local>       locals{};
+    std::size_t              scope_depth{};
+    std::size_t              max_locals{};
+    std::vector<std::size_t> loop_starts{};
+  };
+
+  // A local of an enclosing function: its slot and how many static links
+  // lead to its frame.
+  struct Outer final {
+    uint16_t slot{};
+    uint8_t  hops{};
+  };
+
+  Program       _program{};
+  FunctionState _state{};
+
+  std::unordered_map<std::string_view, uint16_t>  _function_ids{};
+  std::unordered_map<std::string_view, uint16_t>  _class_ids{};
+  std::unordered_map<std::string_view, uint16_t>  _global_ids{};
+  std::unordered_map<std::string, uint16_t>       _name_ids{};
+  std::unordered_map<const FunctionDecl*, std::size_t> _decl_functions{};
+  std::unordered_map<const ClassDecl*, std::size_t>    _decl_classes{};
+
+  auto declare(const StmtsPtr& stmts, std::size_t enclosing)               -> void;
+  auto declare_function(const FunctionDecl* node, std::size_t enclosing)   -> std::size_t;
+  auto declare_class(const ClassDecl* node, std::size_t enclosing)         -> void;
+
+  auto chunk()                                      -> Chunk&;
+  auto emit(OpCode op)                              -> void;
+  auto emit(OpCode op, uint16_t operand)            -> void;
+  auto emit_jump(OpCode op)                         -> std::size_t;
+  auto patch_jump(std::size_t at)                   -> void;
+  auto emit_loop(std::size_t start)                 -> void;
+  auto emit_constant(Value v)                       -> void;
+
+  auto begin_scope()                                -> void;
+  auto end_scope()                                  -> void;
+  auto add_local(std::string_view name)             -> uint16_t;
+  auto find_local(std::string_view name) const      -> int;
+  auto find_outer(std::string_view name) const      -> std::optional<Outer>;
+  auto global_id(std::string_view name)             -> uint16_t;
+  auto name_id(std::string_view name)               -> uint16_t;
+
+  auto emit_load(std::string_view name)             -> void;
+  auto emit_store(std::string_view name)            -> void;
+  auto emit_append(std::string_view name, uint8_t count) -> void;
+
+  auto compile_function(const FunctionDecl* node, std::size_t index) -> void;
+  auto compile_class(const ClassDecl* node)         -> void;
+  auto compile_initializer(const ClassDecl* node, const CompiledClass& klass) -> void;
+
+  auto compile_stmts(const StmtsPtr& stmts)         -> void;
+  auto compile_stmt(const IAST* node)               -> void;
+  auto compile_var_decl(const VariableDecl* node)   -> void;
+  auto compile_assignment(const Assignment* node)   -> void;
+  auto compile_if(const IfStatement* node)          -> void;
+  auto compile_while(const WhileStatement* node)    -> void;
+  auto compile_return(const ReturnStatement* node)  -> void;
+  auto compile_continue(const ContinueStatement*)   -> void;
+
+  auto compile_expr(const IAST* node)               -> void;
+  auto compile_literal(const Literal* node)         -> void;
+  auto compile_binary(const BinaryOp* node)         -> void;
+  auto compile_unary(const UnaryOp* node)           -> void;
+  auto compile_call(const FunctionCall* node)       -> void;
+  auto compile_method_call(const MethodCall* node)  -> void;
+  auto compile_array(const ArrayDecl* node)         -> void;
+  auto compile_index(const IndexExpr* node)         -> void;
+  auto compile_args(const ExprsPtr& args)           -> uint8_t;
+  auto user_function(const FunctionCall* node) const -> std::optional<uint16_t>;
+  auto user_class(const FunctionCall* node) const    -> std::optional<uint16_t>;
+};
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <format>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -58,3 +60,14 @@ struct RuntimeError final : std::runtime_error {
     std::runtime_error("error de tiempo de ejecución: " + msg) {}
 };
 
+// Calls a program may nest before it fails with stack_overflow, unless
+// 'olm --pila-max' says otherwise.
+inline constexpr std::size_t DEFAULT_MAX_DEPTH = 100'000;
+// Highest '--pila-max': the tree walker reserves about 2 KB of native
+// stack per call, so this is a stack of some 2 GB.
+inline constexpr std::size_t MAX_MAX_DEPTH = 1'000'000;
+
+inline auto stack_overflow(std::size_t max_depth) -> RuntimeError {
+  return RuntimeError(std::format("desbordamiento de pila: mas de {} llamadas anidadas (ver --pila-max)", max_depth));
+}
+
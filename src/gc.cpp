@@ -0,0 +1,87 @@
+#include "gc.h"
+#include <algorithm>
+
+GcNode::GcNode() {
+  Collector::instance().link(this);
+}
+
+GcNode::~GcNode() {
+  Collector::instance().unlink(this);
+}
+
+auto Collector::instance() -> Collector& {
+  static auto* collector = new Collector;
+  return *collector;
+}
+
+// Collecting before the new node is linked: nothing of it is built yet.
+auto Collector::link(GcNode* node) -> void {
+  if (!_collecting && _live >= _threshold)
+    collect();
+  node->_next = _head;
+  if (_head) _head->_prev = node;
+  _head = node;
+  ++_live;
+}
+
+auto Collector::unlink(GcNode* node) -> void {
+  if (node->_prev) node->_prev->_next = node->_next;
+  else             _head = node->_next;
+  if (node->_next) node->_next->_prev = node->_prev;
+  --_live;
+}
+
+auto Collector::collect() -> void {
+  auto start  = std::chrono::steady_clock::now();
+  _collecting = true;
+
+  std::vector<GcNode*> children;
+  for (auto* n = _head; n; n = n->_next)
+    n->_count = n->gc_refs();
+  for (auto* n = _head; n; n = n->_next) {
+    children.clear();
+    n->gc_children(children);
+    for (auto* c : children) --c->_count;
+  }
+
+  _work.clear();
+  for (auto* n = _head; n; n = n->_next)
+    if (n->_count > 0) {
+      n->_marked = true;
+      _work.push_back(n);
+    }
+  while (!_work.empty()) {
+    auto* n = _work.back();
+    _work.pop_back();
+    children.clear();
+    n->gc_children(children);
+    for (auto* c : children)
+      if (!c->_marked) {
+        c->_marked = true;
+        _work.push_back(c);
+      }
+  }
+
+  std::vector<GcNode*> garbage;
+  for (auto* n = _head; n; n = n->_next) {
+    if (!n->_marked) garbage.push_back(n);
+    n->_marked = false;
+  }
+  std::size_t bytes = 0;
+  for (auto* g : garbage) {
+    g->gc_retain();
+    bytes += g->gc_bytes();
+  }
+  for (auto* g : garbage) g->gc_clear();
+  for (auto* g : garbage) g->gc_release();
+
+  _collecting = false;
+  _threshold  = std::max(MIN_THRESHOLD, 2 * _live);
+
+  auto pause = std::chrono::steady_clock::now() - start;
+  ++_stats.collections;
+  _stats.reclaimed_objects += garbage.size();
+  _stats.reclaimed_bytes   += bytes;
+  _stats.total_pause       += pause;
+  _stats.max_pause          = std::max<std::chrono::nanoseconds>(_stats.max_pause, pause);
+}
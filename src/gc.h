@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reference counting frees everything except cycles (an instance whose
+// field holds 'este', two nodes of a linked list pointing at each other).
+// The Collector finds those. Every object that can hold Values (arrays,
+// instances) is a GcNode on one list, and a collection:
+//   1. starts each node's count at its reference count and subtracts the
+//      references other nodes hold, leaving the ones from outside the
+//      heap: frames, globals, the ASTs the REPL keeps, C++ locals;
+//   2. marks every node with such a reference and whatever it reaches;
+//   3. sweeps the rest: each is kept alive while all of them are emptied,
+//      which breaks the cycles, and then released.
+// Roots are never enumerated, so a collection is safe at any allocation.
+// It runs when the traced objects outnumber twice the survivors of the
+// previous one (at least MIN_THRESHOLD).
+class GcNode {
+public:
+  GcNode();
+  virtual ~GcNode();
+  GcNode(const GcNode&)                    = delete;
+  auto operator=(const GcNode&) -> GcNode& = delete;
+
+  virtual auto gc_refs() const                          -> uint32_t    = 0;
+  virtual auto gc_children(std::vector<GcNode*>& out)   -> void        = 0;
+  virtual auto gc_clear()                               -> void        = 0;  // drops every Value held
+  virtual auto gc_bytes() const                         -> std::size_t = 0;
+  virtual auto gc_retain()                              -> void        = 0;
+  virtual auto gc_release()                             -> void        = 0;
+
+private:
+  friend class Collector;
+  GcNode*  _prev{};
+  GcNode*  _next{};
+  uint32_t _count{};  // references from outside the traced heap, during a collection
+  bool     _marked{};
+};
+
+// Whether Ref<T> objects are GcNodes, and how to see into them.
+// Specialized in runtime_values.h.
+template <class T>
+struct GcTraits {
+  static constexpr bool traced = false;
+};
+
+struct GcStats final {
+  uint64_t                 collections{};
+  uint64_t                 reclaimed_objects{};
+  uint64_t                 reclaimed_bytes{};
+  std::chrono::nanoseconds total_pause{};
+  std::chrono::nanoseconds max_pause{};
+};
+
+class Collector final {
+public:
+  static constexpr std::size_t MIN_THRESHOLD = 10'000;
+
+  // Never destroyed, like the Pool.
+  static auto instance() -> Collector&;
+
+  auto collect() -> void;
+  auto stats() const -> const GcStats& { return _stats; }
+  auto live() const  -> std::size_t    { return _live; }
+
+private:
+  friend class GcNode;
+
+  GcNode*              _head{};
+  std::size_t          _live{};
+  std::size_t          _threshold{MIN_THRESHOLD};
+  bool                 _collecting{};
+  std::vector<GcNode*> _work{};
+  GcStats              _stats{};
+
+  Collector() = default;
+
+  auto link(GcNode* node)   -> void;
+  auto unlink(GcNode* node) -> void;
+};
@@ -1,181 +1,418 @@
 #include "interpreter.h"
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstdint>
+#include <exception>
 #include <format>
+#include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include "builtins.h"
 #include "nodes.h"
+#include "operators.h"
 #include "runtime_values.h"
 #include "error_manager.h"
 #include "std.h"
+#if __has_include(<pthread.h>)
+#include <pthread.h>
+#endif
 using enum NodeType;
 
-auto Environment::push() -> void { _scopes.emplace_back(); }
-auto Environment::pop()  -> void { assert(!_scopes.empty()); _scopes.pop_back(); }
+ValueStack::ValueStack() {
+  _chunks.push_back({.values = std::vector<Value>(CHUNK, make_unbound())});
+}
+
+auto ValueStack::push(std::size_t n) -> std::span<Value> {
+  if (_top + n > _chunks[_chunk].values.size()) {
+    _chunks[_chunk].used = _top;
+    ++_chunk;
+    // Chunks above the top hold nothing, so a short one can be replaced.
+    if (_chunk == _chunks.size())
+      _chunks.push_back({.values = std::vector<Value>(std::max(CHUNK, n), make_unbound())});
+    else if (_chunks[_chunk].values.size() < n)
+      _chunks[_chunk].values.assign(n, make_unbound());
+    _top = 0;
+  }
+  auto* base = _chunks[_chunk].values.data() + _top;
+  _top += n;
+  return {base, n};
+}
+
+auto ValueStack::frame(std::span<Value> args, std::size_t size) -> std::span<Value> {
+  auto& values = _chunks[_chunk].values;
+  if (!args.empty() && args.data() + args.size() == values.data() + _top
+      && _top + (size - args.size()) <= values.size()) {
+    _top += size - args.size();
+    return {args.data(), size};
+  }
+  auto slots = push(size);
+  std::ranges::move(args, slots.begin());
+  return slots;
+}
+
+auto ValueStack::release(Mark mark) -> void {
+  for (; _chunk > mark.chunk; --_chunk) {
+    std::fill_n(_chunks[_chunk].values.begin(), _top, make_unbound());
+    _top = _chunks[_chunk - 1].used;
+  }
+  std::fill(_chunks[_chunk].values.begin() + mark.top, _chunks[_chunk].values.begin() + _top, make_unbound());
+  _top = mark.top;
+}
+
+auto Environment::current() -> Frame& {
+  return _stack.empty() ? _global : *_stack.back();
+}
+
+auto Environment::frame_at(uint32_t depth) const -> const Frame& {
+  const Frame* f = _stack.empty() ? &_global : _stack.back();
+  for (; depth > 0; --depth)
+    f = f->parent ? f->parent : &_global;
+  return *f;
+}
+
+auto Environment::frame_at(uint32_t depth) -> Frame& {
+  return const_cast<Frame&>(std::as_const(*this).frame_at(depth));
+}
+
+auto Environment::define(const VarSlot& slot, Value val) -> void {
+  if (!slot.resolved())
+    throw RuntimeError("declaracion sin resolver, falta el analisis semantico");
+  auto& frame = current();
+  // Function frames are sized by Sema; only the globals keep growing.
+  if (&frame == &_global && slot.index >= _globals.size()) {
+    _globals.resize(slot.index + 1, make_unbound());
+    _global.slots = _globals;
+  }
+  frame.slots[slot.index] = std::move(val);
+}
 
-auto Environment::define(const std::string& name, ValuePtr val) -> void {
-  _scopes.back()[name] = std::move(val);
+auto Environment::get(const VarSlot& slot, std::string_view name) const -> Value {
+  return ref(slot, name);
 }
 
-auto Environment::get(const std::string& name) const -> ValuePtr {
-  for (auto it = _scopes.rbegin(); it != _scopes.rend(); ++it) {
-    if (auto found = it->find(name); found != it->end())
-      return found->second;
+auto Environment::ref(const VarSlot& slot, std::string_view name) const -> const Value& {
+  if (slot.resolved()) {
+    const auto& slots = frame_at(slot.depth).slots;
+    if (slot.index < slots.size() && !slots[slot.index].is_unbound())
+      return slots[slot.index];
   }
   throw RuntimeError(std::format("variable '{}' no definida", name));
 }
 
-auto Environment::set(const std::string& name, ValuePtr val) -> void {
-  for (auto it = _scopes.rbegin(); it != _scopes.rend(); ++it) {
-    if (auto found = it->find(name); found != it->end()) {
-      found->second = std::move(val);
+auto Environment::ref(const VarSlot& slot, std::string_view name) -> Value& {
+  return const_cast<Value&>(std::as_const(*this).ref(slot, name));
+}
+
+auto Environment::set(const VarSlot& slot, std::string_view name, Value val) -> void {
+  if (slot.resolved()) {
+    auto& slots = frame_at(slot.depth).slots;
+    if (slot.index < slots.size() && !slots[slot.index].is_unbound()) {
+      slots[slot.index] = std::move(val);
       return;
     }
   }
   throw RuntimeError(std::format("asignacion a variable no declarada '{}'", name));
 }
 
-auto Environment::has(const std::string& name) const -> bool {
-  for (auto it = _scopes.rbegin(); it != _scopes.rend(); ++it)
-    if (it->contains(name)) return true;
-  return false;
+auto Environment::self() const -> Value {
+  for (const Frame* f = _stack.empty() ? nullptr : _stack.back(); f; f = f->parent)
+    if (f->self.is_instance()) return f->self;
+  throw RuntimeError("'este' usado fuera de una clase o metodo");
+}
+
+auto Environment::owner() const -> const IAST* {
+  return _stack.empty() ? nullptr : _stack.back()->owner;
 }
 
+auto Environment::static_parent(const IAST* enclosing) -> Frame* {
+  if (!enclosing)
+    return nullptr;
+  for (auto it = _stack.rbegin(); it != _stack.rend(); ++it)
+    if ((*it)->owner == enclosing) return *it;
+  throw RuntimeError("funcion anidada llamada fuera de la funcion que la declara");
+}
+
+// A thread whose stack holds 'bytes', running one job at a time for the
+// thread that hands it over. Jobs get the usable stack size, or 0 when
+// they run on the calling thread because the platform has no way to ask
+// for one.
+class StackThread final {
+public:
+  using Job = std::function<void(std::size_t)>;
+
+  explicit StackThread(std::size_t bytes) : _bytes(bytes) {
+#if __has_include(<pthread.h>)
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, bytes);
+    auto started = pthread_create(&_thread, &attr, [](void* self) -> void* {
+      static_cast<StackThread*>(self)->serve();
+      return nullptr;
+    }, this);
+    pthread_attr_destroy(&attr);
+    if (started != 0)
+      throw RuntimeError(std::format("no se pudo reservar una pila de {} bytes (ver --pila-max)", bytes));
+#endif
+  }
+
+  ~StackThread() {
+#if __has_include(<pthread.h>)
+    {
+      std::lock_guard lock{_mutex};
+      _stopping = true;
+    }
+    _wake.notify_all();
+    pthread_join(_thread, nullptr);
+#endif
+  }
+
+  StackThread(const StackThread&)                    = delete;
+  auto operator=(const StackThread&) -> StackThread& = delete;
+
+  // Runs 'job' on the thread and rethrows what it threw.
+  auto run(const Job& job) -> void {
+#if __has_include(<pthread.h>)
+    std::unique_lock lock{_mutex};
+    _job   = &job;
+    _error = nullptr;
+    _wake.notify_all();
+    _wake.wait(lock, [&] { return !_job; });
+    if (_error)
+      std::rethrow_exception(std::exchange(_error, nullptr));
+#else
+    job(0);
+#endif
+  }
+
+private:
+  std::size_t             _bytes;
+  std::mutex              _mutex{};
+  std::condition_variable _wake{};
+  const Job*              _job{};
+  std::exception_ptr      _error{};
+  bool                    _stopping{};
+#if __has_include(<pthread.h>)
+  pthread_t               _thread{};
+#endif
+
+  auto serve() -> void {
+    std::unique_lock lock{_mutex};
+    while (true) {
+      _wake.wait(lock, [&] { return _job || _stopping; });
+      if (!_job) return;
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        (*_job)(_bytes);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      _error = std::move(error);
+      _job   = nullptr;
+      _wake.notify_all();
+    }
+  }
+};
+
 auto Interpreter::run(const StmtsPtr& program) -> void {
-  exec_stmts(program);
+  // Native code nests its own calls below the deepest interpreted one. The
+  // options may come from anywhere but main(), so the sizes are checked.
+  auto native = _jit.enabled() ? Jit::MAX_DEPTH * STACK_PER_CALL : 0;
+  std::size_t reach, bytes;
+  if (__builtin_mul_overflow(_options.max_depth, STACK_PER_CALL, &reach) ||
+      __builtin_add_overflow(reach, native + STACK_MARGIN, &bytes))
+    throw RuntimeError(std::format("no cabe una pila para {} llamadas anidadas (ver --pila-max)", _options.max_depth));
+  if (!_thread)
+    _thread = std::make_unique<StackThread>(bytes);
+  _thread->run([&](std::size_t usable) {
+    // Interpreted calls may go down to STACK_MARGIN / 2 above the native
+    // code's share at the bottom of the stack.
+    auto top = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    _stack_floor = usable ? top - (reach + STACK_MARGIN / 2) : 0;
+    auto flow = _options.closures ? close_stmts(program)() : exec_stmts(program);
+    if (flow == Flow::RETURN)
+      throw ReturnSignal{std::move(_return_value)};
+  });
 }
 
-auto Interpreter::exec_stmts(const StmtsPtr& stmts) -> void {
+// The native stack check backs up the count: a call nested inside a long
+// expression uses more than STACK_PER_CALL.
+Interpreter::CallDepth::CallDepth(Interpreter& interp) : _interp(interp) {
+  auto here = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+  if (_interp._depth >= _interp._options.max_depth || here < _interp._stack_floor)
+    throw stack_overflow(_interp._options.max_depth);
+  ++_interp._depth;
+}
+
+auto Interpreter::exec_stmts(const StmtsPtr& stmts) -> Flow {
   for (auto& s : stmts)
-    exec_stmt(s.get());
+    if (auto flow = exec_stmt(s.get()); flow != Flow::NORMAL)
+      return flow;
+  return Flow::NORMAL;
 }
 
-auto Interpreter::exec_stmt(const IAST* node) -> void {
+auto Interpreter::exec_stmt(const IAST* node) -> Flow {
   if (!node)
-    return;
+    return Flow::NORMAL;
   switch (node->node_type) {
     case VARIABLEDECL:    exec_var_decl  (static_cast<const VariableDecl*>  (node)); break;
     case FUNCTIONDECL:    exec_func_decl (static_cast<const FunctionDecl*>  (node)); break;
     case CLASSDECL:       exec_class_decl(static_cast<const ClassDecl*>     (node)); break;
     case ASSIGNMENT:      exec_assignment(static_cast<const Assignment*>    (node)); break;
-    case IFSTATEMENT:     exec_if        (static_cast<const IfStatement*>   (node)); break;
-    case WHILESTATEMENT:  exec_while     (static_cast<const WhileStatement*>(node)); break;
-    case RETURNSTATEMENT: exec_return    (static_cast<const ReturnStatement*>(node));break;
-    case CONTINUESTMT:    exec_continue  (static_cast<const ContinueStatement*>(node));break;
+    case IFSTATEMENT:     return exec_if      (static_cast<const IfStatement*>   (node));
+    case WHILESTATEMENT:  return exec_while   (static_cast<const WhileStatement*>(node));
+    case RETURNSTATEMENT: return exec_return  (static_cast<const ReturnStatement*>(node));
+    case CONTINUESTMT:    return exec_continue(static_cast<const ContinueStatement*>(node));
     case FUNCTIONCALL:    eval_call      (static_cast<const FunctionCall*>  (node)); break;
     case METHODCALL:      eval_method_call(static_cast<const MethodCall*>    (node)); break;
     default:
       throw RuntimeError("nodo de declaracion desconocido");
   }
+  return Flow::NORMAL;
 }
 
 
 auto Interpreter::exec_var_decl(const VariableDecl* node) -> void {
   auto val = eval(node->expr.get());
-  _env.define(node->id, std::move(val));
+  _env.define(node->slot, std::move(val));
 }
 
+// Names bind top-level declarations only. A nested one is reached through
+// the calls Sema resolved to it (FunctionCall::decl), so it never hides a
+// top-level function of the same name outside its enclosing function.
 auto Interpreter::exec_func_decl(const FunctionDecl* node) -> void {
-  _functions[node->id] = node;
-  _env.define(node->id, make_null());
+  if (!node->enclosing) {
+    auto [it, inserted] = _functions.try_emplace(node->id, node);
+    if (!inserted && it->second != node) {
+      it->second = node;
+      rebind();
+    }
+  }
+  if (node->slot.resolved())
+    _env.define(node->slot, make_null());
 }
 
 auto Interpreter::exec_class_decl(const ClassDecl* node) -> void {
   auto def = std::make_shared<ClassDef>();
   def->name = node->id;
+  def->decl = node;
 
   for (auto& m : node->members) {
     if (m->node_type == VARIABLEDECL) {
       auto* vd = static_cast<const VariableDecl*>(m.get());
-      def->fields.try_emplace(vd->id, vd->expr.get());
+      def->add_field(intern(vd->id), vd->expr.get());
     } else if (m->node_type == FUNCTIONDECL) {
       auto* fn = static_cast<const FunctionDecl*>(m.get());
       def->methods[fn->id] = fn;
     }
   }
 
-  _classes[node->id] = std::move(def);
-  _env.define(node->id, make_null()); // sentinel
+  if (node->enclosing) {  // see exec_func_decl
+    _nested_classes.insert_or_assign(node, std::move(def));
+    _env.define(node->slot, make_null());
+    return;
+  }
+
+  // Classes shadow functions of the same name, so either kind of clash
+  // changes what existing call sites mean.
+  auto [it, inserted] = _classes.try_emplace(node->id, def);
+  if (!inserted) {
+    if (it->second->decl != node) rebind();
+    it->second = std::move(def);
+  } else if (_functions.contains(node->id)) {
+    rebind();
+  }
+  _env.define(node->slot, make_null()); // sentinel
 }
 
 auto Interpreter::exec_assignment(const Assignment* node) -> void {
+  if (node->appends && append_in_place(node))
+    return;
   auto val = eval(node->expr.get());
 
   if (auto lit = dynamic_cast<const Literal*>(node->target.get())) {
-    const std::string& name = lit->token.literal;
-
-    auto dot = name.find('.');
-    if (dot == std::string::npos) {
-      _env.set(name, std::move(val));
-      return;
-    }
-    auto [inst, field] = resolve_member(name);
-    inst->fields[field] = std::move(val);
+    _env.set(lit->slot, lit->token.literal, std::move(val));
+    return;
+  }
+  if (auto member = dynamic_cast<const MemberAccess*>(node->target.get())) {
+    auto obj = eval(member->object.get());
+    assign_member(member, obj, std::move(val));
     return;
   }
   if (auto idx = dynamic_cast<const IndexExpr*>(node->target.get())) {
     auto obj = eval(idx->object.get());
     auto index = eval(idx->index.get());
-
-    if (!obj->is_array())
-      throw RuntimeError("solo se puede indexar arreglos");
-
-    else if (!index->is_int())
-      throw RuntimeError("indice debe ser entero");
-
-    auto& arr = obj->as_array();
-    auto i = index->as_int();
-
-    if (i < 0 || i >= (int64_t)arr.size())
-      throw RuntimeError("indice fuera de rango");
-
-    arr[i] = std::move(val);
+    assign_index(obj, index, std::move(val));
     return;
   }
   throw RuntimeError("asignacion a objetivo invalido");
 }
 
 
-auto Interpreter::exec_if(const IfStatement* node) -> void {
+auto Interpreter::exec_if(const IfStatement* node) -> Flow {
   auto cond = eval(node->condition.get());
-  if (cond->truthy()) { 
-    exec_stmts(node->then_body);
-    return;
-  }
+  if (cond.truthy())
+    return exec_stmts(node->then_body);
 
-  std::visit([this](const auto& next) {
+  return std::visit([this](const auto& next) {
     using T = std::decay_t<decltype(next)>;
     if constexpr (std::is_same_v<T, StmtsPtr>) {
-      exec_stmts(next);
+      return exec_stmts(next);
     } else if constexpr (std::is_same_v<T, std::unique_ptr<IfStatement>>) {
-      exec_if(next.get());
+      return exec_if(next.get());
+    } else {
+      return Flow::NORMAL;
     }
   }, node->next);
 }
 
-auto Interpreter::exec_while(const WhileStatement* node) -> void {
-  while (eval(node->condition.get())->truthy()) {
-    _env.push();
-    try {
-      exec_stmts(node->body);
-    } catch (ContinueSignal&){}
-    _env.pop();
+auto Interpreter::exec_while(const WhileStatement* node) -> Flow {
+  while (eval(node->condition.get()).truthy()) {
+    if (exec_stmts(node->body) == Flow::RETURN)
+      return Flow::RETURN;
   }
+  return Flow::NORMAL;
 }
 
-auto Interpreter::exec_return(const ReturnStatement* node) -> void {
-  auto val = eval(node->expr.get());
-  throw ReturnSignal{std::move(val)};
+auto Interpreter::exec_return(const ReturnStatement* node) -> Flow {
+  if (node->tail_call) {
+    auto* call = static_cast<const FunctionCall*>(node->expr.get());
+    if (auto* callee = tail_callee(call)) {
+      auto mark = _values.mark();
+      auto args = push_args(call->exprs);
+      _tail = {.callee = callee, .args = args, .mark = mark};
+      return Flow::RETURN;
+    }
+  }
+  _return_value = eval(node->expr.get());
+  return Flow::RETURN;
+}
+
+// Function a 'devolver call(...)' can run in the current frame, or null.
+// Only user functions can take over the frame, and not one nested in the
+// function running here: its parent link would point at this frame.
+auto Interpreter::tail_callee(const FunctionCall* call) -> const FunctionDecl* {
+  const auto& target = resolve_call(call);
+  if (target.kind != CallTarget::Kind::FUNCTION)
+    return nullptr;
+  auto* callee = target.function;
+  if (callee->enclosing && callee->enclosing == _env.owner())
+    return nullptr;
+  return callee;
 }
  
-auto Interpreter::exec_continue(const ContinueStatement*) -> void {
-  throw ContinueSignal{};
+auto Interpreter::exec_continue(const ContinueStatement*) -> Flow {
+  return Flow::CONTINUE;
 }
 
-auto Interpreter::eval(const IAST* node) -> ValuePtr {
+auto Interpreter::eval(const IAST* node) -> Value {
   if (!node) return make_null();
   switch (node->node_type) {
     case LITERAL:      return eval_literal(static_cast<const Literal*>     (node));
@@ -185,391 +422,452 @@ auto Interpreter::eval(const IAST* node) -> ValuePtr {
     case ARRAYDECL:    return eval_array  (static_cast<const ArrayDecl*>   (node));
     case METHODCALL:   return eval_method_call(static_cast<const MethodCall*> (node));
     case INDEXEXPR:    return eval_index_expr(static_cast<const IndexExpr*>(node));
+    case MEMBERACCESS: return eval_member_access(static_cast<const MemberAccess*>(node));
     default:
       throw RuntimeError("nodo de expresion desconocido");
   }
 }
 
-auto Interpreter::eval_literal(const Literal* node) -> ValuePtr {
+auto Interpreter::eval_literal(const Literal* node) -> Value {
   switch (node->token.type) {
     case TokenType::INTEGER:
-      return make(static_cast<int64_t>(std::stoll(node->token.literal)));
     case TokenType::FLOAT:
-      return make(std::stod(node->token.literal));
     case TokenType::BOOL:
-      return make(node->token.literal == "verdadero");
     case TokenType::STRING:
-      return make(node->token.literal);
+    case TokenType::NIL:
+      return node->value;
     case TokenType::SELF: {
-      return _env.get("__este__");
-    }
-    case TokenType::IDENTIFIER: {
-      auto& lit = node->token.literal;
-      auto dot = lit.find('.');
-      if (dot == std::string::npos)
-        return _env.get(lit);
-
-      const auto [inst, field] = resolve_member(lit);
-      if (auto it = inst->fields.find(field); it != inst->fields.end())
-        return it->second;
-      throw RuntimeError(std::format("la instancia no tiene campo '{}'", field));
-    }
-    case TokenType::NIL: {
-      return make_null();
+      return _env.self();
     }
+    case TokenType::IDENTIFIER:
+      return _env.get(node->slot, node->token.literal);
     default:
       throw RuntimeError(std::format("literal desconocido '{}'", node->token.literal));
   }
 }
 
-auto Interpreter::to_number(const ValuePtr& v, std::string_view op) -> std::pair<bool, double> {
-  if (v->is_int())   return {false, static_cast<double>(v->as_int())};
-  if (v->is_float()) return {true,  v->as_float()};
-  throw RuntimeError(std::format("operador '{}' requiere numeros, obtuvo '{}'", op, v->to_string()));
+// The value of 'node' without copying it when it is a constant or names a
+// variable: the reference is to the literal or the slot, so it has to be
+// used before anything else runs. Other nodes are evaluated into 'tmp'.
+auto Interpreter::borrow(const IAST* node, Value& tmp) -> const Value& {
+  if (node && node->node_type == LITERAL) {
+    auto* lit = static_cast<const Literal*>(node);
+    if (lit->token.type == TokenType::IDENTIFIER)
+      return _env.ref(lit->slot, lit->token.literal);
+    if (lit->token.type != TokenType::SELF)
+      return lit->value;
+  }
+  return tmp = eval(node);
+}
+
+// Whether evaluating 'node' can run code that assigns a variable.
+static auto is_plain(const IAST* node) -> bool {
+  return node && node->node_type == LITERAL;
 }
 
+// 'x se x + a + b ...' (see Assignment::appends). A string plus anything
+// is the concatenation of both to_string()s, so appending each addend in
+// turn gives what binary_op would build anew. False, with nothing changed,
+// when x is not a string it alone refers to (a copy elsewhere must keep its
+// value) or when x is itself an addend.
+auto Interpreter::append_in_place(const Assignment* node) -> bool {
+  const IAST* expr = node->expr.get();
+  if (static_cast<const BinaryOp*>(expr)->operands != StaticType::UNKNOWN)
+    return false;  // numbers
+  auto* lit    = static_cast<const Literal*>(node->target.get());
+  auto& target = _env.ref(lit->slot, lit->token.literal);
+  if (!unique_string(target))
+    return false;
+
+  Value        tmps[Assignment::MAX_APPENDS];
+  const Value* addends[Assignment::MAX_APPENDS];
+  for (auto i = node->appends; i-- > 0;) {  // the outermost sum holds the last addend
+    auto* sum  = static_cast<const BinaryOp*>(expr);
+    addends[i] = &borrow(sum->right.get(), tmps[i]);
+    if (addends[i] == &target) return false;
+    expr = sum->left.get();
+  }
+  for (auto i {0uz}; i < node->appends; ++i)
+    append_to(target.as_string(), *addends[i]);
+  return true;
+}
+
+// Runs a quickened site: while the operand types match what it was
+// specialized for, the stored routine runs without dispatching on the op or
+// the tags. A mismatch re-specializes it for the new pair, and 'generic'
+// covers pairs with no routine and sites that changed too often.
+template <class Specialize, class Generic>
+static auto run_quick(QuickSite& site, const Value& lv, const Value& rv,
+                      Specialize specialize, Generic generic) -> Value {
+  if (lv.type() == site.left && rv.type() == site.right) [[likely]]
+    return site.run ? site.run(lv, rv) : generic();
+
+  if (site.misses < QuickSite::MAX_MISSES) {
+    ++site.misses;
+    site.left  = lv.type();
+    site.right = rv.type();
+    site.run   = specialize();
+    if (site.run) return site.run(lv, rv);
+  } else {
+    site = {.misses = site.misses};  // generic from now on
+  }
+  return generic();
+}
 
-auto Interpreter::eval_binary(const BinaryOp* node) -> ValuePtr {
+auto Interpreter::eval_binary(const BinaryOp* node) -> Value {
   using enum TokenType;
   if (node->op.type == AND) {
     auto l = eval(node->left.get());
-    if (!l->truthy()) return make(false);
-    return make(eval(node->right.get())->truthy());
+    if (!l.truthy()) return make(false);
+    return make(eval(node->right.get()).truthy());
   }
   if (node->op.type == OR) {
     auto l = eval(node->left.get());
-    if (l->truthy()) return make(true);
-    return make(eval(node->right.get())->truthy());
+    if (l.truthy()) return make(true);
+    return make(eval(node->right.get()).truthy());
   }
 
-  auto lv = eval(node->left.get());
-  auto rv = eval(node->right.get());
+  // The left operand is only borrowed when the right one cannot change it.
+  Value l, r;
+  const auto& lv = is_plain(node->right.get()) ? borrow(node->left.get(), l) : (l = eval(node->left.get()));
+  const auto& rv = borrow(node->right.get(), r);
+  return apply_binary(node, lv, rv);
+}
 
-  switch (node->op.type) {
-    case PLUS: {
-      if (lv->is_string() || rv->is_string())
-        return make(lv->to_string() + rv->to_string());
-      auto [lf, ln] = to_number(lv, "+");
-      auto [rf, rn] = to_number(rv, "+");
-      if (lf || rf) return make(ln + rn);
-      return make(static_cast<int64_t>(ln) + static_cast<int64_t>(rn));
-    }
-    case MINUS: {
-      auto [lf, ln] = to_number(lv, "-");
-      auto [rf, rn] = to_number(rv, "-");
-      if (lf || rf) return make(ln - rn);
-      return make(static_cast<int64_t>(ln) - static_cast<int64_t>(rn));
-    }
-    case STAR: {
-      auto [lf, ln] = to_number(lv, "*");
-      auto [rf, rn] = to_number(rv, "*");
-      if (lf || rf) return make(ln * rn);
-      return make(static_cast<int64_t>(ln) * static_cast<int64_t>(rn));
-    }
-    case SLASH: {
-      auto [lf, ln] = to_number(lv, "/");
-      auto [rf, rn] = to_number(rv, "/");
-      if (rn == 0.0)
-        throw RuntimeError("division por cero");
-      if (!lf && !rf && static_cast<int64_t>(rn) != 0)
-        return make(static_cast<int64_t>(ln) / static_cast<int64_t>(rn));
-      return make(ln / rn);
-    }
-    case EQUAL: {
-      if (lv->is_int()    && rv->is_int())    return make(lv->as_int()    == rv->as_int());
-      if (lv->is_float()  || rv->is_float()) {
-        auto [_a, a] = to_number(lv, "==");
-        auto [_b, b] = to_number(rv, "==");
-        return make(a == b);
-      }
-      if (lv->is_bool()   && rv->is_bool())   return make(lv->as_bool()   == rv->as_bool());
-      if (lv->is_string() && rv->is_string()) return make(lv->as_string() == rv->as_string());
-      if (lv->is_null()   && rv->is_null())   return make(true);
-      return make(false);
-    }
-    case NOT_EQUAL: {
-      BinaryOp eq_node{nullptr, nullptr, Token{EQUAL, "="}};
-      auto eq = [&]() -> bool {
-        if (lv->is_int()    && rv->is_int())    return lv->as_int()    == rv->as_int();
-        if (lv->is_float()  || rv->is_float()) {
-          auto [_a, a] = to_number(lv, "!=");
-          auto [_b, b] = to_number(rv, "!=");
-          return a == b;
-        }
-        if (lv->is_bool()   && rv->is_bool())   return lv->as_bool()   == rv->as_bool();
-        if (lv->is_string() && rv->is_string()) return lv->as_string() == rv->as_string();
-        if (lv->is_null()   && rv->is_null())   return true;
-        return false;
-      }();
-      return make(!eq);
-    }
-    case LESSER_THAN: {
-      auto [lf, ln] = to_number(lv, "<");
-      auto [rf, rn] = to_number(rv, "<");
-      return make(ln < rn);
-    }
-    case GREATER_THAN: {
-      auto [lf, ln] = to_number(lv, ">");
-      auto [rf, rn] = to_number(rv, ">");
-      return make(ln > rn);
-    }
-    case LESSER_OR_EQUAL: {
-      auto [lf, ln] = to_number(lv, "<=");
-      auto [rf, rn] = to_number(rv, "<=");
-      return make(ln <= rn);
-    }
-    case GREATER_OR_EQUAL: {
-      auto [lf, ln] = to_number(lv, ">=");
-      auto [rf, rn] = to_number(rv, ">=");
-      return make(ln >= rn);
-    }
+// The operator of 'node' (not 'y' / 'o') over operands already evaluated.
+auto Interpreter::apply_binary(const BinaryOp* node, const Value& lv, const Value& rv) -> Value {
+  switch (node->operands) {
+    case StaticType::INT:   return int_binary_op(node->op.type, lv.as_int(), rv.as_int());
+    case StaticType::FLOAT: return float_binary_op(node->op.type, lv.as_float(), rv.as_float());
     default:
-      throw RuntimeError(std::format("operador binario desconocido '{}'", node->op.literal));
+      return run_quick(node->quick, lv, rv,
+        [&] { return specialize_binary(node->op.type, lv.type(), rv.type()); },
+        [&] { return binary_op(node->op.type, lv, rv); });
   }
 }
 
-auto Interpreter::eval_unary(const UnaryOp* node) -> ValuePtr {
-  auto val = eval(node->operand.get());
-  switch (node->op) {
-    case TokenType::MINUS:
-      if (val->is_int())   return make(-val->as_int());
-      if (val->is_float()) return make(-val->as_float());
-      throw RuntimeError("'-' unario requiere un numero");
-    case TokenType::BANG:
-      return make(!val->truthy());
-    default:
-      throw RuntimeError("operador unario desconocido");
-  }
+auto Interpreter::eval_unary(const UnaryOp* node) -> Value {
+  return unary_op(node->op, eval(node->operand.get()));
 }
 
-auto Interpreter::call_builtin(const std::string& name, std::span<ValuePtr> args) -> ValuePtr {
-  auto* desc = find_builtin(FREE_FUNCTIONS, name); 
-  if (desc && !desc->variadic) {
-    if (args.size() != desc->arity)
-      throw RuntimeError(std::format(
-        "'{}' espera {} argumento(s) pero recibio {}",
-        name, desc->arity, args.size()));
-  } 
-  return desc->fn(nullptr, std::move(args));
+auto Interpreter::call_builtin(const NativeMethodDesc& desc, std::span<Value> args) -> Value {
+  if (!desc.variadic && args.size() != desc.arity)
+    throw RuntimeError(std::format(
+      "'{}' espera {} argumento(s) pero recibio {}",
+      desc.name, desc.arity, args.size()));
+  return desc.fn({}, std::move(args));
 }
 
-auto Interpreter::eval_call(const FunctionCall* node) -> ValuePtr {
-  if (node->id == "__index__") {
-    auto arr  = eval(node->exprs[0].get());
-    auto idx  = eval(node->exprs[1].get());
-    if (!idx->is_int())
-      throw RuntimeError("el indice debe ser un entero");
-    if (arr->is_array()) {
-      auto i = idx->as_int();
-      auto& data = arr->as_array();
-      if (i < 0 || static_cast<std::size_t>(i) >= data.size())
-        throw RuntimeError(std::format("indice {} fuera de rango (tamaño {})", i, data.size()));
-      return data[static_cast<std::size_t>(i)];
-    } else if (arr->is_string()){
-      auto i = idx->as_int();
-      char data = arr->as_string()[i];
-      return make(std::string{data});
-    }
-    throw RuntimeError("solo se puede indexar un arreglo");
-  }
+static auto next_generation() -> uint32_t {
+  static uint32_t counter {};
+  return ++counter;
+}
 
-  if (is_builtin(node->id)) {
-    std::vector<ValuePtr> args;
-    args.reserve(node->exprs.size());
-    for (auto& a : node->exprs)
-      args.push_back(eval(a.get()));
-    return call_builtin(node->id, args);
-  }
+Interpreter::Interpreter(InterpreterOptions options)
+: _options(options), _generation(next_generation()), _jit(options.jit && !options.memo),
+  _memo(options.memo ? std::make_unique<MemoTable>() : nullptr) {}
 
-  if (_classes.contains(node->id)) {
-    std::vector<ValuePtr> args;
-    args.reserve(node->exprs.size());
-    for (auto& a : node->exprs)
-      args.push_back(eval(a.get()));
-    return instantiate(node->id, args);
-  }
+Interpreter::~Interpreter() = default;
 
-  auto dot = node->id.find('.');
-  if (dot != std::string::npos) {
-    std::string obj_name = node->id.substr(0, dot);
-    std::string method   = node->id.substr(dot + 1);
+auto Interpreter::memo_stats() const -> MemoStats {
+  return _memo ? _memo->stats() : MemoStats{};
+}
+
+// Invalidates every CallTarget resolved so far.
+auto Interpreter::rebind() -> void {
+  _generation = next_generation();
+}
 
-    ValuePtr obj_val = (obj_name == "este")
-                         ? _env.get("__este__")
-                         : _env.get(obj_name);
+// The nested function or class Sema resolved 'call' to, if any.
+template <class Decl, NodeType Type>
+static auto nested_decl(const FunctionCall* call) -> const Decl* {
+  if (!call->decl || call->decl->node_type != Type) return nullptr;
+  auto* decl = static_cast<const Decl*>(call->decl);
+  return decl->enclosing ? decl : nullptr;
+}
 
-    if (!obj_val->is_instance())
-      throw RuntimeError(std::format("'{}' no es una instancia", obj_name));
+// Resolution order matches the language rules: builtins, then classes, then
+// user functions. Only the first call at a site (per generation) pays for it.
+auto Interpreter::resolve_call(const FunctionCall* node) -> const CallTarget& {
+  using enum CallTarget::Kind;
+  auto& target = node->target;
+  if (target.kind != UNRESOLVED && target.generation == _generation)
+    return target;
 
-    auto inst = obj_val->as_instance();
-    auto it   = inst->klass->methods.find(method);
-    if (it == inst->klass->methods.end())
-      throw RuntimeError(std::format("'{}' no tiene metodo '{}'",
-                                     inst->klass->name, method));
+  CallTarget resolved{.generation = _generation};
+  if (node->id == "__index__") {
+    resolved.kind = INDEX;
+  } else if (auto* desc = find_builtin(FREE_FUNCTIONS, node->id)) {
+    resolved.kind    = BUILTIN;
+    resolved.builtin = desc;
+  } else if (auto* fn = nested_decl<FunctionDecl, FUNCTIONDECL>(node)) {
+    resolved.kind     = FUNCTION;
+    resolved.function = fn;
+  } else if (auto* klass = nested_decl<ClassDecl, CLASSDECL>(node)) {
+    auto it = _nested_classes.find(klass);
+    if (it == _nested_classes.end())
+      throw RuntimeError(std::format("funcion '{}' no definida", node->id));
+    resolved.kind  = CLASS;
+    resolved.klass = &it->second;
+  } else if (auto cit = _classes.find(node->id); cit != _classes.end()) {
+    resolved.kind  = CLASS;
+    resolved.klass = &cit->second;
+  } else if (auto fit = _functions.find(node->id); fit != _functions.end()) {
+    resolved.kind     = FUNCTION;
+    resolved.function = fit->second;
+  } else {
+    throw RuntimeError(std::format("funcion '{}' no definida", node->id));
+  }
+  return target = resolved;
+}
 
-    std::vector<ValuePtr> args;
-    args.reserve(node->exprs.size());
-    for (auto& a : node->exprs)
-      args.push_back(eval(a.get()));
+auto Interpreter::eval_call(const FunctionCall* node) -> Value {
+  using enum CallTarget::Kind;
+  // By value: evaluating the arguments may rebind names.
+  const auto target = resolve_call(node);
 
-    return call_function(it->second, args, inst);
+  if (target.kind == INDEX) {
+    auto arr  = eval(node->exprs[0].get());
+    auto idx  = eval(node->exprs[1].get());
+    return index_call(arr, idx);
   }
 
-  auto fit = _functions.find(node->id);
-  if (fit == _functions.end())
-    throw RuntimeError(std::format("funcion '{}' no definida", node->id));
+  ValueStack::Scope scope{_values};
+  return call_target(target, push_args(node->exprs));
+}
+
+// Evaluates 'args' in order into a block at the top of _values, which a
+// called function then takes as the start of its frame.
+auto Interpreter::push_args(const ExprsPtr& args) -> std::span<Value> {
+  auto values = _values.push(args.size());
+  for (auto i {0uz}; i < args.size(); ++i)
+    values[i] = eval(args[i].get());
+  return values;
+}
 
-  std::vector<ValuePtr> args;
-  args.reserve(node->exprs.size());
-  for (auto& a : node->exprs)
-    args.push_back(eval(a.get()));
+// '__index__(arr, idx)'.
+auto Interpreter::index_call(const Value& arr, const Value& idx) -> Value {
+  if (!idx.is_int())
+    throw RuntimeError("el indice debe ser un entero");
+  if (arr.is_array()) {
+    auto i = idx.as_int();
+    auto& data = arr.as_array();
+    if (i < 0 || static_cast<std::size_t>(i) >= data.size())
+      throw RuntimeError(std::format("indice {} fuera de rango (tamaño {})", i, data.size()));
+    return data[static_cast<std::size_t>(i)];
+  } else if (arr.is_string()){
+    auto i = idx.as_int();
+    char data = arr.as_string()[i];
+    return make(std::string{data});
+  }
+  throw RuntimeError("solo se puede indexar un arreglo");
+}
 
-  return call_function(fit->second, args, nullptr);
+auto Interpreter::call_target(const CallTarget& target, std::span<Value> args) -> Value {
+  switch (target.kind) {
+    case CallTarget::Kind::BUILTIN: return call_builtin(*target.builtin, args);
+    case CallTarget::Kind::CLASS:   return instantiate(*target.klass, args);
+    default:                        return call_function(target.function, args, nullptr);
+  }
 }
 
-auto Interpreter::eval_array(const ArrayDecl* node) -> ValuePtr {
-  std::vector<ValuePtr> items;
+auto Interpreter::eval_array(const ArrayDecl* node) -> Value {
+  std::vector<Value> items;
   items.reserve(node->data.size());
   for (auto& el : node->data)
     items.push_back(eval(el.get()));
-  return std::make_shared<Value>(std::move(items));
+  return make(std::move(items));
 }
 
-auto Interpreter::call_function(const FunctionDecl* fn, std::span<ValuePtr> args, InstancePtr self) -> ValuePtr {
-  if (args.size() != fn->params.size())
-    throw RuntimeError(std::format("'{}' espera {} argumento(s), obtuvo {}", fn->id.size(), fn->params.size(), args.size()));
-  _env.push();
-
-  if (self)
-    _env.define("__este__", std::make_shared<Value>(self));
-
-  for (auto i {0uz}; i < fn->params.size(); i++)
-    _env.define(fn->params[i], std::move(args[i]));
+static auto check_arity(const FunctionDecl* fn, std::size_t argc) -> void {
+  if (argc != fn->params.size())
+    throw RuntimeError(std::format("'{}' espera {} argumento(s), obtuvo {}", fn->id, fn->params.size(), argc));
+}
 
-  ValuePtr result = make_null();
-  try {
-    exec_stmts(fn->body);
-  } catch (ReturnSignal& rs) {
-    result = std::move(rs.value);
-  }
+auto Interpreter::call_function(const FunctionDecl* fn, std::span<Value> args, InstancePtr self) -> Value {
+  check_arity(fn, args.size());
+  CallDepth depth{*this};
+  if (_memo && fn->pure && !self)
+    return call_memoized(fn, args);
+  return run_function(fn, args, std::move(self));
+}
 
-  _env.pop();
+// The arguments are copied first: running the call moves them into its frame.
+auto Interpreter::call_memoized(const FunctionDecl* fn, std::span<Value> args) -> Value {
+  if (auto* hit = _memo->find(fn, args))
+    return *hit;
+  std::vector<Value> key(args.begin(), args.end());
+  auto result = run_function(fn, args, nullptr);
+  _memo->insert(fn, key, result);
   return result;
 }
 
+auto Interpreter::run_function(const FunctionDecl* fn, std::span<Value> args, InstancePtr self) -> Value {
+  if (!self)
+    if (auto result = _jit.call(fn, args, _generation))
+      return std::move(*result);
+
+  ValueStack::Scope scope{_values};
+  // Parameters occupy the first slots, in declaration order.
+  Frame frame{
+    .owner  = fn,
+    .slots  = _values.frame(args, std::max(fn->frame_size, args.size())),
+    .parent = _env.static_parent(fn->enclosing),
+    .self   = self ? Value{std::move(self)} : Value{},
+  };
+  Environment::Guard guard{_env, frame};
+
+  // A tail call swaps the callee into this same frame and goes around
+  // again, so tail recursion needs neither C++ stack nor new frames. Only
+  // a callee with more slots than any before it takes a new block.
+  while (exec_body(fn) == Flow::RETURN) {
+    if (!_tail.callee)
+      return std::exchange(_return_value, Value{});
+
+    auto tail = std::exchange(_tail, {});
+    fn = tail.callee;
+    check_arity(fn, tail.args.size());
+    frame.owner  = fn;
+    frame.parent = _env.static_parent(fn->enclosing);
+    frame.self   = Value{};
+    std::ranges::fill(frame.slots, make_unbound());
+    auto size  = std::max(fn->frame_size, tail.args.size());
+    bool grows = size > frame.slots.size();
+    if (grows)
+      frame.slots = _values.push(size);
+    std::ranges::move(tail.args, frame.slots.begin());
+    if (grows)
+      std::ranges::fill(tail.args, make_unbound());
+    else
+      _values.release(tail.mark);
+  }
+  return make_null();
+}
 
-auto Interpreter::instantiate(const std::string& class_name, std::span<ValuePtr> args) -> ValuePtr {
-  auto it = _classes.find(class_name);
-  if (it == _classes.end())
-    throw RuntimeError(std::format("clase '{}' no definida", class_name));
-
-  auto& def  = it->second;
-  auto  inst = std::make_shared<Instance>();
-  inst->klass = def;
 
+auto Interpreter::instantiate(const std::shared_ptr<ClassDef>& def, std::span<Value> args) -> Value {
+  auto  inst = InstancePtr::make(def);
 
-  _env.push();
-  _env.define("__este__", std::make_shared<Value>(inst));
-  for (const auto& [name, expr] : def->fields) {
-    if (expr)
-      inst->fields[name] = eval(expr);
-    else
-      inst->fields[name] = make_null();
+  {
+    Frame frame{
+      .parent = _env.static_parent(def->decl ? def->decl->enclosing : nullptr),
+      .self   = Value{inst},
+    };
+    Environment::Guard guard{_env, frame};
+    for (auto i {0uz}; i < def->field_inits.size(); ++i)
+      if (const auto* init = def->field_inits[i])
+        inst->slots[i] = eval_init(init);
   }
-  _env.pop();
-
 
   auto ctor_it = def->methods.find("crear");
   if (ctor_it != def->methods.end())
     call_function(ctor_it->second, std::move(args), inst);
   else if (!args.empty())
-    throw RuntimeError(std::format("clase '{}' no tiene constructor: ", class_name));
-  return std::make_shared<Value>(inst);
+    throw RuntimeError(std::format("clase '{}' no tiene constructor: ", def->name));
+  return Value{inst};
 }
 
-auto Interpreter::resolve_member(const std::string& dotted) -> std::pair<InstancePtr, std::string> {
-  auto dot     = dotted.find('.');
-  auto root    = dotted.substr(0, dot);
-  auto field   = dotted.substr(dot + 1);
-
-  ValuePtr obj_val = (root == "este") ? _env.get("__este__") : _env.get(root);
+// Where 'node->field' lives in 'inst', or null if the instance lacks it.
+auto Interpreter::member_slot(const MemberAccess* node, Instance& inst) -> Value* {
+  const auto* decl = inst.klass->decl;
+  if (decl && decl == node->cached_class)
+    return &inst.slots[node->cached_slot];
 
-  if (!obj_val->is_instance())
-    throw RuntimeError(std::format("'{}' no es una instancia", root));
-
-  return {obj_val->as_instance(), field};
+  if (auto slot = inst.klass->slot_of(node->field); slot != ClassDef::NO_SLOT) {
+    node->cached_class = decl;
+    node->cached_slot  = slot;
+    return &inst.slots[slot];
+  }
+  return inst.field(node->field);
 }
 
-auto Interpreter::eval_index_expr(const IndexExpr* node) -> ValuePtr {
-  auto obj = eval(node->object.get());
-  auto idx = eval(node->index.get());
+auto Interpreter::eval_member_access(const MemberAccess* node) -> Value {
+  Value obj;
+  return member_value(node, borrow(node->object.get(), obj));
+}
 
-  if (!idx->is_int())
-    throw RuntimeError("el indice debe ser entero");
+auto Interpreter::member_value(const MemberAccess* node, const Value& obj) -> Value {
+  if (!obj.is_instance())
+    throw RuntimeError(std::format("'{}' no es una instancia", obj.to_string()));
 
-  auto i = idx->as_int();
+  if (auto* slot = member_slot(node, *obj.as_instance()))
+    return *slot;
+  throw RuntimeError(std::format("la instancia no tiene campo '{}'", *node->field));
+}
 
-  if (obj->is_array()) {
-    auto& arr = obj->as_array();
-    if (i < 0 || i >= static_cast<int>(arr.size()))
-      throw RuntimeError("indice fuera de rango");
-    return arr[i];
-  }else if (obj->is_string()) {
-    const auto& s = obj->as_string();
-    if (i < 0 || i >= static_cast<int>(s.size()))
-      throw RuntimeError("indice fuera de rango");
-    return make(std::string(1, s[i]));
-  }
+auto Interpreter::assign_member(const MemberAccess* node, const Value& obj, Value val) -> void {
+  if (!obj.is_instance())
+    throw RuntimeError(std::format("'{}' no es una instancia", obj.to_string()));
+  auto& inst = *obj.as_instance();
+  if (auto* slot = member_slot(node, inst))
+    *slot = std::move(val);
+  else
+    inst.set_field(node->field, std::move(val));
+}
 
-  throw RuntimeError("solo se puede indexar array o string");
+auto Interpreter::eval_index_expr(const IndexExpr* node) -> Value {
+  Value o, i;
+  const auto& obj = is_plain(node->index.get()) ? borrow(node->object.get(), o) : (o = eval(node->object.get()));
+  const auto& idx = borrow(node->index.get(), i);
+  return apply_index(node, obj, idx);
 }
 
-auto Interpreter::dispatch_native_method(std::span<const NativeMethodDesc> methods, ValuePtr self, const MethodCall* node) -> ValuePtr {
-  auto* method = find_builtin(methods, node->name);
+auto Interpreter::apply_index(const IndexExpr* node, const Value& obj, const Value& idx) -> Value {
+  return run_quick(node->quick, obj, idx,
+    [&] { return specialize_index(obj.type(), idx.type()); },
+    [&] { return index_value(obj, idx); });
+}
 
-  if (!method)
-    throw RuntimeError("Invalido metodo");
+// Where 'node' leads for 'obj', through the site's inline cache. Native
+// methods check their arity before any argument is evaluated.
+auto Interpreter::method_entry(const Value& obj, const MethodCall* node) -> InlineCache::Entry {
+  const void* klass = obj.is_instance() ? obj.as_instance()->klass->decl : nullptr;
+  const auto* entry = node->cache.lookup(obj.type(), klass);
+  InlineCache::Entry miss;
+  if (!entry) {
+    miss = lookup_method(obj, node);
+    node->cache.insert(miss);
+    entry = &miss;
+  }
 
-  if (!method->variadic && node->args.size() != method->arity)
+  if (entry->native && !entry->native->variadic && node->args.size() != entry->native->arity)
     throw RuntimeError("argumento(s) invalido(s)");
+  return *entry;
+}
 
-  std::vector<ValuePtr> args;
+auto Interpreter::call_method(const InlineCache::Entry& entry, const Value& obj, std::span<Value> args) -> Value {
+  if (entry.method)
+    return call_function(entry.method, args, obj.as_instance());
+  return entry.native->fn(obj, args);
+}
 
-  args.reserve(node->args.size());
+auto Interpreter::lookup_method(const Value& obj, const MethodCall* node) -> InlineCache::Entry {
+  if (obj.is_instance()) {
+    const auto& klass = obj.as_instance()->klass;
+    auto it = klass->methods.find(node->name);
+    if (it == klass->methods.end())
+      throw RuntimeError(std::format("'{}' no tiene metodo '{}'", klass->name, node->name));
+    return {.kind = ValueType::INSTANCE, .klass = klass->decl, .method = it->second};
+  }
 
-  for (const auto& arg : node->args)
-    args.push_back(eval(arg.get()));
+  std::span<const NativeMethodDesc> methods;
+  if (obj.is_array())
+    methods = ARRAY_METHODS;
+  else if (obj.is_string())
+    methods = STRING_METHODS;
+  else
+    throw RuntimeError("Metodo Invalido");
 
-  return method->fn(self, args);
+  auto* method = find_builtin(methods, node->name);
+  if (!method)
+    throw RuntimeError("Invalido metodo");
+  return {.kind = obj.type(), .native = method};
 }
 
-auto Interpreter::eval_method_call(const MethodCall* node) -> ValuePtr {
-  auto obj = eval(node->object.get());
-
-  if (obj->is_array()) {
-    return dispatch_native_method(
-      ARRAY_METHODS,
-      obj, node
-    );
-  } else if (obj->is_string()) {
-    return dispatch_native_method(
-      STRING_METHODS,
-      obj, node
-    );
-  }
-
-  else if (obj->is_instance()) {
-    auto  inst = obj->as_instance();
-    auto  it   = inst->klass->methods.find(node->name);
-    if (it == inst->klass->methods.end())
-      throw RuntimeError(std::format("'{}' no tiene metodo '{}'",
-                                     inst->klass->name, node->name));
-    std::vector<ValuePtr> args;
-    args.reserve(node->args.size());
-    for (auto& a : node->args)
-      args.push_back(eval(a.get()));
-    return call_function(it->second, args, inst);
-  } 
+auto Interpreter::eval_method_call(const MethodCall* node) -> Value {
+  auto obj   = eval(node->object.get());
+  auto entry = method_entry(obj, node);
 
-  throw RuntimeError("Metodo Invalido");
+  ValueStack::Scope scope{_values};
+  return call_method(entry, obj, push_args(node->args));
 }
@@ -1,65 +1,254 @@
 #pragma once
 #include "std.h"
 #include "nodes.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <unordered_map>
+#include "error_manager.h"
 #include "runtime_values.h"
+#include "jit.h"
+#include "memo.h"
+
+// Slots of every live call, in one contiguous stack: a call takes the
+// next frame_size values and hands them back when it returns, so calls
+// allocate nothing. Arguments are evaluated straight onto the top, where
+// the callee's frame then grows over them without copying. The stack is
+// kept in fixed chunks that never move; a block that does not fit in the
+// rest of one starts the next. Values above the top are always unbound.
+class ValueStack final {
+public:
+  static constexpr std::size_t CHUNK = 4096;  // values
+
+  struct Mark final {
+    std::size_t chunk{};
+    std::size_t top{};
+  };
+
+  // Releases everything pushed during its lifetime.
+  class Scope final {
+  public:
+    explicit Scope(ValueStack& stack) : _stack(stack), _mark(stack.mark()) {}
+    ~Scope() { _stack.release(_mark); }
+    Scope(const Scope&)                    = delete;
+    auto operator=(const Scope&) -> Scope& = delete;
+  private:
+    ValueStack& _stack;
+    Mark        _mark;
+  };
+
+  ValueStack();
+
+  auto mark() const -> Mark { return {_chunk, _top}; }
+  auto push(std::size_t n) -> std::span<Value>;
+  // 'size' slots starting with 'args', in place when 'args' is the block
+  // at the top and the chunk has room.
+  auto frame(std::span<Value> args, std::size_t size) -> std::span<Value>;
+  auto release(Mark mark) -> void;
+
+private:
+  struct Chunk final {
+    std::vector<Value> values{};  // never resized
+    std::size_t        used{};    // top when the next chunk was started
+  };
+
+  std::vector<Chunk> _chunks{};
+  std::size_t        _chunk{};
+  std::size_t        _top{};
+};
+
+// Storage for one activation. Slot numbers come from Sema; 'parent' is the
+// frame of the enclosing declaration, which is what a VarSlot depth walks.
+// Function frames live on the ValueStack, the global one in Environment.
+struct Frame final {
+  const IAST*        owner{};   // FunctionDecl (or field initializer) running here
+  std::span<Value>   slots{};
+  Frame*             parent{};  // null means the global frame
+  Value              self{};
+};
 
 class Environment {
 public:
-  Environment() { push(); }
+  // Makes 'frame' the current one for the lifetime of the guard.
+  class Guard final {
+  public:
+    Guard(Environment& env, Frame& frame) : _env(env) { _env._stack.push_back(&frame); }
+    ~Guard() { _env._stack.pop_back(); }
+    Guard(const Guard&)                    = delete;
+    auto operator=(const Guard&) -> Guard& = delete;
+  private:
+    Environment& _env;
+  };
 
-  auto push() -> void;
-  auto pop()  -> void;
+  auto define(const VarSlot& slot, Value val)                      -> void;
+  auto get(const VarSlot& slot, std::string_view name) const          -> Value;
+  // The slot itself, valid until the variable is next assigned.
+  auto ref(const VarSlot& slot, std::string_view name) const          -> const Value&;
+  auto ref(const VarSlot& slot, std::string_view name)                -> Value&;
+  auto set(const VarSlot& slot, std::string_view name, Value val)  -> void;
+  auto self() const                                                   -> Value;
+  auto owner() const                                                  -> const IAST*;
 
-  auto define(const std::string& name, ValuePtr val)  -> void;
-  auto get(const std::string& name) const             -> ValuePtr;
-  auto set(const std::string& name, ValuePtr val)     -> void;
-  auto has(const std::string& name) const             -> bool;
+  // Frame of the innermost live activation of 'enclosing' (null = globals).
+  auto static_parent(const IAST* enclosing)                           -> Frame*;
 
 private:
-  std::vector<std::unordered_map<std::string, ValuePtr>> _scopes;
+  Frame               _global{};
+  std::vector<Value>  _globals{};  // grows as the program (or the REPL) declares
+  std::vector<Frame*> _stack{};
+
+  auto current()                                 -> Frame&;
+  auto frame_at(uint32_t depth) const            -> const Frame&;
+  auto frame_at(uint32_t depth)                  -> Frame&;
 };
 
 
+// How a statement finished. 'devolver' leaves its value in
+// Interpreter::_return_value, or for a tail call the pending callee in
+// Interpreter::_tail; no C++ exception is involved.
+enum class Flow : uint8_t { NORMAL, RETURN, CONTINUE };
+
+struct InterpreterOptions final {
+  bool jit{true};        // compile hot functions to machine code (see Jit)
+  bool closures{false};  // run closure-compiled code instead of walking nodes (see closures.cpp)
+  bool memo{false};      // cache results of the functions Sema marked pure (see MemoTable); no JIT,
+                         // native calls would bypass the table
+  std::size_t max_depth{DEFAULT_MAX_DEPTH};  // nested calls before stack_overflow ('--pila-max')
+};
+
+class StackThread;
+
 class Interpreter final {
 public:
+  explicit Interpreter(InterpreterOptions options = {});
+  ~Interpreter();
+
+  // Native stack each nested call may use; run() reserves max_depth of
+  // them, Jit::MAX_DEPTH more for native code, and STACK_MARGIN. The JIT
+  // leaves a function interpreted when its frame would not fit.
+  static constexpr std::size_t STACK_PER_CALL = 2 * 1024;
+  static constexpr std::size_t STACK_MARGIN   = 256 * 1024;
+
+  // A 'devolver' at top level ends the program by throwing ReturnSignal.
+  // The program runs on a thread of its own whose stack fits max_depth
+  // nested calls, so deep recursion ends in stack_overflow, not a crash.
+  // The thread starts with the first run() and serves every later one
+  // (each REPL input), so its stack, about 220 MB of address space at
+  // the default depth, is reserved once per interpreter.
   auto run(const StmtsPtr& program)     -> void;
 
+  // Hits and misses of the memo table; zero unless InterpreterOptions::memo.
+  auto memo_stats() const -> MemoStats;
+
 private:
+  // A node converted once into a C++ callable with its children and
+  // operator already bound, so running it needs no dispatch on node_type.
+  using StmtClosure = std::function<Flow()>;
+  using ExprClosure = std::function<Value()>;
+
+  InterpreterOptions _options;
   Environment _env{};
+  Value       _return_value{};
+  uint32_t    _generation;  // see CallTarget
+  Jit         _jit;
+  std::unique_ptr<MemoTable> _memo;  // only with InterpreterOptions::memo
+
+  ValueStack  _values{};
+  std::size_t _depth{};        // calls in progress
+  uintptr_t   _stack_floor{};  // lowest native stack address a new call may start below, 0 = unknown
+  std::unique_ptr<StackThread> _thread;  // runs the programs, see run()
+
+  // Counts a call in _depth for its lifetime, or throws stack_overflow.
+  class CallDepth final {
+  public:
+    explicit CallDepth(Interpreter& interp);
+    ~CallDepth() { --_interp._depth; }
+    CallDepth(const CallDepth&)                    = delete;
+    auto operator=(const CallDepth&) -> CallDepth& = delete;
+  private:
+    Interpreter& _interp;
+  };
+
+  // Set by a 'devolver f(...)' that call_function runs in the frame it
+  // already has instead of calling recursively. The arguments wait on
+  // _values, pushed at 'mark'.
+  struct TailCall final {
+    const FunctionDecl* callee{};
+    std::span<Value>    args{};
+    ValueStack::Mark    mark{};
+  } _tail{};
 
   std::unordered_map<std::string, std::shared_ptr<ClassDef>> _classes;
   std::unordered_map<std::string, const FunctionDecl*> _functions;
+  // Classes declared inside functions, as last declared (see exec_func_decl).
+  std::unordered_map<const ClassDecl*, std::shared_ptr<ClassDef>> _nested_classes;
+
+  // Closure mode: bodies and field initializers, converted on first use.
+  std::unordered_map<const FunctionDecl*, StmtClosure> _bodies;
+  std::unordered_map<const IAST*, ExprClosure>         _inits;
 
-  auto call_builtin(const std::string& name, std::span<ValuePtr> args) -> ValuePtr;
-  auto exec_stmts(const StmtsPtr& stmts) ->   void;
-  auto exec_stmt(const IAST* node) ->         void;
+  auto call_builtin(const NativeMethodDesc& desc, std::span<Value> args) -> Value;
+  auto resolve_call(const FunctionCall* node) -> const CallTarget&;
+  auto rebind() -> void;
+  auto exec_stmts(const StmtsPtr& stmts) ->   Flow;
+  auto exec_stmt(const IAST* node) ->         Flow;
   auto exec_var_decl(const VariableDecl*)  -> void;
   auto exec_func_decl(const FunctionDecl*) -> void;
   auto exec_class_decl(const ClassDecl*) ->   void;
   auto exec_assignment(const Assignment*) ->  void;
-  auto exec_if(const IfStatement*) ->         void;
-  auto exec_while(const WhileStatement*) ->   void;
-  auto exec_return(const ReturnStatement*) -> void;
-  auto exec_continue(const ContinueStatement*) -> void;
-  auto eval(const IAST* node) ->          ValuePtr;
-  auto eval_literal(const Literal*) ->    ValuePtr;
-  auto eval_binary(const BinaryOp*) ->    ValuePtr;
-  auto eval_unary(const UnaryOp*) ->      ValuePtr;
-  auto eval_index_expr(const IndexExpr* node) -> ValuePtr;
+  auto append_in_place(const Assignment* node) -> bool;
+  auto exec_if(const IfStatement*) ->         Flow;
+  auto exec_while(const WhileStatement*) ->   Flow;
+  auto exec_return(const ReturnStatement*) -> Flow;
+  auto tail_callee(const FunctionCall* call) -> const FunctionDecl*;
+  auto exec_continue(const ContinueStatement*) -> Flow;
+  auto eval(const IAST* node) ->          Value;
+  auto eval_literal(const Literal*) ->    Value;
+  auto borrow(const IAST* node, Value& tmp) -> const Value&;
+  auto eval_binary(const BinaryOp*) ->    Value;
+  static auto apply_binary(const BinaryOp* node, const Value& lv, const Value& rv) -> Value;
+  auto eval_unary(const UnaryOp*) ->      Value;
+  auto eval_index_expr(const IndexExpr* node) -> Value;
+  static auto apply_index(const IndexExpr* node, const Value& obj, const Value& idx) -> Value;
+
+  auto eval_method_call(const MethodCall* node) -> Value;
+  auto eval_call(const FunctionCall*) ->  Value;
+  auto push_args(const ExprsPtr& args) -> std::span<Value>;
+  static auto index_call(const Value& arr, const Value& idx) -> Value;
+  auto call_target(const CallTarget& target, std::span<Value> args) -> Value;
+  auto eval_array(const ArrayDecl*) ->    Value;
 
-  auto eval_method_call(const MethodCall* node) -> ValuePtr;
-  auto eval_call(const FunctionCall*) ->  ValuePtr;
-  auto eval_array(const ArrayDecl*) ->    ValuePtr;
+  auto call_function(const FunctionDecl* fn, std::span<Value> args, InstancePtr self) -> Value;
+  auto call_memoized(const FunctionDecl* fn, std::span<Value> args) -> Value;
+  auto run_function(const FunctionDecl* fn, std::span<Value> args, InstancePtr self) -> Value;
+  auto instantiate(const std::shared_ptr<ClassDef>& def, std::span<Value> args = {}) -> Value;
 
-  auto call_function(const FunctionDecl* fn, std::span<ValuePtr> args, InstancePtr self) -> ValuePtr;
-  auto instantiate(const std::string& class_name, std::span<ValuePtr> args = {}) -> ValuePtr;
+  auto eval_member_access(const MemberAccess* node) -> Value;
+  auto member_value(const MemberAccess* node, const Value& obj) -> Value;
+  auto assign_member(const MemberAccess* node, const Value& obj, Value val) -> void;
+  auto member_slot(const MemberAccess* node, Instance& inst) -> Value*;
 
-  auto resolve_member(const std::string& dotted) -> std::pair<InstancePtr, std::string>;
 
+  auto lookup_method(const Value& obj, const MethodCall* node) -> InlineCache::Entry;
+  auto method_entry(const Value& obj, const MethodCall* node) -> InlineCache::Entry;
+  auto call_method(const InlineCache::Entry& entry, const Value& obj, std::span<Value> args) -> Value;
 
-  auto dispatch_native_method(std::span<const NativeMethodDesc> methods, ValuePtr self, const MethodCall* node) -> ValuePtr;
-  static auto to_number(const ValuePtr& v, std::string_view op = "") -> std::pair<bool, double>;
+  // closures.cpp
+  auto exec_body(const FunctionDecl* fn)   -> Flow;
+  auto eval_init(const IAST* init)         -> Value;
+  auto close_stmts(const StmtsPtr& stmts)  -> StmtClosure;
+  auto close_stmt(const IAST* node)        -> StmtClosure;
+  auto close_if(const IfStatement* node)   -> StmtClosure;
+  auto close_assignment(const Assignment* node) -> StmtClosure;
+  auto close_return(const ReturnStatement* node) -> StmtClosure;
+  auto close_expr(const IAST* node)        -> ExprClosure;
+  auto close_binary(const BinaryOp* node)  -> ExprClosure;
+  auto close_call(const FunctionCall* node) -> ExprClosure;
+  auto close_method_call(const MethodCall* node) -> ExprClosure;
+  auto close_args(const ExprsPtr& args)    -> std::vector<ExprClosure>;
 };
@@ -0,0 +1,524 @@
+#include "jit.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "builtins.h"
+#include "interpreter.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+#include <sys/mman.h>
+#define OLM_JIT 1
+#else
+#define OLM_JIT 0
+#endif
+
+using enum NodeType;
+
+// Shared by every native frame of one entry from the interpreter.
+struct JitContext final {
+  bool     bailed{};  // first member: generated code tests the byte at [rbx]
+  uint32_t depth{};
+  uint32_t generation{};
+};
+static_assert(offsetof(JitContext, bailed) == 0);
+
+// Executable copy of one compiled function.
+struct NativeCode final {
+  using Entry = auto (*)(JitContext* ctx, const int64_t* args) -> int64_t;
+
+  void*       memory{};
+  std::size_t size{};
+  Entry       entry{};
+  bool        returns_bool{};  // the int64 result is 0 or 1
+  uint8_t     bailouts{};
+
+  NativeCode() = default;
+  NativeCode(const NativeCode&)                    = delete;
+  auto operator=(const NativeCode&) -> NativeCode& = delete;
+  ~NativeCode() {
+#if OLM_JIT
+    if (memory) munmap(memory, size);
+#endif
+  }
+};
+
+namespace {
+auto bail(JitContext* ctx) -> int64_t {
+  ctx->bailed = true;
+  return 0;
+}
+
+auto native_for(const FunctionDecl* fn) -> NativeCode*;
+
+// Only builtins without side effects may run on behalf of native code.
+auto pure_builtin(const NativeMethodDesc& desc) -> bool {
+  return desc.name == "abs" || desc.name == "max" || desc.name == "min";
+}
+
+// Called by generated code for every FunctionCall node, with the arguments
+// in order at 'args'. Nothing may unwind through native frames, so every
+// failure turns into a bailout.
+auto call_from_native(JitContext* ctx, const FunctionCall* node, const int64_t* args) -> int64_t {
+  using enum CallTarget::Kind;
+  const auto& target = node->target;
+  auto argc = node->exprs.size();
+  if (target.generation != ctx->generation)
+    return bail(ctx);
+
+  if (target.kind == BUILTIN) {
+    const auto& desc = *target.builtin;
+    if (!pure_builtin(desc) || desc.arity != argc || argc > 2)
+      return bail(ctx);
+    try {
+      std::array<Value, 2> boxed{};
+      for (auto i {0uz}; i < argc; ++i)
+        boxed[i] = make(args[i]);
+      auto result = desc.fn({}, std::span<const Value>(boxed.data(), argc));
+      return result.is_int() ? result.as_int() : bail(ctx);
+    } catch (...) {
+      return bail(ctx);
+    }
+  }
+
+  if (target.kind != FUNCTION || target.function->params.size() != argc || ctx->depth == Jit::MAX_DEPTH)
+    return bail(ctx);
+  auto* code = native_for(target.function);
+  if (!code || code->returns_bool)
+    return bail(ctx);
+
+  ++ctx->depth;
+  auto result = code->entry(ctx, args);
+  --ctx->depth;
+  return result;
+}
+
+// Raised while translating a body the templates do not cover.
+struct Unsupported final {};
+
+// One function body to machine code. Every expression leaves its value in
+// rax; operands waiting for the other side are pushed on the machine stack.
+// rbx holds the JitContext and locals live below rbp, one slot each:
+//
+//   [rbp - 8]           saved rbx
+//   [rbp - 16 - 8 * i]  slot i (parameters first, as in Frame::slots)
+class Codegen final {
+public:
+  // Upper bound on call_from_native's own frame: two Values, the saved
+  // registers and the call into the next native frame.
+  static constexpr std::size_t HELPER_FRAME = 256;
+
+  explicit Codegen(const FunctionDecl* fn) : _fn(fn) {}
+
+  auto translate() -> std::vector<uint8_t> {
+    if (_fn->enclosing)
+      throw Unsupported{};
+
+    // Each nested native call gets STACK_PER_CALL of the stack
+    // Interpreter::run() reserves (see Jit::MAX_DEPTH): return address,
+    // rbp, rbx, the slots, the operands pushed at the deepest point plus
+    // a pad, and call_from_native on the way to the next call.
+    auto frame = (_fn->frame_size * 8 + 15) / 16 * 16 + 8;  // keeps rsp 16-aligned
+    auto fits  = [&] { return 3 * 8 + frame + 8 * (_max_pushed + 1) + HELPER_FRAME <= Interpreter::STACK_PER_CALL; };
+    if (!fits())
+      throw Unsupported{};
+    emit({0x55});                    // push rbp
+    emit({0x48, 0x89, 0xE5});        // mov  rbp, rsp
+    emit({0x53});                    // push rbx
+    emit({0x48, 0x81, 0xEC});        // sub  rsp, frame
+    emit32(static_cast<int32_t>(frame));
+    emit({0x48, 0x89, 0xFB});        // mov  rbx, rdi
+    for (auto i {0uz}; i < _fn->params.size(); ++i) {
+      emit({0x48, 0x8B, 0x86});      // mov  rax, [rsi + 8i]
+      emit32(static_cast<int32_t>(8 * i));
+      store(static_cast<uint32_t>(i));
+    }
+
+    stmts(_fn->body);
+    if (_result == StaticType::UNKNOWN)
+      throw Unsupported{};  // never returns a value: nothing to gain
+    if (!fits())
+      throw Unsupported{};
+
+    // Falling off the end returns nulo, which only the interpreter can.
+    _bails.push_back(jump({0xE9}));
+
+    for (auto at : _bails) patch(at, here());
+    emit({0xC6, 0x03, 0x01});        // mov  byte [rbx], 1
+    for (auto at : _returns) patch(at, here());
+    emit({0x48, 0x8D, 0x65, 0xF8});  // lea  rsp, [rbp - 8]
+    emit({0x5B});                    // pop  rbx
+    emit({0x5D});                    // pop  rbp
+    emit({0xC3});                    // ret
+    return std::move(_code);
+  }
+
+  auto returns_bool() const -> bool { return _result == StaticType::BOOL; }
+
+private:
+  const FunctionDecl*                                     _fn;
+  std::vector<uint8_t>                                    _code{};
+  std::unordered_map<const VariableDecl*, StaticType>     _locals{};
+  std::vector<std::size_t>                                _bails{};
+  std::vector<std::size_t>                                _returns{};
+  std::vector<std::size_t>                                _loops{};   // heads, for 'continuar'
+  StaticType                                              _result{};
+  uint32_t                                                _pushed{};  // values on the machine stack
+  uint32_t                                                _max_pushed{};
+
+  auto here() const -> std::size_t { return _code.size(); }
+
+  auto emit(std::initializer_list<uint8_t> bytes) -> void {
+    _code.insert(_code.end(), bytes);
+  }
+  auto emit32(int32_t v) -> void {
+    auto at = _code.size();
+    _code.resize(at + 4);
+    std::memcpy(_code.data() + at, &v, 4);
+  }
+  auto emit64(uint64_t v) -> void {
+    auto at = _code.size();
+    _code.resize(at + 8);
+    std::memcpy(_code.data() + at, &v, 8);
+  }
+
+  // Emits a jump with a rel32 to fill in later; returns where it goes.
+  auto jump(std::initializer_list<uint8_t> opcode) -> std::size_t {
+    emit(opcode);
+    emit32(0);
+    return here() - 4;
+  }
+  auto patch(std::size_t at, std::size_t target) -> void {
+    auto rel = static_cast<int32_t>(target - (at + 4));
+    std::memcpy(_code.data() + at, &rel, 4);
+  }
+  auto jump_back(std::size_t target) -> void {
+    patch(jump({0xE9}), target);
+  }
+
+  static auto offset(uint32_t slot) -> int32_t {
+    return -16 - 8 * static_cast<int32_t>(slot);
+  }
+  auto load(uint32_t slot) -> void {
+    emit({0x48, 0x8B, 0x85});        // mov  rax, [rbp + disp32]
+    emit32(offset(slot));
+  }
+  auto store(uint32_t slot) -> void {
+    emit({0x48, 0x89, 0x85});        // mov  [rbp + disp32], rax
+    emit32(offset(slot));
+  }
+  auto push() -> void { emit({0x50}); _max_pushed = std::max(_max_pushed, ++_pushed); }
+  auto pop() -> void { emit({0x58}); --_pushed; }
+
+  auto to_bool() -> void {
+    emit({0x48, 0x85, 0xC0});        // test  rax, rax
+    emit({0x0F, 0x95, 0xC0});        // setne al
+    emit({0x0F, 0xB6, 0xC0});        // movzx eax, al
+  }
+
+  // Kind of the local an identifier names, if it lives in this frame.
+  auto local(const Literal* node) -> StaticType {
+    if (node->slot.depth != 0)
+      throw Unsupported{};
+    if (node->decl) {
+      auto it = _locals.find(node->decl);
+      if (it == _locals.end()) throw Unsupported{};
+      return it->second;
+    }
+    if (node->slot.index < _fn->params.size())
+      return StaticType::INT;  // Jit::call only enters with int arguments
+    throw Unsupported{};
+  }
+
+  auto stmts(const StmtsPtr& body) -> void {
+    for (const auto& s : body)
+      if (s) stmt(s.get());
+  }
+
+  auto stmt(const IAST* node) -> void {
+    switch (node->node_type) {
+      case VARIABLEDECL: {
+        auto* decl = static_cast<const VariableDecl*>(node);
+        if (decl->slot.depth != 0) throw Unsupported{};
+        _locals[decl] = expr(decl->expr.get());
+        store(decl->slot.index);
+        break;
+      }
+      case ASSIGNMENT: {
+        auto* assign = static_cast<const Assignment*>(node);
+        if (assign->target->node_type != LITERAL) throw Unsupported{};
+        auto* target = static_cast<const Literal*>(assign->target.get());
+        if (target->token.type != TokenType::IDENTIFIER) throw Unsupported{};
+        if (expr(assign->expr.get()) != local(target)) throw Unsupported{};
+        store(target->slot.index);
+        break;
+      }
+      case IFSTATEMENT:
+        if_stmt(static_cast<const IfStatement*>(node));
+        break;
+      case WHILESTATEMENT: {
+        auto* loop = static_cast<const WhileStatement*>(node);
+        auto head = here();
+        condition(loop->condition.get());
+        auto exit = jump({0x0F, 0x84});  // jz
+        _loops.push_back(head);
+        stmts(loop->body);
+        _loops.pop_back();
+        jump_back(head);
+        patch(exit, here());
+        break;
+      }
+      case RETURNSTATEMENT: {
+        auto* ret  = static_cast<const ReturnStatement*>(node);
+        if (!ret->expr) throw Unsupported{};
+        auto kind = expr(ret->expr.get());
+        if (_result != StaticType::UNKNOWN && _result != kind) throw Unsupported{};
+        _result = kind;
+        _returns.push_back(jump({0xE9}));
+        break;
+      }
+      case CONTINUESTMT:
+        if (_loops.empty()) throw Unsupported{};
+        jump_back(_loops.back());
+        break;
+      case FUNCTIONCALL:
+        call(static_cast<const FunctionCall*>(node));
+        break;
+      default:
+        throw Unsupported{};
+    }
+  }
+
+  auto if_stmt(const IfStatement* node) -> void {
+    condition(node->condition.get());
+    auto skip = jump({0x0F, 0x84});  // jz
+    stmts(node->then_body);
+    if (std::holds_alternative<std::monostate>(node->next)) {
+      patch(skip, here());
+      return;
+    }
+    auto end = jump({0xE9});
+    patch(skip, here());
+    if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&node->next))
+      if_stmt(elif->get());
+    else
+      stmts(std::get<StmtsPtr>(node->next));
+    patch(end, here());
+  }
+
+  // Sets the flags for a jz past the guarded code, like Value::truthy.
+  auto condition(const IAST* node) -> void {
+    expr(node);
+    emit({0x48, 0x85, 0xC0});        // test rax, rax
+  }
+
+  auto expr(const IAST* node) -> StaticType {
+    switch (node->node_type) {
+      case LITERAL:  return literal(static_cast<const Literal*>(node));
+      case BINARYOP: return binary(static_cast<const BinaryOp*>(node));
+      case UNARYOP: {
+        auto* unary = static_cast<const UnaryOp*>(node);
+        auto kind = expr(unary->operand.get());
+        if (unary->op == TokenType::BANG) {
+          emit({0x48, 0x85, 0xC0});    // test  rax, rax
+          emit({0x0F, 0x94, 0xC0});    // sete  al
+          emit({0x0F, 0xB6, 0xC0});    // movzx eax, al
+          return StaticType::BOOL;
+        }
+        if (unary->op != TokenType::MINUS || kind != StaticType::INT) throw Unsupported{};
+        emit({0x48, 0xF7, 0xD8});      // neg rax
+        _bails.push_back(jump({0x0F, 0x80}));  // jo
+        return StaticType::INT;
+      }
+      case FUNCTIONCALL:
+        call(static_cast<const FunctionCall*>(node));
+        return StaticType::INT;
+      default:
+        throw Unsupported{};
+    }
+  }
+
+  auto literal(const Literal* node) -> StaticType {
+    if (node->token.type == TokenType::IDENTIFIER) {
+      auto kind = local(node);
+      load(node->slot.index);
+      return kind;
+    }
+    if (node->token.type == TokenType::SELF)
+      throw Unsupported{};
+    if (node->value.is_bool()) {
+      emit({0xB8});                    // mov eax, imm32
+      emit32(node->value.as_bool());
+      return StaticType::BOOL;
+    }
+    if (!node->value.is_int())
+      throw Unsupported{};
+    emit({0x48, 0xB8});                // movabs rax, imm64
+    emit64(static_cast<uint64_t>(node->value.as_int()));
+    return StaticType::INT;
+  }
+
+  auto binary(const BinaryOp* node) -> StaticType {
+    using enum TokenType;
+    auto op = node->op.type;
+    if (op == AND || op == OR) {
+      expr(node->left.get());
+      to_bool();
+      auto done = jump({0x0F, static_cast<uint8_t>(op == AND ? 0x84 : 0x85)});  // jz / jnz
+      expr(node->right.get());
+      to_bool();
+      patch(done, here());
+      return StaticType::BOOL;
+    }
+
+    auto kind = expr(node->left.get());
+    push();
+    if (expr(node->right.get()) != kind) throw Unsupported{};
+    emit({0x48, 0x89, 0xC1});          // mov rcx, rax
+    pop();                             // left in rax, right in rcx
+
+    uint8_t setcc{};
+    switch (op) {
+      case EQUAL:            setcc = 0x94; break;
+      case NOT_EQUAL:        setcc = 0x95; break;
+      case LESSER_THAN:      setcc = 0x9C; break;
+      case GREATER_THAN:     setcc = 0x9F; break;
+      case LESSER_OR_EQUAL:  setcc = 0x9E; break;
+      case GREATER_OR_EQUAL: setcc = 0x9D; break;
+      default: break;
+    }
+    if (setcc) {
+      if (kind != StaticType::INT && op != EQUAL && op != NOT_EQUAL) throw Unsupported{};
+      emit({0x48, 0x39, 0xC8});        // cmp   rax, rcx
+      emit({0x0F, setcc, 0xC0});       // setcc al
+      emit({0x0F, 0xB6, 0xC0});        // movzx eax, al
+      return StaticType::BOOL;
+    }
+
+    if (kind != StaticType::INT) throw Unsupported{};
+    switch (op) {
+      case PLUS:  emit({0x48, 0x01, 0xC8});       break;  // add  rax, rcx
+      case MINUS: emit({0x48, 0x29, 0xC8});       break;  // sub  rax, rcx
+      case STAR:  emit({0x48, 0x0F, 0xAF, 0xC1}); break;  // imul rax, rcx
+      case SLASH: {
+        emit({0x48, 0x85, 0xC9});      // test rcx, rcx
+        _bails.push_back(jump({0x0F, 0x84}));
+        emit({0x48, 0x83, 0xF9, 0xFF});  // cmp rcx, -1
+        auto divide = jump({0x0F, 0x85});
+        emit({0x48, 0xBA});            // movabs rdx, INT64_MIN
+        emit64(uint64_t{1} << 63);
+        emit({0x48, 0x39, 0xD0});      // cmp rax, rdx
+        _bails.push_back(jump({0x0F, 0x84}));
+        patch(divide, here());
+        emit({0x48, 0x99});            // cqo
+        emit({0x48, 0xF7, 0xF9});      // idiv rcx
+        return StaticType::INT;
+      }
+      default:
+        throw Unsupported{};
+    }
+    _bails.push_back(jump({0x0F, 0x80}));  // jo
+    return StaticType::INT;
+  }
+
+  // Arguments are evaluated last to first so that, once pushed, they sit
+  // in order at rsp. Nothing here has side effects, so the order is not
+  // observable.
+  auto call(const FunctionCall* node) -> void {
+    if (node->id == "__index__")
+      throw Unsupported{};
+    for (auto it = node->exprs.rbegin(); it != node->exprs.rend(); ++it) {
+      if (expr(it->get()) != StaticType::INT) throw Unsupported{};
+      push();
+    }
+    auto pad = _pushed % 2 == 1;
+    emit({0x48, 0x89, 0xDF});          // mov    rdi, rbx
+    emit({0x48, 0xBE});                // movabs rsi, node
+    emit64(reinterpret_cast<uint64_t>(node));
+    emit({0x48, 0x89, 0xE2});          // mov    rdx, rsp
+    if (pad) emit({0x48, 0x83, 0xEC, 0x08});  // sub rsp, 8
+    emit({0x48, 0xB8});                // movabs rax, call_from_native
+    emit64(reinterpret_cast<uint64_t>(&call_from_native));
+    emit({0xFF, 0xD0});                // call   rax
+    auto drop = 8 * (node->exprs.size() + pad);
+    if (drop) {
+      emit({0x48, 0x81, 0xC4});        // add    rsp, drop
+      emit32(static_cast<int32_t>(drop));
+    }
+    _pushed -= static_cast<uint32_t>(node->exprs.size());
+    emit({0x80, 0x3B, 0x00});          // cmp    byte [rbx], 0
+    _bails.push_back(jump({0x0F, 0x85}));
+  }
+};
+
+auto compile(const FunctionDecl* fn) -> std::shared_ptr<NativeCode> {
+#if OLM_JIT
+  Codegen gen{fn};
+  std::vector<uint8_t> bytes;
+  try {
+    bytes = gen.translate();
+  } catch (const Unsupported&) {
+    return nullptr;
+  }
+
+  auto code  = std::make_shared<NativeCode>();
+  code->size = bytes.size();
+  auto* mem  = mmap(nullptr, code->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED)
+    return nullptr;
+  code->memory = mem;
+  std::memcpy(mem, bytes.data(), bytes.size());
+  if (mprotect(mem, code->size, PROT_READ | PROT_EXEC) != 0)
+    return nullptr;
+  code->entry        = reinterpret_cast<NativeCode::Entry>(mem);
+  code->returns_bool = gen.returns_bool();
+  return code;
+#else
+  (void)fn;
+  return nullptr;
+#endif
+}
+
+// Compiled code for 'fn', compiling it now if that was never tried.
+auto native_for(const FunctionDecl* fn) -> NativeCode* {
+  if (!fn->native && fn->calls <= Jit::HOT_CALLS) {
+    fn->calls  = Jit::HOT_CALLS + 1;
+    fn->native = compile(fn);
+  }
+  return fn->native.get();
+}
+}
+
+Jit::Jit(bool enabled) : _enabled(enabled && OLM_JIT) {}
+
+auto Jit::call(const FunctionDecl* fn, std::span<const Value> args, uint32_t generation) -> std::optional<Value> {
+  if (!_enabled)
+    return std::nullopt;
+  // Past HOT_CALLS without code means compiling was tried and failed.
+  if (!fn->native && (fn->calls > HOT_CALLS || ++fn->calls < HOT_CALLS))
+    return std::nullopt;
+  // Held for the whole run: a bailout below may drop fn->native.
+  auto code = native_for(fn) ? fn->native : nullptr;
+  if (!code || args.size() != fn->params.size())
+    return std::nullopt;
+
+  std::vector<int64_t> raw;
+  raw.reserve(args.size());
+  for (const auto& a : args) {
+    if (!a.is_int()) return std::nullopt;
+    raw.push_back(a.as_int());
+  }
+
+  JitContext ctx{.generation = generation};
+  auto result = code->entry(&ctx, raw.data());
+  if (ctx.bailed) {
+    if (++code->bailouts == MAX_BAILOUTS)
+      fn->native.reset();
+    return std::nullopt;
+  }
+  return code->returns_bool ? make(result != 0) : make(result);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include "nodes.h"
+#include "runtime_values.h"
+
+// Baseline JIT for the tree walker. After HOT_CALLS calls a top-level
+// function is translated to x86-64 by stitching one machine-code template
+// per node; calls leave the generated code through a runtime helper.
+// Only bodies over ints and booleans with no side effects are compiled
+// (locals, arithmetic, comparisons, 'si', 'mientras', calls to functions
+// of the same kind and to abs/max/min); anything else stays interpreted.
+//
+// Generated code never finishes a call it cannot handle (overflow,
+// division by zero, a callee it cannot run...): it bails out and the
+// interpreter runs the whole call again, which is safe because nothing it
+// did was visible. A function that keeps bailing out stays interpreted.
+class Jit final {
+public:
+  static constexpr uint32_t HOT_CALLS    = 100;
+  static constexpr uint32_t MAX_DEPTH    = 10'000;  // nested native calls per entry
+  static constexpr uint8_t  MAX_BAILOUTS = 4;
+
+  explicit Jit(bool enabled = true);
+
+  // Result of 'fn' over 'args' computed by native code, or nullopt when
+  // the interpreter has to run the call: not hot yet, not compilable, a
+  // non-int argument, or a bailout. 'generation' is the interpreter's,
+  // so only call sites it resolved for the current definitions are used.
+  auto call(const FunctionDecl* fn, std::span<const Value> args, uint32_t generation) -> std::optional<Value>;
+
+  // False on platforms without a code generator, whatever was requested.
+  auto enabled() const -> bool { return _enabled; }
+
+private:
+  bool _enabled;
+};
@@ -1,4 +1,8 @@
 #include <print>
+#include <charconv>
+#include <cstddef>
+#include <fstream>
+#include <string>
 #include <cstdlib>
 #include <stdexcept>
 #include <string_view>
@@ -6,9 +10,15 @@
 #include "nodes.h"
 #include "parser.h"
 #include "sema.h"
+#include "optimizer.h"
 #include "interpreter.h"
+#include "compiler.h"
+#include "vm.h"
+#include "transpiler.h"
 #include "utilities.h"
 #include "repl.h"
+#include "pool.h"
+#include "gc.h"
 
 constexpr char const* HELP_PANEL = R"#(
 --------------------------
@@ -16,9 +26,54 @@ Uso: ./olm
 Uso: ./olm -h
 Uso: ./olm --ayuda
 Uso: ./olm <archivo>
-Uso: ./olm --ast <archivo>
+Uso: ./olm --ast <archivo>      (arbol ya optimizado)
+Uso: ./olm --bytecode <archivo>
+Uso: ./olm --arbol <archivo>    (interprete de arbol, sin bytecode)
+Uso: ./olm --arbol --sin-jit <archivo>  (sin compilar funciones a codigo maquina)
+Uso: ./olm --cierres <archivo>  (interprete de arbol convertido a cierres)
+Uso: ./olm --memo <archivo>     (interprete de arbol; guarda resultados de funciones puras)
+Uso: ./olm --pila-max <n> <archivo>  (llamadas anidadas permitidas, 100000 por defecto, 1000000 como maximo)
+Uso: ./olm --memoria <archivo>  (uso de las losas de memoria al terminar)
+Uso: ./olm --gc-estadisticas <archivo>  (recolecciones de ciclos, pausas y bytes liberados)
+Uso: ./olm --compilar <archivo> [-o <salida.cpp>]  (traduce el programa a C++)
 --------------------------)#";
 
+// Prints the memo table counters when the run ends, with or without error.
+struct MemoReport final {
+  const Interpreter& interp;
+  bool               enabled;
+  ~MemoReport() {
+    if (!enabled) return;
+    auto stats = interp.memo_stats();
+    std::println(stderr, "memo: {} aciertos, {} fallos", stats.hits, stats.misses);
+  }
+};
+
+// Prints how full the Pool's slabs are when the run ends.
+struct PoolReport final {
+  bool enabled;
+  ~PoolReport() {
+    if (!enabled) return;
+    for (const auto& c : Pool::instance().stats())
+      std::println(stderr, "memoria: bloques de {:>3} B: {} en uso de {} ({:.1f}%), {} losa(s), {} reservas",
+                   c.block, c.live, c.capacity, 100.0 * static_cast<double>(c.live) / static_cast<double>(c.capacity),
+                   c.slabs, c.allocations);
+  }
+};
+
+// Prints what the cycle Collector did when the run ends.
+struct GcReport final {
+  bool enabled;
+  ~GcReport() {
+    if (!enabled) return;
+    const auto& stats = Collector::instance().stats();
+    auto us = [](std::chrono::nanoseconds ns) { return std::chrono::duration<double, std::micro>(ns).count(); };
+    std::println(stderr, "gc: {} recolecciones, {} objetos ({} B) liberados, pausa total {:.1f} us, maxima {:.1f} us",
+                 stats.collections, stats.reclaimed_objects, stats.reclaimed_bytes,
+                 us(stats.total_pause), us(stats.max_pause));
+  }
+};
+
 auto main(int argc, char** argv) -> int32_t {
   if (argc == 1) {
     Repl repl{};
@@ -27,7 +82,17 @@ auto main(int argc, char** argv) -> int32_t {
   }
 
   bool show_ast {};
+  bool show_bytecode {};
+  bool tree_walker {};
+  bool jit {true};
+  bool closures {};
+  bool memo {};
+  bool to_cpp {};
+  bool memory {};
+  bool gc_stats {};
+  std::size_t max_depth {DEFAULT_MAX_DEPTH};
   std::string_view filename{};
+  std::string output{};
 
   for (auto i{1}; i < argc; i++) {
     std::string_view s = argv[i];
@@ -36,9 +101,35 @@ auto main(int argc, char** argv) -> int32_t {
       exit(EXIT_SUCCESS);
     } else if (s == "--ast") {
       show_ast = true;
-    } else {
+    } else if (s == "--bytecode") {
+      show_bytecode = true;
+    } else if (s == "--arbol") {
+      tree_walker = true;
+    } else if (s == "--sin-jit") {
+      jit = false;
+    } else if (s == "--cierres") {
+      tree_walker = true;
+      closures    = true;
+    } else if (s == "--memo") {
+      tree_walker = true;
+      memo        = true;
+    } else if (s == "--memoria") {
+      memory = true;
+    } else if (s == "--gc-estadisticas") {
+      gc_stats = true;
+    } else if (s == "--compilar") {
+      to_cpp = true;
+    } else if (s == "--pila-max" && i + 1 < argc) {
+      std::string_view n = argv[++i];
+      auto [end, ec] = std::from_chars(n.data(), n.data() + n.size(), max_depth);
+      if (ec != std::errc{} || end != n.data() + n.size() || max_depth == 0 || max_depth > MAX_MAX_DEPTH) {
+        std::println(stderr, "Error: '--pila-max' espera un entero entre 1 y {}, no '{}'", MAX_MAX_DEPTH, n);
+        return EXIT_FAILURE;
+      }
+    } else if (s == "-o" && i + 1 < argc) {
+      output = argv[++i];
+    } else if (filename.empty()) {
       filename = s;
-      break;
     }
   }
 
@@ -58,11 +149,6 @@ auto main(int argc, char** argv) -> int32_t {
     return EXIT_FAILURE;
   }
 
-  if (show_ast) [[unlikely]] {
-    debug_see_nodetype(ast_buffer);
-    return EXIT_SUCCESS;
-  }
-
   try {
     Sema sema{};
     sema.analyze(ast_buffer);
@@ -70,9 +156,43 @@ auto main(int argc, char** argv) -> int32_t {
     std::println(stderr, "{}", e.what());
     return EXIT_FAILURE;
   }
+
+  Optimizer optimizer{};
+  optimizer.optimize(ast_buffer);
+  optimizer.prune(ast_buffer);
+  if (show_ast) [[unlikely]] {
+    debug_see_nodetype(ast_buffer);
+    return EXIT_SUCCESS;
+  }
+
+  PoolReport pool_report{memory};
+  GcReport   gc_report{gc_stats};
   try {
-    Interpreter interp;
-    interp.run(ast_buffer);
+    if (to_cpp) {
+      if (output.empty())
+        output = std::string(filename.substr(0, filename.rfind(".olm"))) + ".cpp";
+      auto code = Transpiler{}.translate(ast_buffer);
+      std::ofstream file{output};
+      if (!(file << code)) {
+        std::println(stderr, "Error: no se pudo escribir el archivo '{}'", output);
+        return EXIT_FAILURE;
+      }
+      return EXIT_SUCCESS;
+    }
+    if (tree_walker) {
+      Interpreter interp{{.jit = jit, .closures = closures, .memo = memo, .max_depth = max_depth}};
+      MemoReport  report{interp, memo};
+      interp.run(ast_buffer);
+      return EXIT_SUCCESS;
+    }
+    Compiler compiler;
+    auto program = compiler.compile(ast_buffer);
+    if (show_bytecode) [[unlikely]] {
+      debug_see_bytecode(program);
+      return EXIT_SUCCESS;
+    }
+    VM vm{program, max_depth};
+    vm.run();
   } catch (const RuntimeError& e) {
     std::println(stderr, "{}", e.what());
     return EXIT_FAILURE;
@@ -0,0 +1,71 @@
+#include "memo.h"
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <string>
+
+MemoTable::MemoTable() : _entries(CAPACITY) {}
+
+auto MemoTable::is_key(const Value& v) -> bool {
+  switch (v.type()) {
+    case ValueType::NIL:
+    case ValueType::INT:
+    case ValueType::FLOAT:
+    case ValueType::BOOL:
+    case ValueType::STRING: return true;
+    default:                return false;
+  }
+}
+
+// Same type and value; floats by bits, so 0.0 and -0.0 stay apart.
+auto MemoTable::same(const Value& a, const Value& b) -> bool {
+  if (a.type() != b.type()) return false;
+  switch (a.type()) {
+    case ValueType::INT:    return a.as_int() == b.as_int();
+    case ValueType::FLOAT:  return std::bit_cast<uint64_t>(a.as_float()) == std::bit_cast<uint64_t>(b.as_float());
+    case ValueType::BOOL:   return a.as_bool() == b.as_bool();
+    case ValueType::STRING: return a.as_string() == b.as_string();
+    default:                return true;
+  }
+}
+
+auto MemoTable::hash(const FunctionDecl* fn, std::span<const Value> args) -> std::size_t {
+  auto h = std::hash<const void*>{}(fn);
+  for (const auto& a : args) {
+    std::size_t v = 0;
+    switch (a.type()) {
+      case ValueType::INT:    v = std::hash<int64_t>{}(a.as_int()); break;
+      case ValueType::FLOAT:  v = std::hash<uint64_t>{}(std::bit_cast<uint64_t>(a.as_float())); break;
+      case ValueType::BOOL:   v = a.as_bool(); break;
+      case ValueType::STRING: v = std::hash<std::string>{}(a.as_string()); break;
+      default: break;
+    }
+    h ^= v + static_cast<std::size_t>(a.type()) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+  }
+  // Mix the high bits down: small ints hash to themselves.
+  h ^= h >> 29;
+  h *= 0xbf58476d1ce4e5b9;
+  h ^= h >> 32;
+  return h;
+}
+
+auto MemoTable::find(const FunctionDecl* fn, std::span<const Value> args) -> const Value* {
+  if (!std::ranges::all_of(args, is_key))
+    return nullptr;
+  const auto& e = _entries[hash(fn, args) % CAPACITY];
+  if (e.fn == fn && std::ranges::equal(e.args, args, same)) {
+    ++_stats.hits;
+    return &e.result;
+  }
+  ++_stats.misses;
+  return nullptr;
+}
+
+auto MemoTable::insert(const FunctionDecl* fn, std::span<const Value> args, const Value& result) -> void {
+  if (!is_key(result) || !std::ranges::all_of(args, is_key))
+    return;
+  auto& e  = _entries[hash(fn, args) % CAPACITY];
+  e.fn     = fn;
+  e.args.assign(args.begin(), args.end());
+  e.result = result;
+}
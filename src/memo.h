@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "nodes.h"
+#include "runtime_values.h"
+
+struct MemoStats final {
+  uint64_t hits{};
+  uint64_t misses{};
+};
+
+// Results of calls to functions Sema marked pure, keyed by the function
+// and its argument values. Direct mapped: a new result evicts whatever
+// shared its bucket, so memory stays bounded by CAPACITY entries. Only
+// calls whose arguments and result are scalars (null, numbers, booleans,
+// strings) are kept; arrays and instances can change after the call.
+class MemoTable final {
+public:
+  static constexpr std::size_t CAPACITY = 1 << 16;
+
+  MemoTable();
+
+  // Cached result of 'fn' over 'args', counting a hit or a miss; null
+  // without counting when the arguments cannot be a key.
+  auto find(const FunctionDecl* fn, std::span<const Value> args) -> const Value*;
+  auto insert(const FunctionDecl* fn, std::span<const Value> args, const Value& result) -> void;
+
+  auto stats() const -> const MemoStats& { return _stats; }
+
+  static auto is_key(const Value& v) -> bool;
+
+private:
+  struct Entry final {
+    const FunctionDecl* fn{};  // null when the bucket is empty
+    std::vector<Value>  args{};
+    Value               result{};
+  };
+
+  std::vector<Entry> _entries;
+  MemoStats          _stats{};
+
+  static auto hash(const FunctionDecl* fn, std::span<const Value> args) -> std::size_t;
+  static auto same(const Value& a, const Value& b)                      -> bool;
+};
@@ -1,7 +1,19 @@
 #include "nodes.h"
+#include <cstdint>
 #include <print>
+#include <string>
 #include <variant>
 
+auto literal_value(const Token& token) -> Value {
+  switch (token.type) {
+    case TokenType::INTEGER: return make(static_cast<int64_t>(std::stoll(token.literal)));
+    case TokenType::FLOAT:   return make(std::stod(token.literal));
+    case TokenType::BOOL:    return make(token.literal == "verdadero");
+    case TokenType::STRING:  return make(token.literal);
+    default:                 return make_null();
+  }
+}
+
 // UNUSED:
 
 auto debug_see_nodetype(const IAST* node, int indent) noexcept -> void {
@@ -182,6 +194,13 @@ auto debug_see_nodetype(const IAST* node, int indent) noexcept -> void {
       std::println("{})", pad);
       break;
     }
+    case NodeType::MEMBERACCESS: {
+      auto* x = static_cast<const MemberAccess*>(node);
+      std::println("{}MIEMBRO: .{} DE {{", pad, *x->field);
+      debug_see_nodetype(x->object.get(), indent + 2);
+      std::println("{}}}", pad);
+      break;
+    }
     case NodeType::CONTINUESTMT:{
        std::println("{}CONTINUAR", pad);
       break; 
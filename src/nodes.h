@@ -1,15 +1,19 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <variant>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <vector>
+#include "runtime_values.h"
 #include "tokens.h"
 #include "utilities.h"
 
 enum class NodeType {
   CLASSDECL, FUNCTIONDECL, VARIABLEDECL, ASSIGNMENT, LITERAL,
   UNARYOP, BINARYOP, WHILESTATEMENT, IFSTATEMENT, METHODCALL, INDEXEXPR,
-  RETURNSTATEMENT, FUNCTIONCALL, ARRAYDECL, CONTINUESTMT
+  RETURNSTATEMENT, FUNCTIONCALL, ARRAYDECL, CONTINUESTMT, MEMBERACCESS
 };
 
 struct IAST {
@@ -19,6 +23,16 @@ struct IAST {
   const SourceLocation loc{};
 };
 
+// Lexical address of a variable, filled in by Sema. 'depth' counts frames
+// outward from the one doing the access (0 = its own frame).
+struct VarSlot final {
+  static constexpr uint32_t UNRESOLVED = UINT32_MAX;
+  uint32_t depth{UNRESOLVED};
+  uint32_t index{};
+
+  auto resolved() const -> bool { return depth != UNRESOLVED; }
+};
+
 using ExprPtr    = std::unique_ptr<IAST>;
 using StmtsPtr   = std::vector<ExprPtr>;
 using ExprsPtr   = StmtsPtr;
@@ -41,37 +55,85 @@ struct NodeImpl : IAST {
 struct ClassDecl final : NodeImpl<NodeType::CLASSDECL> {
   std::string id{};
   StmtsPtr members{};
+  mutable VarSlot     slot{};
+  mutable const IAST* enclosing{};  // function the class is declared in, null at top level
   ClassDecl(std::string id, StmtsPtr members) : id(std::move(id)), members(std::move(members)){}
 };
 
+struct NativeCode;  // jit.cpp
+
 struct FunctionDecl final : NodeImpl<NodeType::FUNCTIONDECL> {
   std::string id{};
   ParamSlice params{};
   StmtsPtr body{};
+  mutable VarSlot     slot{};
+  mutable std::size_t frame_size{}; // parameters + every local of the body
+  mutable const IAST* enclosing{};  // function the declaration is nested in, null at top level
+  mutable bool        pure{};       // result depends only on the arguments, set by Sema
+  mutable uint32_t    calls{};      // counted by Jit up to the first compile attempt
+  mutable std::shared_ptr<NativeCode> native{};
 
   FunctionDecl(std::string id, ParamSlice params, StmtsPtr body)
   : id(std::move(id)), params(params), body(std::move(body)){}
 };
 
 struct Assignment final : NodeImpl<NodeType::ASSIGNMENT> {
+  static constexpr uint8_t MAX_APPENDS = 8;
+
   std::string id{};
   ExprPtr  target{};
   ExprPtr expr{};
+  // n for 'x se x + a1 + ... + an' where every addend is a constant or a
+  // variable, set by Sema: nothing runs between reading x and assigning
+  // it, so a string x refers to alone can be appended to in place.
+  mutable uint8_t appends{};
   Assignment(ExprPtr id, ExprPtr expr)
   : target(std::move(id)), expr(std::move(expr)){}
 
 };
 
+// What Sema proved about every value an expression or variable can hold;
+// UNKNOWN leaves the usual run-time tag checks in place.
+enum class StaticType : uint8_t { UNKNOWN, INT, FLOAT, BOOL, STRING, ARRAY, INSTANCE, NIL };
+
+// Two-operand site quickened by the interpreter for the operand types it
+// last saw: 'run' handles exactly that pair, or is null when only the
+// generic operator does. A site whose types keep changing stops
+// re-specializing after MAX_MISSES and stays generic.
+struct QuickSite final {
+  static constexpr uint8_t MAX_MISSES = 4;
+  using Fn = auto (*)(const Value&, const Value&) -> Value;
+
+  ValueType left{ValueType::UNBOUND};  // no operand is ever unbound
+  ValueType right{ValueType::UNBOUND};
+  uint8_t   misses{};
+  Fn        run{};
+};
+
+// Runtime value of a constant token (number, string, bool, nulo);
+// null for identifiers and 'este'.
+auto literal_value(const Token& token) -> Value;
+
+struct VariableDecl;
+
 struct Literal final : NodeImpl<NodeType::LITERAL> {
   Token token;
+  Value value{};           // built once here, shared by every evaluation
+  mutable VarSlot slot{};  // identifiers only
+  mutable const VariableDecl* decl{};  // variable the identifier names (not params or fields)
   Literal(Token token)
-  : token(token) {}
+  : token(token), value(literal_value(this->token)) {}
+  // A constant computed elsewhere (see Optimizer); 'token' only describes it.
+  Literal(Token token, Value value)
+  : NodeImpl(token.loc), token(std::move(token)), value(std::move(value)) {}
 };
 
 struct VariableDecl final : NodeImpl<NodeType::VARIABLEDECL> {
   bool is_const{};
   std::string id{};
   ExprPtr expr{};
+  mutable VarSlot slot{};
+  mutable StaticType type{};  // of every value ever stored in it
   VariableDecl(bool is_const, const std::string& id, ExprPtr expr):
     is_const(is_const), id(id), expr(std::move(expr)){}
 };
@@ -88,6 +150,8 @@ struct BinaryOp final : NodeImpl<NodeType::BINARYOP> {
   ExprPtr left;
   ExprPtr right;
   Token op;
+  mutable StaticType operands{};  // INT or FLOAT when both sides always are
+  mutable QuickSite quick{};
   BinaryOp(ExprPtr left, ExprPtr right, Token op)
   : left(std::move(left)), right(std::move(right)), op(std::move(op)) {}
 };
@@ -116,6 +180,7 @@ struct WhileStatement final : NodeImpl<NodeType::WHILESTATEMENT> {
 
 struct ReturnStatement final : NodeImpl<NodeType::RETURNSTATEMENT> {
   ExprPtr expr{};
+  mutable bool tail_call{};  // 'devolver f(...)' inside a function, set by Sema
   ReturnStatement(ExprPtr expr)
   : expr(std::move(expr)){}
 };
@@ -124,23 +189,80 @@ struct ReturnStatement final : NodeImpl<NodeType::RETURNSTATEMENT> {
 struct ContinueStatement final : NodeImpl<NodeType::CONTINUESTMT> { ContinueStatement() = default; };
  
 
+struct NativeMethodDesc;
+
+// What a call site's name resolved to when it last ran. 'generation' ties
+// the entry to the set of definitions in effect then; the interpreter moves
+// to a new generation whenever a name is rebound, which makes every cached
+// target stale at once.
+struct CallTarget final {
+  enum class Kind : uint8_t { UNRESOLVED, INDEX, BUILTIN, FUNCTION, CLASS };
+
+  Kind                             kind{Kind::UNRESOLVED};
+  uint32_t                         generation{};
+  const NativeMethodDesc*          builtin{};
+  const FunctionDecl*              function{};
+  const std::shared_ptr<ClassDef>* klass{};  // entry in Interpreter::_classes
+};
+
 struct FunctionCall final : NodeImpl<NodeType::FUNCTIONCALL> {
   std::string id{};
   ExprsPtr exprs{};
+  mutable CallTarget target{};
+  // FunctionDecl or ClassDecl the name refers to where the call is, set by
+  // Sema; null for builtins and for methods called by their bare name.
+  mutable const IAST* decl{};
 
   FunctionCall(std::string id, ExprsPtr exprs)
   : id(std::move(id)), exprs(std::move(exprs)){ }
 };
 
+// Per call site memory of where a method name led for a given receiver
+// kind: one entry is the common monomorphic case, up to SIZE polymorphic.
+// A site that sees more receivers than that stops caching new ones.
+struct InlineCache final {
+  struct Entry final {
+    ValueType               kind{};
+    const void*             klass{};   // ClassDecl of the receiver (instances only)
+    const FunctionDecl*     method{};
+    const NativeMethodDesc* native{};
+  };
+  static constexpr std::size_t SIZE = 4;
+
+  std::array<Entry, SIZE> entries{};
+  std::size_t             count{};
+
+  auto lookup(ValueType kind, const void* klass) const -> const Entry* {
+    for (auto i {0uz}; i < count; ++i)
+      if (entries[i].kind == kind && entries[i].klass == klass) return &entries[i];
+    return nullptr;
+  }
+  auto insert(const Entry& entry) -> void {
+    if (count < SIZE) entries[count++] = entry;
+  }
+};
+
 struct MethodCall final : NodeImpl<NodeType::METHODCALL> {
   ExprPtr     object{};
   std::string name{};
   ExprsPtr    args{};
+  mutable InlineCache cache{};
   MethodCall(ExprPtr object, std::string name, ExprsPtr args, SourceLocation loc = {})
     : NodeImpl(loc), object(std::move(object)),
       name(std::move(name)), args(std::move(args)) {}
 };
 
+// 'object.field' (not followed by a call; that is a MethodCall).
+struct MemberAccess final : NodeImpl<NodeType::MEMBERACCESS> {
+  ExprPtr            object{};
+  const std::string* field{};  // interned
+  // Slot of 'field' in the layout of the last class seen at this site.
+  mutable const ClassDecl* cached_class{};
+  mutable std::size_t      cached_slot{};
+  MemberAccess(ExprPtr object, std::string_view field, SourceLocation loc = {})
+    : NodeImpl(loc), object(std::move(object)), field(intern(field)) {}
+};
+
 struct ArrayDecl final : NodeImpl<NodeType::ARRAYDECL> {
   ExprsPtr data{};
   ArrayDecl(ExprsPtr data): data(std::move(data)) { }
@@ -150,6 +272,7 @@ struct ArrayDecl final : NodeImpl<NodeType::ARRAYDECL> {
 struct IndexExpr final : NodeImpl<NodeType::INDEXEXPR> {
   ExprPtr object;
   ExprPtr index;
+  mutable QuickSite quick{};
 
   IndexExpr(ExprPtr obj, ExprPtr idx)
     : object(std::move(obj)), index(std::move(idx)) {}
@@ -0,0 +1,294 @@
+#include "operators.h"
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <limits>
+#include <string>
+#include "error_manager.h"
+
+namespace {
+using enum ValueType;
+
+// Both operand types in one switchable key.
+constexpr auto both(ValueType l, ValueType r) -> unsigned {
+  return static_cast<unsigned>(l) << 4 | static_cast<unsigned>(r);
+}
+
+[[noreturn]] auto not_numeric(const Value& lv, const Value& rv, std::string_view op) -> void {
+  const auto& bad = (lv.is_int() || lv.is_float()) ? rv : lv;
+  throw RuntimeError(std::format("operador '{}' requiere numeros, obtuvo '{}'", op, bad.to_string()));
+}
+
+[[noreturn]] auto overflow(std::string_view op) -> void {
+  throw RuntimeError(std::format("desbordamiento de entero en '{}'", op));
+}
+
+// int op int stays in 64-bit integers and reports overflow; any float
+// operand promotes the other one.
+template <class IntOp, class FloatOp>
+auto arith(const Value& lv, const Value& rv, std::string_view op, IntOp int_op, FloatOp float_op) -> Value {
+  switch (both(lv.type(), rv.type())) {
+    case both(INT, INT): {
+      int64_t out;
+      if (int_op(lv.as_int(), rv.as_int(), &out))
+        overflow(op);
+      return make(out);
+    }
+    case both(INT, FLOAT):   return make(float_op(static_cast<double>(lv.as_int()), rv.as_float()));
+    case both(FLOAT, INT):   return make(float_op(lv.as_float(), static_cast<double>(rv.as_int())));
+    case both(FLOAT, FLOAT): return make(float_op(lv.as_float(), rv.as_float()));
+    default:                 not_numeric(lv, rv, op);
+  }
+}
+
+template <class Cmp>
+auto compare(const Value& lv, const Value& rv, std::string_view op, Cmp cmp) -> bool {
+  switch (both(lv.type(), rv.type())) {
+    case both(INT, INT):     return cmp(lv.as_int(), rv.as_int());
+    case both(INT, FLOAT):   return cmp(static_cast<double>(lv.as_int()), rv.as_float());
+    case both(FLOAT, INT):   return cmp(lv.as_float(), static_cast<double>(rv.as_int()));
+    case both(FLOAT, FLOAT): return cmp(lv.as_float(), rv.as_float());
+    default:                 not_numeric(lv, rv, op);
+  }
+}
+
+auto divide(const Value& lv, const Value& rv) -> Value {
+  if ((rv.is_int() && rv.as_int() == 0) || (rv.is_float() && rv.as_float() == 0.0))
+    throw RuntimeError("division por cero");
+  return arith(lv, rv, "/",
+    [](int64_t a, int64_t b, int64_t* out) {
+      if (a == std::numeric_limits<int64_t>::min() && b == -1) return true;
+      *out = a / b;
+      return false;
+    },
+    std::divides<double>{});
+}
+
+auto equal_as(const Value& lv, const Value& rv, std::string_view op) -> bool {
+  switch (both(lv.type(), rv.type())) {
+    case both(INT, INT):       return lv.as_int()    == rv.as_int();
+    case both(BOOL, BOOL):     return lv.as_bool()   == rv.as_bool();
+    case both(STRING, STRING): return lv.as_string() == rv.as_string();
+    case both(NIL, NIL):       return true;
+    default:
+      if (lv.is_float() || rv.is_float())
+        return compare(lv, rv, op, std::equal_to<>{});
+      return false;
+  }
+}
+}
+
+auto values_equal(const Value& lv, const Value& rv) -> bool {
+  return equal_as(lv, rv, "=");
+}
+
+auto unique_string(const Value& v) -> bool {
+  auto* str = std::get_if<StringPtr>(&v.inner);
+  return str && str->use_count() == 1;
+}
+
+auto append_to(std::string& str, const Value& addend) -> void {
+  if (addend.is_string()) str += addend.as_string();
+  else                    str += addend.to_string();
+}
+
+auto binary_op(TokenType op, const Value& lv, const Value& rv) -> Value {
+  using enum TokenType;
+  switch (op) {
+    case PLUS:
+      if (lv.is_string() || rv.is_string())
+        return make(lv.to_string() + rv.to_string());
+      return arith(lv, rv, "+",
+        [](int64_t a, int64_t b, int64_t* out) { return __builtin_add_overflow(a, b, out); },
+        std::plus<double>{});
+    case MINUS:
+      return arith(lv, rv, "-",
+        [](int64_t a, int64_t b, int64_t* out) { return __builtin_sub_overflow(a, b, out); },
+        std::minus<double>{});
+    case STAR:
+      return arith(lv, rv, "*",
+        [](int64_t a, int64_t b, int64_t* out) { return __builtin_mul_overflow(a, b, out); },
+        std::multiplies<double>{});
+    case SLASH:
+      return divide(lv, rv);
+    case EQUAL:
+      return make(equal_as(lv, rv, "=="));
+    case NOT_EQUAL:
+      return make(!equal_as(lv, rv, "!="));
+    case LESSER_THAN:      return make(compare(lv, rv, "<",  std::less<>{}));
+    case GREATER_THAN:     return make(compare(lv, rv, ">",  std::greater<>{}));
+    case LESSER_OR_EQUAL:  return make(compare(lv, rv, "<=", std::less_equal<>{}));
+    case GREATER_OR_EQUAL: return make(compare(lv, rv, ">=", std::greater_equal<>{}));
+    default:
+      throw RuntimeError("operador binario desconocido");
+  }
+}
+
+namespace {
+// One operator over two ints or two floats, chosen at compile time so a
+// quickened site (see specialize_binary) runs straight-line code.
+template <TokenType Op>
+auto int_apply(int64_t lv, int64_t rv) -> Value {
+  using enum TokenType;
+  int64_t out;
+  if constexpr (Op == PLUS) {
+    if (__builtin_add_overflow(lv, rv, &out)) overflow("+");
+    return make(out);
+  } else if constexpr (Op == MINUS) {
+    if (__builtin_sub_overflow(lv, rv, &out)) overflow("-");
+    return make(out);
+  } else if constexpr (Op == STAR) {
+    if (__builtin_mul_overflow(lv, rv, &out)) overflow("*");
+    return make(out);
+  } else if constexpr (Op == SLASH) {
+    if (rv == 0) throw RuntimeError("division por cero");
+    if (lv == std::numeric_limits<int64_t>::min() && rv == -1) overflow("/");
+    return make(lv / rv);
+  }
+  else if constexpr (Op == EQUAL)            return make(lv == rv);
+  else if constexpr (Op == NOT_EQUAL)        return make(lv != rv);
+  else if constexpr (Op == LESSER_THAN)      return make(lv <  rv);
+  else if constexpr (Op == GREATER_THAN)     return make(lv >  rv);
+  else if constexpr (Op == LESSER_OR_EQUAL)  return make(lv <= rv);
+  else if constexpr (Op == GREATER_OR_EQUAL) return make(lv >= rv);
+}
+
+template <TokenType Op>
+auto float_apply(double lv, double rv) -> Value {
+  using enum TokenType;
+  if constexpr (Op == PLUS)       return make(lv + rv);
+  else if constexpr (Op == MINUS) return make(lv - rv);
+  else if constexpr (Op == STAR)  return make(lv * rv);
+  else if constexpr (Op == SLASH) {
+    if (rv == 0.0) throw RuntimeError("division por cero");
+    return make(lv / rv);
+  }
+  else if constexpr (Op == EQUAL)            return make(lv == rv);
+  else if constexpr (Op == NOT_EQUAL)        return make(lv != rv);
+  else if constexpr (Op == LESSER_THAN)      return make(lv <  rv);
+  else if constexpr (Op == GREATER_THAN)     return make(lv >  rv);
+  else if constexpr (Op == LESSER_OR_EQUAL)  return make(lv <= rv);
+  else if constexpr (Op == GREATER_OR_EQUAL) return make(lv >= rv);
+}
+
+// Runs f.template operator()<Op>() with 'op' as a compile-time constant.
+template <class F>
+auto with_op(TokenType op, F f) -> decltype(auto) {
+  using enum TokenType;
+  switch (op) {
+    case PLUS:             return f.template operator()<PLUS>();
+    case MINUS:            return f.template operator()<MINUS>();
+    case STAR:             return f.template operator()<STAR>();
+    case SLASH:            return f.template operator()<SLASH>();
+    case EQUAL:            return f.template operator()<EQUAL>();
+    case NOT_EQUAL:        return f.template operator()<NOT_EQUAL>();
+    case LESSER_THAN:      return f.template operator()<LESSER_THAN>();
+    case GREATER_THAN:     return f.template operator()<GREATER_THAN>();
+    case LESSER_OR_EQUAL:  return f.template operator()<LESSER_OR_EQUAL>();
+    case GREATER_OR_EQUAL: return f.template operator()<GREATER_OR_EQUAL>();
+    default:
+      throw RuntimeError("operador binario desconocido");
+  }
+}
+
+auto concat(const Value& lv, const Value& rv) -> Value {
+  return make(lv.as_string() + rv.as_string());
+}
+
+auto strings_equal(const Value& lv, const Value& rv) -> Value {
+  return make(lv.as_string() == rv.as_string());
+}
+
+auto array_at(const Value& obj, const Value& idx) -> Value {
+  const auto& arr = obj.as_array();
+  auto i = idx.as_int();
+  if (i < 0 || i >= static_cast<int64_t>(arr.size()))
+    throw RuntimeError("indice fuera de rango");
+  return arr[i];
+}
+}
+
+auto int_binary_op(TokenType op, int64_t lv, int64_t rv) -> Value {
+  return with_op(op, [&]<TokenType Op> { return int_apply<Op>(lv, rv); });
+}
+
+auto float_binary_op(TokenType op, double lv, double rv) -> Value {
+  return with_op(op, [&]<TokenType Op> { return float_apply<Op>(lv, rv); });
+}
+
+auto specialize_binary(TokenType op, ValueType lt, ValueType rt) -> BinaryFn {
+  switch (both(lt, rt)) {
+    case both(INT, INT):
+      return with_op(op, []<TokenType Op> () -> BinaryFn {
+        return [](const Value& lv, const Value& rv) { return int_apply<Op>(lv.as_int(), rv.as_int()); };
+      });
+    case both(FLOAT, FLOAT):
+      return with_op(op, []<TokenType Op> () -> BinaryFn {
+        return [](const Value& lv, const Value& rv) { return float_apply<Op>(lv.as_float(), rv.as_float()); };
+      });
+    case both(STRING, STRING):
+      if (op == TokenType::PLUS)  return concat;
+      if (op == TokenType::EQUAL) return strings_equal;
+      return nullptr;
+    default:
+      return nullptr;
+  }
+}
+
+auto specialize_index(ValueType obj, ValueType idx) -> BinaryFn {
+  return both(obj, idx) == both(ARRAY, INT) ? array_at : nullptr;
+}
+
+auto unary_op(TokenType op, const Value& val) -> Value {
+  switch (op) {
+    case TokenType::MINUS:
+      if (val.is_int()) {
+        if (val.as_int() == std::numeric_limits<int64_t>::min())
+          overflow("-");
+        return make(-val.as_int());
+      }
+      if (val.is_float()) return make(-val.as_float());
+      throw RuntimeError("'-' unario requiere un numero");
+    case TokenType::BANG:
+      return make(!val.truthy());
+    default:
+      throw RuntimeError("operador unario desconocido");
+  }
+}
+
+auto index_value(const Value& obj, const Value& idx) -> Value {
+  if (!idx.is_int())
+    throw RuntimeError("el indice debe ser entero");
+
+  auto i = idx.as_int();
+
+  if (obj.is_array()) {
+    auto& arr = obj.as_array();
+    if (i < 0 || i >= static_cast<int64_t>(arr.size()))
+      throw RuntimeError("indice fuera de rango");
+    return arr[i];
+  } else if (obj.is_string()) {
+    const auto& s = obj.as_string();
+    if (i < 0 || i >= static_cast<int64_t>(s.size()))
+      throw RuntimeError("indice fuera de rango");
+    return make(std::string(1, s[i]));
+  }
+
+  throw RuntimeError("solo se puede indexar array o string");
+}
+
+auto assign_index(Value& obj, const Value& idx, Value val) -> void {
+  if (!obj.is_array())
+    throw RuntimeError("solo se puede indexar arreglos");
+
+  else if (!idx.is_int())
+    throw RuntimeError("indice debe ser entero");
+
+  auto& arr = obj.as_array();
+  auto i = idx.as_int();
+
+  if (i < 0 || i >= (int64_t)arr.size())
+    throw RuntimeError("indice fuera de rango");
+
+  arr[i] = std::move(val);
+}
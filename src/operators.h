@@ -0,0 +1,29 @@
+#pragma once
+#include "runtime_values.h"
+#include "tokens.h"
+
+// Operator semantics shared by the tree walker and the bytecode VM.
+// 'y' / 'o' are not here: both backends short-circuit them on their own.
+
+auto binary_op(TokenType op, const Value& lv, const Value& rv) -> Value;
+// Same results as binary_op for operands already known to be both ints or
+// both floats (see BinaryOp::operands); no tag dispatch.
+auto int_binary_op(TokenType op, int64_t lv, int64_t rv)        -> Value;
+auto float_binary_op(TokenType op, double lv, double rv)         -> Value;
+// Routine for one operator over one pair of operand types, or null when
+// binary_op must handle them. The caller checks the types first.
+using BinaryFn = auto (*)(const Value&, const Value&) -> Value;
+auto specialize_binary(TokenType op, ValueType lt, ValueType rt)  -> BinaryFn;
+auto unary_op(TokenType op, const Value& val)                     -> Value;
+auto values_equal(const Value& lv, const Value& rv)            -> bool;
+
+// Whether 'v' is a string no other Value refers to, which 'v se v + ...'
+// may then extend in place (see Assignment::appends).
+auto unique_string(const Value& v)                                   -> bool;
+// What 'str + addend' adds to the string 'str'.
+auto append_to(std::string& str, const Value& addend)                -> void;
+
+auto index_value(const Value& obj, const Value& idx)                 -> Value;
+// Like specialize_binary, for obj[idx].
+auto specialize_index(ValueType obj, ValueType idx)                  -> BinaryFn;
+auto assign_index(Value& obj, const Value& idx, Value val)  -> void;
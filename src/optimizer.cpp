@@ -0,0 +1,416 @@
+#include "optimizer.h"
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+#include "error_manager.h"
+#include "operators.h"
+
+using enum NodeType;
+
+// Value of 'node' if it is a literal constant (not an identifier or 'este').
+static auto constant_of(const IAST* node) -> const Value* {
+  if (!node || node->node_type != LITERAL)
+    return nullptr;
+  auto* lit = static_cast<const Literal*>(node);
+  switch (lit->token.type) {
+    case TokenType::INTEGER:
+    case TokenType::FLOAT:
+    case TokenType::BOOL:
+    case TokenType::STRING:
+    case TokenType::NIL:
+      return &lit->value;
+    default:
+      return nullptr;
+  }
+}
+
+// Literal node for a computed value; null for values no literal can spell.
+static auto make_literal(Value value, SourceLocation loc) -> ExprPtr {
+  TokenType type{};
+  switch (value.type()) {
+    case ValueType::INT:    type = TokenType::INTEGER; break;
+    case ValueType::FLOAT:  type = TokenType::FLOAT;   break;
+    case ValueType::BOOL:   type = TokenType::BOOL;    break;
+    case ValueType::STRING: type = TokenType::STRING;  break;
+    case ValueType::NIL:    type = TokenType::NIL;     break;
+    default:                return nullptr;
+  }
+  auto text = value.to_string();
+  return std::make_unique<Literal>(Token{type, text, loc}, std::move(value));
+}
+
+// Folding must not change what the program does, so an operation that
+// would fail (division by zero, overflow, bad operand types) is left for
+// the backend to report when, and if, it runs.
+template <typename Op>
+static auto try_fold(ExprPtr& node, Op&& op) -> void {
+  try {
+    if (auto lit = make_literal(op(), node->loc))
+      node = std::move(lit);
+  } catch (const RuntimeError&) {}
+}
+
+// Whether hoisting 'body' out of its block would put a name in the
+// surrounding scope.
+static auto declares(const StmtsPtr& body) -> bool {
+  for (const auto& stmt : body) {
+    auto type = stmt->node_type;
+    if (type == VARIABLEDECL || type == FUNCTIONDECL || type == CLASSDECL)
+      return true;
+  }
+  return false;
+}
+
+// Appends a block that is known to run. Its statements are spliced in when
+// that keeps every name where it was; otherwise the block stays a block.
+static auto emit_block(StmtsPtr body, StmtsPtr& out) -> void {
+  if (!declares(body)) {
+    for (auto& stmt : body)
+      out.push_back(std::move(stmt));
+    return;
+  }
+  auto always = make_literal(make(true), {});
+  out.push_back(std::make_unique<IfStatement>(std::move(always), std::move(body)));
+}
+
+// Nothing after a 'devolver' or 'continuar' in the same block can run.
+static auto ends_block(const StmtsPtr& stmts) -> bool {
+  if (stmts.empty()) return false;
+  auto type = stmts.back()->node_type;
+  return type == RETURNSTATEMENT || type == CONTINUESTMT;
+}
+
+auto Optimizer::optimize(StmtsPtr& program) -> void {
+  fold_stmts(program);
+}
+
+auto Optimizer::fold_stmts(StmtsPtr& stmts) -> void {
+  StmtsPtr out;
+  out.reserve(stmts.size());
+  for (auto& stmt : stmts) {
+    fold_stmt(std::move(stmt), out);
+    if (ends_block(out)) break;
+  }
+  stmts = std::move(out);
+}
+
+auto Optimizer::fold_stmt(ExprPtr stmt, StmtsPtr& out) -> void {
+  if (!stmt) return;
+  switch (stmt->node_type) {
+    case VARIABLEDECL:
+      fold_expr(static_cast<VariableDecl*>(stmt.get())->expr);
+      break;
+    case FUNCTIONDECL:
+      fold_stmts(static_cast<FunctionDecl*>(stmt.get())->body);
+      break;
+    case CLASSDECL:
+      fold_stmts(static_cast<ClassDecl*>(stmt.get())->members);
+      break;
+    case ASSIGNMENT: {
+      auto* node = static_cast<Assignment*>(stmt.get());
+      // The target is a place, not a value: only its subexpressions fold.
+      if (node->target->node_type == MEMBERACCESS) {
+        fold_expr(static_cast<MemberAccess*>(node->target.get())->object);
+      } else if (node->target->node_type == INDEXEXPR) {
+        auto* idx = static_cast<IndexExpr*>(node->target.get());
+        fold_expr(idx->object);
+        fold_expr(idx->index);
+      }
+      fold_expr(node->expr);
+      break;
+    }
+    case IFSTATEMENT:
+      return fold_if(std::unique_ptr<IfStatement>(static_cast<IfStatement*>(stmt.release())), out);
+    case WHILESTATEMENT: {
+      auto* node = static_cast<WhileStatement*>(stmt.get());
+      fold_expr(node->condition);
+      if (auto* cond = constant_of(node->condition.get()); cond && !cond->truthy())
+        return;
+      fold_stmts(node->body);
+      break;
+    }
+    case RETURNSTATEMENT:
+      fold_expr(static_cast<ReturnStatement*>(stmt.get())->expr);
+      break;
+    case FUNCTIONCALL:
+    case METHODCALL:
+      fold_expr(stmt);
+      break;
+    default: break;
+  }
+  out.push_back(std::move(stmt));
+}
+
+auto Optimizer::fold_if(std::unique_ptr<IfStatement> node, StmtsPtr& out) -> void {
+  fold_expr(node->condition);
+  fold_stmts(node->then_body);
+
+  if (auto* els = std::get_if<StmtsPtr>(&node->next)) {
+    fold_stmts(*els);
+  } else if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&node->next)) {
+    StmtsPtr rest;
+    fold_if(std::move(*elif), rest);
+    if (rest.empty())
+      node->next = std::monostate{};
+    else if (rest.size() == 1 && rest.front()->node_type == IFSTATEMENT)
+      node->next = std::unique_ptr<IfStatement>(static_cast<IfStatement*>(rest.front().release()));
+    else
+      node->next = std::move(rest);
+  }
+
+  auto* cond = constant_of(node->condition.get());
+  if (!cond)
+    return out.push_back(std::move(node));
+
+  if (cond->truthy())
+    return emit_block(std::move(node->then_body), out);
+  if (auto* els = std::get_if<StmtsPtr>(&node->next))
+    return emit_block(std::move(*els), out);
+  if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&node->next))
+    out.push_back(std::move(*elif));
+}
+
+auto Optimizer::fold_expr(ExprPtr& node) -> void {
+  if (!node) return;
+  switch (node->node_type) {
+    case LITERAL: {
+      auto* lit = static_cast<Literal*>(node.get());
+      if (!lit->decl || !lit->decl->is_const) break;
+      // The declaration was folded first, since it comes before any use.
+      if (auto* value = constant_of(lit->decl->expr.get()))
+        node = make_literal(*value, node->loc);
+      break;
+    }
+    case BINARYOP:
+      fold_binary(node);
+      break;
+    case UNARYOP: {
+      auto* un = static_cast<UnaryOp*>(node.get());
+      fold_expr(un->operand);
+      if (auto* value = constant_of(un->operand.get()))
+        try_fold(node, [&] { return unary_op(un->op, *value); });
+      break;
+    }
+    case FUNCTIONCALL:
+      for (auto& arg : static_cast<FunctionCall*>(node.get())->exprs)
+        fold_expr(arg);
+      break;
+    case METHODCALL: {
+      auto* call = static_cast<MethodCall*>(node.get());
+      fold_expr(call->object);
+      for (auto& arg : call->args)
+        fold_expr(arg);
+      break;
+    }
+    case ARRAYDECL:
+      for (auto& el : static_cast<ArrayDecl*>(node.get())->data)
+        fold_expr(el);
+      break;
+    case INDEXEXPR: {
+      auto* idx = static_cast<IndexExpr*>(node.get());
+      fold_expr(idx->object);
+      fold_expr(idx->index);
+      auto* obj = constant_of(idx->object.get());
+      auto* key = constant_of(idx->index.get());
+      if (obj && key)
+        try_fold(node, [&] { return index_value(*obj, *key); });
+      break;
+    }
+    case MEMBERACCESS:
+      fold_expr(static_cast<MemberAccess*>(node.get())->object);
+      break;
+    default: break;
+  }
+}
+
+// 'y' / 'o' yield a bool and skip their right side when the left decides,
+// so a constant left operand either settles them or reduces them to a
+// truthiness test of the right one, which is kept as is.
+auto Optimizer::fold_binary(ExprPtr& node) -> void {
+  auto* bin = static_cast<BinaryOp*>(node.get());
+  fold_expr(bin->left);
+  fold_expr(bin->right);
+
+  auto* lv = constant_of(bin->left.get());
+  auto* rv = constant_of(bin->right.get());
+  auto  op = bin->op.type;
+
+  if (op == TokenType::AND || op == TokenType::OR) {
+    if (!lv) return;
+    bool decides = op == TokenType::AND ? !lv->truthy() : lv->truthy();
+    if (decides)
+      node = make_literal(make(op == TokenType::OR), node->loc);
+    else if (rv)
+      node = make_literal(make(rv->truthy()), node->loc);
+    return;
+  }
+  if (lv && rv)
+    try_fold(node, [&] { return binary_op(op, *lv, *rv); });
+}
+
+namespace {
+
+// Call graph walk for Optimizer::prune. A top-level declaration is live
+// once its name appears in live code, whether called or just read; a
+// method of a live class is live once some live code invokes a method of
+// that name (receivers are not known statically), and 'crear' always is.
+class Reachability final {
+public:
+  explicit Reachability(const StmtsPtr& program) {
+    for (const auto& stmt : program) {
+      if (stmt->node_type == FUNCTIONDECL)
+        _decls.try_emplace(static_cast<const FunctionDecl*>(stmt.get())->id, stmt.get());
+      else if (stmt->node_type == CLASSDECL)
+        _decls.try_emplace(static_cast<const ClassDecl*>(stmt.get())->id, stmt.get());
+    }
+    for (const auto& stmt : program)
+      if (stmt->node_type != FUNCTIONDECL && stmt->node_type != CLASSDECL)
+        _pending.push_back(stmt.get());
+
+    while (!_pending.empty()) {
+      auto* node = _pending.back();
+      _pending.pop_back();
+      scan(node);
+    }
+  }
+
+  auto live(const IAST* node) const -> bool { return _live.contains(node); }
+
+private:
+  std::unordered_map<std::string_view, const IAST*> _decls{};
+  std::unordered_set<std::string_view>              _invoked{};
+  std::unordered_set<const IAST*>                   _live{};
+  std::vector<const ClassDecl*>                     _classes{};
+  std::vector<const IAST*>                          _pending{};
+
+  auto mark(const IAST* node) -> void {
+    if (_live.insert(node).second)
+      _pending.push_back(node);
+  }
+
+  auto reference(std::string_view name) -> void {
+    auto it = _decls.find(name);
+    if (it == _decls.end() || _live.contains(it->second)) return;
+    mark(it->second);
+    if (it->second->node_type == CLASSDECL)
+      open_class(static_cast<const ClassDecl*>(it->second));
+  }
+
+  auto invoke(std::string_view name) -> void {
+    if (!_invoked.insert(name).second) return;
+    for (auto* klass : _classes)
+      for (const auto& m : klass->members)
+        if (is_method(m.get(), name)) mark(m.get());
+  }
+
+  auto open_class(const ClassDecl* klass) -> void {
+    _classes.push_back(klass);
+    for (const auto& m : klass->members) {
+      if (m->node_type == VARIABLEDECL)
+        mark(m.get());
+      else if (is_method(m.get(), "crear"))
+        mark(m.get());
+      else if (m->node_type == FUNCTIONDECL && _invoked.contains(static_cast<const FunctionDecl*>(m.get())->id))
+        mark(m.get());
+    }
+  }
+
+  static auto is_method(const IAST* node, std::string_view name) -> bool {
+    return node->node_type == FUNCTIONDECL && static_cast<const FunctionDecl*>(node)->id == name;
+  }
+
+  auto scan_all(const StmtsPtr& nodes) -> void {
+    for (const auto& n : nodes) scan(n.get());
+  }
+
+  auto scan(const IAST* node) -> void {
+    if (!node) return;
+    switch (node->node_type) {
+      case LITERAL: {
+        auto* lit = static_cast<const Literal*>(node);
+        if (lit->token.type == TokenType::IDENTIFIER) reference(lit->token.literal);
+        break;
+      }
+      case FUNCTIONCALL: {
+        auto* call = static_cast<const FunctionCall*>(node);
+        reference(call->id);
+        scan_all(call->exprs);
+        break;
+      }
+      case METHODCALL: {
+        auto* call = static_cast<const MethodCall*>(node);
+        invoke(call->name);
+        scan(call->object.get());
+        scan_all(call->args);
+        break;
+      }
+      case FUNCTIONDECL: scan_all(static_cast<const FunctionDecl*>(node)->body);   break;
+      case CLASSDECL: {
+        // Top-level classes have their members marked one by one instead.
+        auto* klass = static_cast<const ClassDecl*>(node);
+        if (auto it = _decls.find(klass->id); it == _decls.end() || it->second != node)
+          scan_all(klass->members);
+        break;
+      }
+      case VARIABLEDECL: scan(static_cast<const VariableDecl*>(node)->expr.get()); break;
+      case ASSIGNMENT: {
+        auto* as = static_cast<const Assignment*>(node);
+        scan(as->target.get());
+        scan(as->expr.get());
+        break;
+      }
+      case BINARYOP: {
+        auto* bin = static_cast<const BinaryOp*>(node);
+        scan(bin->left.get());
+        scan(bin->right.get());
+        break;
+      }
+      case UNARYOP:         scan(static_cast<const UnaryOp*>(node)->operand.get());        break;
+      case RETURNSTATEMENT: scan(static_cast<const ReturnStatement*>(node)->expr.get());   break;
+      case MEMBERACCESS:    scan(static_cast<const MemberAccess*>(node)->object.get());    break;
+      case ARRAYDECL:       scan_all(static_cast<const ArrayDecl*>(node)->data);            break;
+      case INDEXEXPR: {
+        auto* idx = static_cast<const IndexExpr*>(node);
+        scan(idx->object.get());
+        scan(idx->index.get());
+        break;
+      }
+      case WHILESTATEMENT: {
+        auto* loop = static_cast<const WhileStatement*>(node);
+        scan(loop->condition.get());
+        scan_all(loop->body);
+        break;
+      }
+      case IFSTATEMENT: {
+        auto* branch = static_cast<const IfStatement*>(node);
+        scan(branch->condition.get());
+        scan_all(branch->then_body);
+        if (auto* els = std::get_if<StmtsPtr>(&branch->next))
+          scan_all(*els);
+        else if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&branch->next))
+          scan(elif->get());
+        break;
+      }
+      default: break;
+    }
+  }
+};
+
+} // namespace
+
+auto Optimizer::prune(StmtsPtr& program) -> void {
+  Reachability graph{program};
+  std::erase_if(program, [&](const ExprPtr& stmt) {
+    auto type = stmt->node_type;
+    if (type != FUNCTIONDECL && type != CLASSDECL) return false;
+    if (!graph.live(stmt.get())) return true;
+    if (type == CLASSDECL)
+      std::erase_if(static_cast<ClassDecl*>(stmt.get())->members, [&](const ExprPtr& m) {
+        return m->node_type == FUNCTIONDECL && !graph.live(m.get());
+      });
+    return false;
+  });
+}
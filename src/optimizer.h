@@ -0,0 +1,25 @@
+#pragma once
+#include "nodes.h"
+
+// Rewrites an analyzed program in place before either backend sees it:
+// operators over constants become literals, identifiers bound by 'const'
+// to a literal are replaced by it, 'si'/'mientras' whose condition is
+// known are reduced to the branch that can run, and statements after a
+// 'devolver' or 'continuar' are dropped. Relies on Sema's annotations
+// (Literal::decl), so it must run after Sema::analyze.
+class Optimizer final {
+public:
+  auto optimize(StmtsPtr& program) -> void;
+
+  // Removes top-level functions and classes, and methods of the classes
+  // kept, that nothing the program runs can reach. Only for complete
+  // programs: the REPL may still call them from a later line.
+  auto prune(StmtsPtr& program) -> void;
+
+private:
+  auto fold_stmts(StmtsPtr& stmts)                                -> void;
+  auto fold_stmt(ExprPtr stmt, StmtsPtr& out)                     -> void;
+  auto fold_if(std::unique_ptr<IfStatement> node, StmtsPtr& out)  -> void;
+  auto fold_expr(ExprPtr& node)                                   -> void;
+  auto fold_binary(ExprPtr& node)                                 -> void;
+};
@@ -133,7 +133,7 @@ auto Parser::parse_assignment_or_call() -> ExprPtr {
       auto* lit = static_cast<Literal*>(expr.get());
       if (lit->token.type != TokenType::IDENTIFIER)
         error("El lado izquierdo debe ser identificador o acceso");
-    } else if (expr->node_type != NodeType::INDEXEXPR) {
+    } else if (expr->node_type != NodeType::INDEXEXPR && expr->node_type != NodeType::MEMBERACCESS) {
       error("Lado izquierdo inválido en asignación");
     }
     return std::make_unique<Assignment>(std::move(expr), std::move(value));
@@ -250,8 +250,7 @@ auto Parser::parse_postfix() -> ExprPtr {
         expect(TokenType::RPAREN, "esperado ')' después de llamada a metodo");
         expr = std::make_unique<MethodCall>(std::move(expr), member.literal, std::move(args), member.loc);
       } else {
-        auto dot_token = Token{TokenType::IDENTIFIER, static_cast<Literal*>(expr.get())->token.literal + "." + member.literal, member.loc};
-        expr = std::make_unique<Literal>(dot_token);
+        expr = std::make_unique<MemberAccess>(std::move(expr), member.literal, member.loc);
       }
     } else if (match(TokenType::LBRACKET)) {
       auto index = parse_expression();
@@ -0,0 +1,32 @@
+#include "pool.h"
+
+auto Pool::instance() -> Pool& {
+  static auto* pool = new Pool;
+  return *pool;
+}
+
+// Whole blocks only: a slab's tail shorter than the class's block is unused.
+auto Pool::grow(SizeClass& c, std::size_t index) -> void {
+  auto block  = (index + 1) * GRANULE;
+  auto& slab  = _slabs.emplace_back(std::make_unique<std::byte[]>(SLAB));
+  c.bump      = slab.get();
+  c.end       = slab.get() + SLAB / block * block;
+  ++c.slabs;
+}
+
+auto Pool::stats() const -> std::vector<ClassStats> {
+  std::vector<ClassStats> out;
+  for (auto i {0uz}; i < CLASSES; ++i) {
+    const auto& c = _classes[i];
+    if (c.slabs == 0) continue;
+    auto block = (i + 1) * GRANULE;
+    out.push_back({
+      .block       = block,
+      .slabs       = c.slabs,
+      .live        = c.live,
+      .capacity    = c.slabs * (SLAB / block),
+      .allocations = c.allocations,
+    });
+  }
+  return out;
+}
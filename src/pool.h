@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Size-class allocator for the runtime's heap objects (the boxes behind
+// Ref: strings, arrays, instances). Requests up to MAX_BLOCK bytes are
+// rounded up to a multiple of GRANULE and served from that class: first
+// from blocks freed earlier, else by bumping a pointer through the class's
+// current slab. Larger requests go to operator new.
+//
+// One pool serves the process. Values outlive the Interpreter that made
+// them (a ReturnSignal carries one out, the REPL keeps them between
+// inputs), so nothing is released in bulk; freed blocks are reused by
+// their class. There are no locks: a program's thread and the thread
+// that started it never run at the same time.
+class Pool final {
+public:
+  static constexpr std::size_t GRANULE   = 16;
+  static constexpr std::size_t MAX_BLOCK = 256;
+  static constexpr std::size_t SLAB      = 64 * 1024;
+  static constexpr std::size_t CLASSES   = MAX_BLOCK / GRANULE;
+
+  struct ClassStats final {
+    std::size_t block{};        // bytes
+    std::size_t slabs{};
+    std::size_t live{};         // blocks in use
+    std::size_t capacity{};     // blocks in the slabs
+    uint64_t    allocations{};
+  };
+
+  // Never destroyed: objects freed during static destruction still return here.
+  static auto instance() -> Pool&;
+
+  auto allocate(std::size_t size) -> void* {
+    if (size > MAX_BLOCK)
+      return ::operator new(size);
+    auto& c = _classes[class_of(size)];
+    ++c.live;
+    ++c.allocations;
+    if (auto* block = c.free) {
+      c.free = block->next;
+      return block;
+    }
+    if (c.bump == c.end)
+      grow(c, class_of(size));
+    auto* block = c.bump;
+    c.bump += (class_of(size) + 1) * GRANULE;
+    return block;
+  }
+
+  auto release(void* p, std::size_t size) -> void {
+    if (size > MAX_BLOCK) {
+      ::operator delete(p, size);
+      return;
+    }
+    auto& c     = _classes[class_of(size)];
+    auto* block = static_cast<FreeBlock*>(p);
+    block->next = c.free;
+    c.free      = block;
+    --c.live;
+  }
+
+  auto stats() const -> std::vector<ClassStats>;  // classes with at least one slab
+
+private:
+  struct FreeBlock final { FreeBlock* next; };
+
+  struct SizeClass final {
+    FreeBlock*  free{};
+    std::byte*  bump{};
+    std::byte*  end{};
+    std::size_t slabs{};
+    std::size_t live{};
+    uint64_t    allocations{};
+  };
+
+  std::array<SizeClass, CLASSES>           _classes{};
+  std::vector<std::unique_ptr<std::byte[]>> _slabs{};
+
+  Pool() = default;
+
+  static auto class_of(std::size_t size) -> std::size_t { return (size - 1) / GRANULE; }
+  auto grow(SizeClass& c, std::size_t index) -> void;
+};
+
+// Base that gives a type's dynamic allocations to the Pool.
+struct PoolAllocated {
+  static auto operator new(std::size_t size) -> void* { return Pool::instance().allocate(size); }
+  static auto operator delete(void* p, std::size_t size) -> void { Pool::instance().release(p, size); }
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "pool.h"
+#include "gc.h"
+
+// The block behind a Ref: the count, then the object. Objects that can
+// hold Values are also GcNodes, so the Collector can find cycles of them.
+template <class T, bool = GcTraits<T>::traced>
+struct RefBox final : PoolAllocated {
+  template <class... Args>
+  explicit RefBox(Args&&... args) : value(std::forward<Args>(args)...) {}
+  uint32_t refs{1};
+  T        value;
+};
+
+template <class T>
+struct RefBox<T, true> final : PoolAllocated, GcNode {
+  template <class... Args>
+  explicit RefBox(Args&&... args) : value(std::forward<Args>(args)...) {}
+  uint32_t refs{1};
+  T        value;
+
+  auto gc_refs() const                        -> uint32_t    override { return refs; }
+  auto gc_children(std::vector<GcNode*>& out) -> void        override { GcTraits<T>::children(value, out); }
+  auto gc_clear()                             -> void        override { GcTraits<T>::clear(value); }
+  auto gc_bytes() const                       -> std::size_t override { return sizeof(RefBox) + GcTraits<T>::bytes(value); }
+  auto gc_retain()                            -> void        override { ++refs; }
+  auto gc_release()                           -> void        override {
+    if (--refs == 0) delete this;
+  }
+};
+
+// Shared ownership of a heap object for the single-threaded runtime. The
+// count is a plain integer stored with the object, so copying a handle is
+// one increment: no control block and no atomic operations, unlike
+// std::shared_ptr. Handles are moved wherever the source is not needed.
+// The object and its count are one block from the Pool. Counting alone
+// never frees a cycle; the Collector (gc.h) does.
+template <class T>
+class Ref final {
+public:
+  Ref() = default;
+  Ref(std::nullptr_t) {}
+
+  template <class... Args>
+  static auto make(Args&&... args) -> Ref {
+    Ref ref;
+    ref._box = new Box{std::forward<Args>(args)...};
+    return ref;
+  }
+
+  Ref(const Ref& other) : _box(other._box) {
+    if (_box) ++_box->refs;
+  }
+  Ref(Ref&& other) noexcept : _box(std::exchange(other._box, nullptr)) {}
+  ~Ref() { release(); }
+
+  auto operator=(const Ref& other) -> Ref& {
+    if (other._box) ++other._box->refs;
+    release();
+    _box = other._box;
+    return *this;
+  }
+  auto operator=(Ref&& other) noexcept -> Ref& {
+    if (this != &other) {
+      release();
+      _box = std::exchange(other._box, nullptr);
+    }
+    return *this;
+  }
+
+  auto operator*()  const -> T& { return _box->value; }
+  auto operator->() const -> T* { return &_box->value; }
+  auto get()        const -> T* { return _box ? &_box->value : nullptr; }
+
+  // Handles to the object, this one included; 0 for a null handle.
+  auto use_count() const -> uint32_t { return _box ? _box->refs : 0; }
+
+  // The object as the Collector sees it.
+  auto gc_node() const -> GcNode* requires GcTraits<T>::traced { return _box; }
+
+  explicit operator bool() const { return _box != nullptr; }
+  friend auto operator==(const Ref& a, const Ref& b) -> bool { return a._box == b._box; }
+  friend auto operator==(const Ref& a, std::nullptr_t) -> bool { return a._box == nullptr; }
+
+private:
+  using Box = RefBox<T>;
+
+  Box* _box{};
+
+  auto release() -> void {
+    if (_box && --_box->refs == 0)
+      delete _box;
+  }
+};
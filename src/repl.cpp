@@ -1,5 +1,6 @@
 #include "repl.h"
 #include <print>
+#include "optimizer.h"
 #include "parser.h"
 
 #ifdef _WIN32
@@ -121,6 +122,7 @@ auto Repl::execute(const std::string& src) -> void {
       std::println(stderr, "SemanticError: {}", err.to_string());
     return;
   }
+  Optimizer{}.optimize(ast);
 
   _ast_store.push_back(std::move(ast));
   const StmtsPtr& live_ast = _ast_store.back();
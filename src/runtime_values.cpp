@@ -4,6 +4,76 @@
 #include <iostream>
 #include <string>
 
+auto ClassDef::add_field(const std::string* name, const IAST* init) -> void {
+  if (slot_of(name) != NO_SLOT)
+    return;
+  field_names.push_back(name);
+  field_inits.push_back(init);
+}
+
+auto ClassDef::slot_of(const std::string* name) const -> std::size_t {
+  for (auto i {0uz}; i < field_names.size(); ++i)
+    if (field_names[i] == name) return i;
+  return NO_SLOT;
+}
+
+Instance::Instance(std::shared_ptr<ClassDef> klass)
+  : klass(std::move(klass)), slots(this->klass->field_names.size()) {}
+
+auto Instance::field(const std::string* name) -> Value* {
+  if (auto slot = klass->slot_of(name); slot != ClassDef::NO_SLOT)
+    return &slots[slot];
+  if (extra)
+    if (auto it = extra->find(name); it != extra->end())
+      return &it->second;
+  return nullptr;
+}
+
+auto Instance::set_field(const std::string* name, Value value) -> void {
+  if (auto* slot = field(name)) {
+    *slot = std::move(value);
+    return;
+  }
+  if (!extra)
+    extra = std::make_unique<std::flat_map<const std::string*, Value>>();
+  extra->insert_or_assign(name, std::move(value));
+}
+
+static auto gc_child(const Value& v, std::vector<GcNode*>& out) -> void {
+  if (auto* a = std::get_if<ArrayPtr>(&v.inner); a && *a)         out.push_back(a->gc_node());
+  else if (auto* i = std::get_if<InstancePtr>(&v.inner); i && *i) out.push_back(i->gc_node());
+}
+
+auto GcTraits<std::vector<Value>>::children(const std::vector<Value>& array, std::vector<GcNode*>& out) -> void {
+  for (const auto& v : array) gc_child(v, out);
+}
+
+// Moved out first: the Values are released with the vector already empty.
+auto GcTraits<std::vector<Value>>::clear(std::vector<Value>& array) -> void {
+  auto values = std::move(array);
+  array.clear();
+}
+
+auto GcTraits<std::vector<Value>>::bytes(const std::vector<Value>& array) -> std::size_t {
+  return array.capacity() * sizeof(Value);
+}
+
+auto GcTraits<Instance>::children(const Instance& inst, std::vector<GcNode*>& out) -> void {
+  for (const auto& v : inst.slots) gc_child(v, out);
+  if (inst.extra)
+    for (const auto& [_, v] : *inst.extra) gc_child(v, out);
+}
+
+auto GcTraits<Instance>::clear(Instance& inst) -> void {
+  auto slots = std::move(inst.slots);
+  auto extra = std::move(inst.extra);
+  inst.slots.clear();
+}
+
+auto GcTraits<Instance>::bytes(const Instance& inst) -> std::size_t {
+  return inst.slots.capacity() * sizeof(Value) + (inst.extra ? inst.extra->size() * sizeof(Value) : 0);
+}
+
 auto Value::truthy() const -> bool {
   return std::visit([](const auto& v) -> bool {
     using T = std::decay_t<decltype(v)>;
@@ -11,8 +81,8 @@ auto Value::truthy() const -> bool {
     if constexpr (std::is_same_v<T, bool>)                     return v;
     if constexpr (std::is_same_v<T, int64_t>)                  return v != 0z;
     if constexpr (std::is_same_v<T, double>)                   return v != 0.0;
-    if constexpr (std::is_same_v<T, std::string>)              return !v.empty();
-    if constexpr (std::is_same_v<T, std::vector<ValuePtr>>)    return !v.empty();
+    if constexpr (std::is_same_v<T, StringPtr>)                return !v->empty();
+    if constexpr (std::is_same_v<T, ArrayPtr>)                 return !v->empty();
     if constexpr (std::is_same_v<T, InstancePtr>)              return v != nullptr;
     return false;
   }, inner);
@@ -30,12 +100,12 @@ auto Value::to_string() const -> std::string {
       str.erase (str.find_last_not_of('.') + 1, std::string::npos);
       return str;
     }
-    else if constexpr (std::is_same_v<T, std::string>)            return v;
-    else if constexpr (std::is_same_v<T, std::vector<ValuePtr>>) {
+    else if constexpr (std::is_same_v<T, StringPtr>)              return *v;
+    else if constexpr (std::is_same_v<T, ArrayPtr>) {
       std::string s = "[";
-      for (std::size_t i = 0; i < v.size(); ++i) {
-        s += v[i]->to_string();
-        if (i + 1 < v.size()) s += ", ";
+      for (std::size_t i = 0; i < v->size(); ++i) {
+        s += (*v)[i].to_string();
+        if (i + 1 < v->size()) s += ", ";
       }
       return s + "]";
     }
@@ -1,34 +1,60 @@
 #pragma once
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <variant>
 #include <vector>
 #include <variant>
 #include <flat_map>
-#include "nodes.h"
+#include "ref.h"
+
+struct IAST;
+struct FunctionDecl;
+struct ClassDecl;
 
 struct Value;
 struct ClassDef;
 struct Instance;
-using ValuePtr    = std::shared_ptr<Value>;
-using InstancePtr = std::shared_ptr<Instance>;
+using StringPtr   = Ref<std::string>;
+using ArrayPtr    = Ref<std::vector<Value>>;
+using InstancePtr = Ref<Instance>;
+
+// Arrays and instances hold Values, so they can be part of a cycle.
+template <>
+struct GcTraits<std::vector<Value>> {
+  static constexpr bool traced = true;
+  static auto children(const std::vector<Value>& array, std::vector<GcNode*>& out) -> void;
+  static auto clear(std::vector<Value>& array)                                      -> void;
+  static auto bytes(const std::vector<Value>& array)                                -> std::size_t;
+};
 
+template <>
+struct GcTraits<Instance> {
+  static constexpr bool traced = true;
+  static auto children(const Instance& inst, std::vector<GcNode*>& out) -> void;
+  static auto clear(Instance& inst)                                      -> void;
+  static auto bytes(const Instance& inst)                                -> std::size_t;
+};
+
+// Marks a variable slot that has not been assigned yet. Never visible to
+// programs: reading one is reported as an undefined variable.
+struct Unbound final {};
 
-static inline auto make(int64_t v)     -> ValuePtr { return std::make_shared<Value>(v); }
-static inline auto make(double v)      -> ValuePtr { return std::make_shared<Value>(v); }
-static inline auto make(bool v)        -> ValuePtr { return std::make_shared<Value>(v); }
-static inline auto make(std::string v) -> ValuePtr { return std::make_shared<Value>(std::move(v)); }
-static inline auto make(std::vector<ValuePtr> v) -> ValuePtr { return std::make_shared<Value>(std::move(v)); }
-static inline auto make_null()         -> ValuePtr { return std::make_shared<Value>(); }
+// Same order as the alternatives of Value::Inner.
+enum class ValueType : uint8_t { NIL, INT, FLOAT, BOOL, STRING, ARRAY, INSTANCE, UNBOUND };
 
+// Numbers, booleans and null are stored inline; strings, arrays and
+// instances are shared heap objects, so copying a Value never copies them.
 struct Value final {
   using Inner = std::variant<
     std::monostate,    // null
     int64_t, // std::numeric_limits<int64_t>::max() is the max
     double,
     bool,
-    std::string,
-    std::vector<ValuePtr>,
-    InstancePtr
+    StringPtr,
+    ArrayPtr,
+    InstancePtr,
+    Unbound
   >;
 
   Inner inner{std::monostate{}};
@@ -37,50 +63,79 @@ struct Value final {
   explicit Value(int64_t v)               : inner(v) {}
   explicit Value(double v)                : inner(v) {}
   explicit Value(bool v)                  : inner(v) {}
-  explicit Value(std::string v)           : inner(std::move(v)) {}
-  explicit Value(std::vector<ValuePtr> v) : inner(std::move(v)) {}
+  explicit Value(std::string v)           : inner(StringPtr::make(std::move(v))) {}
+  explicit Value(std::vector<Value> v)    : inner(ArrayPtr::make(std::move(v))) {}
   explicit Value(InstancePtr v)           : inner(std::move(v)) {}
+  explicit Value(Unbound v)               : inner(v) {}
+
+  auto type() const -> ValueType { return static_cast<ValueType>(inner.index()); }
 
   bool is_null()     const { return std::holds_alternative<std::monostate>(inner); }
   bool is_int()      const { return std::holds_alternative<int64_t>(inner); }
   bool is_float()    const { return std::holds_alternative<double>(inner); }
   bool is_bool()     const { return std::holds_alternative<bool>(inner); }
-  bool is_string()   const { return std::holds_alternative<std::string>(inner); }
-  bool is_array()    const { return std::holds_alternative<std::vector<ValuePtr>>(inner); }
+  bool is_string()   const { return std::holds_alternative<StringPtr>(inner); }
+  bool is_array()    const { return std::holds_alternative<ArrayPtr>(inner); }
   bool is_instance() const { return std::holds_alternative<InstancePtr>(inner); }
+  bool is_unbound()  const { return std::holds_alternative<Unbound>(inner); }
 
   // Accessors (unchecked)
   int64_t&              as_int()      { return std::get<int64_t>(inner); }
   double&               as_float()    { return std::get<double>(inner); }
   bool&                 as_bool()     { return std::get<bool>(inner); }
-  std::string&          as_string()   { return std::get<std::string>(inner); }
-  std::vector<ValuePtr>& as_array()   { return std::get<std::vector<ValuePtr>>(inner); }
+  std::string&          as_string()   { return *std::get<StringPtr>(inner); }
+  std::vector<Value>&   as_array()    { return *std::get<ArrayPtr>(inner); }
   InstancePtr&          as_instance() { return std::get<InstancePtr>(inner); }
 
-  const int64_t&               as_int()      const { return std::get<int64_t>(inner); }
-  const double&                as_float()    const { return std::get<double>(inner); }
-  const bool&                  as_bool()     const { return std::get<bool>(inner); }
-  const std::string&           as_string()   const { return std::get<std::string>(inner); }
-  const std::vector<ValuePtr>& as_array()   const { return std::get<std::vector<ValuePtr>>(inner); }
-  const InstancePtr&           as_instance() const { return std::get<InstancePtr>(inner); }
+  const int64_t&            as_int()      const { return std::get<int64_t>(inner); }
+  const double&             as_float()    const { return std::get<double>(inner); }
+  const bool&               as_bool()     const { return std::get<bool>(inner); }
+  const std::string&        as_string()   const { return *std::get<StringPtr>(inner); }
+  const std::vector<Value>& as_array()    const { return *std::get<ArrayPtr>(inner); }
+  const InstancePtr&        as_instance() const { return std::get<InstancePtr>(inner); }
 
   // Truthiness — everything is truthy except false and null
   bool truthy() const;
   auto to_string() const -> std::string;
 };
 
+static inline auto make(int64_t v)     -> Value { return Value{v}; }
+static inline auto make(double v)      -> Value { return Value{v}; }
+static inline auto make(bool v)        -> Value { return Value{v}; }
+static inline auto make(std::string v) -> Value { return Value{std::move(v)}; }
+static inline auto make(std::vector<Value> v) -> Value { return Value{std::move(v)}; }
+static inline auto make_null()         -> Value { return Value{}; }
+static inline auto make_unbound()      -> Value { return Value{Unbound{}}; }
+
+// Field names are interned (see intern()), so layouts compare them by address.
 struct ClassDef final {
+  static constexpr std::size_t NO_SLOT = SIZE_MAX;
+
   std::string name{};
-  std::flat_map<std::string, const IAST*> fields;
+  std::size_t id{};  // index in Program::classes when compiled to bytecode
+  const ClassDecl* decl{};
+  // Layout shared by every instance: field i lives in Instance::slots[i].
+  std::vector<const std::string*> field_names;
+  std::vector<const IAST*>        field_inits;
   std::flat_map<std::string, const FunctionDecl*> methods;
+
+  auto add_field(const std::string* name, const IAST* init) -> void;
+  auto slot_of(const std::string* name) const               -> std::size_t;
 };
 
 struct Instance final {
   std::shared_ptr<ClassDef> klass;
-  std::flat_map<std::string, ValuePtr> fields;
-};
+  std::vector<Value>        slots;   // laid out by klass
+  // Fields assigned on this object that its class does not declare.
+  std::unique_ptr<std::flat_map<const std::string*, Value>> extra;
+
+  explicit Instance(std::shared_ptr<ClassDef> klass);
 
+  auto field(const std::string* name)                   -> Value*;
+  auto set_field(const std::string* name, Value value)  -> void;
+};
 
-struct ReturnSignal final { ValuePtr value; };
 
-struct ContinueSignal final {};
+// Thrown when a top-level 'devolver' ends a program; function returns
+// inside the interpreters never throw.
+struct ReturnSignal final { Value value; };
@@ -1,7 +1,11 @@
 #include "sema.h"
 #include <cstddef>
+#include <algorithm>
 #include <cassert>
 #include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
 #include "builtins.h"
 #include "nodes.h"
 #include "std.h"
@@ -22,16 +26,52 @@ auto Scope::contains(std::string_view name) const -> bool {
   return _syms.contains(std::string(name));
 }
 
-auto Sema::push_scope() -> void { _scopes.emplace_back(); }
-auto Sema::pop_scope()  -> void { assert(!_scopes.empty()); _scopes.pop_back(); }
+auto Sema::push_scope() -> void {
+  assert(!_frames.empty());
+  _scopes.emplace_back(_frames.size() - 1, _frames.back().next_slot);
+}
 
-auto Sema::define(Symbol sym) -> void {
+auto Sema::pop_scope() -> void {
   assert(!_scopes.empty());
-  if (_scopes.back().contains(sym.name)) {
+  auto& scope = _scopes.back();
+  if (scope.frame < _frames.size())
+    _frames[scope.frame].next_slot = scope.first_slot;
+  _scopes.pop_back();
+}
+
+auto Sema::push_frame(const IAST* owner) -> void {
+  _frames.push_back({.owner = owner});
+}
+
+// Returns the number of slots the frame needs.
+auto Sema::pop_frame() -> std::size_t {
+  assert(!_frames.empty());
+  auto size = _frames.back().max_slots;
+  _frames.pop_back();
+  return size;
+}
+
+auto Sema::define(Symbol sym) -> VarSlot {
+  assert(!_scopes.empty());
+  if (auto existing = _scopes.back().lookup(sym.name)) {
     error(SemanticErrorCode::REDEFINITION, sym.location, sym.name.data());
-  } else {
-    _scopes.back().define(std::move(sym));
+    return address_of(*existing);
   }
+  if (!_in_class_body) {
+    auto& frame = _frames.back();
+    sym.frame = _frames.size() - 1;
+    sym.slot  = frame.next_slot++;
+    frame.max_slots = std::max(frame.max_slots, frame.next_slot);
+  }
+  auto addr = address_of(sym);
+  _scopes.back().define(std::move(sym));
+  return addr;
+}
+
+auto Sema::address_of(const Symbol& sym) const -> VarSlot {
+  if (!sym.slot)
+    return {};
+  return {.depth = static_cast<uint32_t>(_frames.size() - 1 - sym.frame), .index = *sym.slot};
 }
 
 auto Sema::resolve(std::string_view name) const -> std::optional<Symbol> {
@@ -47,10 +87,14 @@ auto Sema::error(SemanticErrorCode code, SourceLocation    loc, std::string
 auto Sema::analyze(const StmtsPtr& program) -> void {
   _errors.clear();
   _scopes.clear();
-  _loop_depth = 0;
-  _func_depth = 0;
-  _in_class   = false;
-
+  _frames.clear();
+  _loop_depth    = 0;
+  _func_depth    = 0;
+  _in_class      = false;
+  _in_class_body = false;
+  _repl          = false;
+
+  push_frame(nullptr);
   push_scope();
 
   for (const auto& b : FREE_FUNCTIONS) {
@@ -63,7 +107,10 @@ auto Sema::analyze(const StmtsPtr& program) -> void {
   }
   check_stmts(program);
   pop_scope();
+  pop_frame();
 
+  infer_types(program);
+  mark_pure(program);
   _errors.flush();
 }
 
@@ -97,6 +144,9 @@ auto Sema::check_expr(const IAST* node) -> void {
     case NodeType::FUNCTIONCALL: check_func_call (static_cast<const FunctionCall*>(node)); break;
     case NodeType::ARRAYDECL:    check_array     (static_cast<const ArrayDecl*>   (node)); break;
     case NodeType::METHODCALL:   check_method_call(static_cast<const MethodCall*>    (node)); break;
+    case NodeType::MEMBERACCESS:
+      check_expr(static_cast<const MemberAccess*>(node)->object.get());
+      break;
     case NodeType::INDEXEXPR: {
       auto* idx = static_cast<const IndexExpr*>(node);
 
@@ -110,34 +160,52 @@ auto Sema::check_expr(const IAST* node) -> void {
 
 
 auto Sema::check_var_decl(const VariableDecl* node) -> void {
-  check_expr(node->expr.get());
-  define({
+  if (_in_class_body) {
+    // Field initializers run in a frame of their own when an instance is
+    // created, so whatever they read is addressed from there.
+    push_frame(node);
+    _in_class_body = false;
+    check_expr(node->expr.get());
+    _in_class_body = true;
+    pop_frame();
+  } else {
+    check_expr(node->expr.get());
+  }
+  node->slot = define({
     .name    = node->id,
-    .kind    = node->is_const ? SymbolKind::CONSTANT : SymbolKind::VARIABLE,
-    .arity   = 0,
-    .defined = true,
+    .kind     = node->is_const ? SymbolKind::CONSTANT : SymbolKind::VARIABLE,
+    .arity    = 0,
+    .defined  = true,
+    .decl     = _in_class_body ? nullptr : node,
   });
 }
 
 auto Sema::check_func_decl(const FunctionDecl* node) -> void {
   bool already_preregistered = _in_class and _scopes.back().contains(node->id);
   if (!already_preregistered)
-    define({
+    node->slot = define({
       .name  = node->id,
       .kind  = SymbolKind::FUNCTION,
       .arity = node->params.size(),
+      .node  = node,
     });
+  node->enclosing = _frames.back().owner;
 
+  push_frame(node);
   push_scope();
   ++_func_depth;
+  bool prev_body = _in_class_body;
+  _in_class_body = false;
 
   for (auto& p : node->params)
     define({.name = p, .kind = SymbolKind::PARAMETER});
 
   check_stmts(node->body);
 
+  _in_class_body = prev_body;
   --_func_depth;
   pop_scope();
+  node->frame_size = pop_frame();
 }
 
 auto Sema::check_class_decl(const ClassDecl* node) -> void {
@@ -153,16 +221,20 @@ auto Sema::check_class_decl(const ClassDecl* node) -> void {
     }
   }
 
-  define({
+  node->slot = define({
     .name       = node->id,
     .kind       = SymbolKind::CLASS,
     .ctor_arity = ctor_arity,
     .has_ctor   = has_ctor,
+    .node       = node,
   });
+  node->enclosing = _frames.back().owner;
 
   push_scope();
-  bool prev = _in_class;
-  _in_class = true;
+  bool prev      = _in_class;
+  bool prev_body = _in_class_body;
+  _in_class      = true;
+  _in_class_body = true;
 
   for (auto& m : node->members) {
     if (m->node_type == NodeType::FUNCTIONDECL) {
@@ -174,9 +246,29 @@ auto Sema::check_class_decl(const ClassDecl* node) -> void {
 
   check_stmts(node->members);
 
-  _in_class = prev;
+  _in_class      = prev;
+  _in_class_body = prev_body;
   pop_scope();
 }
+// Addends of 'x se x + a + b ...' when every one is a plain literal or
+// variable (see Assignment::appends); 0 for any other expression.
+static auto count_appends(const Literal* target, const IAST* expr) -> uint8_t {
+  uint8_t n = 0;
+  while (expr->node_type == NodeType::BINARYOP) {
+    auto* sum = static_cast<const BinaryOp*>(expr);
+    if (sum->op.type != TokenType::PLUS || sum->right->node_type != NodeType::LITERAL ||
+        n == Assignment::MAX_APPENDS)
+      return 0;
+    ++n;
+    expr = sum->left.get();
+  }
+  if (expr->node_type != NodeType::LITERAL) return 0;
+  auto* base = static_cast<const Literal*>(expr);
+  bool same = base->token.type == TokenType::IDENTIFIER && target->slot.resolved() &&
+              base->slot.depth == target->slot.depth && base->slot.index == target->slot.index;
+  return same ? n : 0;
+}
+
 auto Sema::check_assignment(const Assignment* node) -> void {
   auto loc = node->loc;
   auto tkn = node->target->node_type;
@@ -188,23 +280,27 @@ auto Sema::check_assignment(const Assignment* node) -> void {
     }
 
     const std::string& name = lit->token.literal;
-
-    if (name.rfind("este.", 0) == 0) {
-      if (!_in_class)
-        error(SemanticErrorCode::THIS_USED_OUTSIDE_CLASS, loc);
-    } else if(name.find('.') == std::string::npos) {
-
-      auto sym = resolve(name);
-
-      if (!sym)
-        error(SemanticErrorCode::ASSIGNMENT_TO_UNDECLARED, loc, name);
-      else if (sym->kind == SymbolKind::CONSTANT)
-        error(SemanticErrorCode::ASSIGNMENT_TO_CONST, loc, name);
-      else if (sym->kind == SymbolKind::FUNCTION)
-        error(SemanticErrorCode::ASSIGNMENT_TO_FUNC, loc, name);
-      else if (sym->kind == SymbolKind::CLASS)
-        error(SemanticErrorCode::ASSIGNMENT_TO_CLASS, loc, name);
+    auto sym = resolve(name);
+
+    if (!sym)
+      error(SemanticErrorCode::ASSIGNMENT_TO_UNDECLARED, loc, name);
+    else if (sym->kind == SymbolKind::CONSTANT)
+      error(SemanticErrorCode::ASSIGNMENT_TO_CONST, loc, name);
+    else if (sym->kind == SymbolKind::FUNCTION)
+      error(SemanticErrorCode::ASSIGNMENT_TO_FUNC, loc, name);
+    else if (sym->kind == SymbolKind::CLASS)
+      error(SemanticErrorCode::ASSIGNMENT_TO_CLASS, loc, name);
+    else {
+      lit->slot = address_of(*sym);
+      lit->decl = sym->decl;
     }
+
+    check_expr(node->expr.get());
+    node->appends = count_appends(lit, node->expr.get());
+    return;
+  }
+  else if (NodeType::MEMBERACCESS == tkn) {
+    check_expr(static_cast<const MemberAccess*>(node->target.get())->object.get());
     check_expr(node->expr.get());
     return;
   }
@@ -249,6 +345,9 @@ auto Sema::check_return(const ReturnStatement* node) -> void {
   if (_func_depth == 0) {
     error(SemanticErrorCode::RET_OUTSIDE_FUNC, node->loc);
   }
+  // Nothing is left to do in the caller once the call returns, whatever
+  // block the 'devolver' sits in.
+  node->tail_call = _func_depth > 0 && node->expr && node->expr->node_type == NodeType::FUNCTIONCALL;
   check_expr(node->expr.get());
 }
 
@@ -264,24 +363,9 @@ auto Sema::check_method_call(const MethodCall* node) -> void {
 
 auto Sema::check_func_call(const FunctionCall* node) -> void {
   auto loc = node->loc;
-  auto dot = node->id.find('.');
-  if (dot != std::string::npos) {
-    std::string root = node->id.substr(0, dot);
-    if (root == "este") {
-      if (!_in_class) {
-        error(SemanticErrorCode::THIS_USED_OUTSIDE_CLASS, loc, root);
-      }
-    } else {
-      if (!resolve(root)){
-        error(SemanticErrorCode::UNDECLARED_ID, loc, root);
-      }
-    }
-    for (auto& a : node->exprs)
-      check_expr(a.get());
-    return;
-  }
-
   auto sym = resolve(node->id);
+  if (sym)
+    node->decl = sym->node;
   if (!sym) {
     error(SemanticErrorCode::UNDECLARED_FUNC, loc, node->id);
   } else if (sym->kind == SymbolKind::CLASS) {
@@ -323,17 +407,12 @@ auto Sema::check_literal(const Literal* node) -> void {
   using enum TokenType;
   switch (node->token.type) {
     case IDENTIFIER: {
-      auto lit =  node->token.literal;
-      auto dot  = node->token.literal.find('.');
-      auto  root = (dot == std::string::npos) ? lit : lit.substr(0, dot);
-
-      if (root == "este") {
-        if (!_in_class)
-          error(SemanticErrorCode::THIS_USED_OUTSIDE_CLASS, loc);
-        break;
-      }
-      if (!resolve(root))
-        error(SemanticErrorCode::UNDECLARED_ID, loc, root);
+      const auto& name = node->token.literal;
+      if (auto sym = resolve(name)) {
+        node->slot = address_of(*sym);
+        node->decl = sym->decl;
+      } else
+        error(SemanticErrorCode::UNDECLARED_ID, loc, name);
       break;
     }
     case SELF:
@@ -348,9 +427,14 @@ auto Sema::check_literal(const Literal* node) -> void {
 auto Sema::init_repl() -> void {
   _errors.clear();
   _scopes.clear();
-  _loop_depth = 0;
-  _func_depth = 0;
-  _in_class   = false;
+  _frames.clear();
+  _loop_depth    = 0;
+  _func_depth    = 0;
+  _in_class      = false;
+  _in_class_body = false;
+  _repl          = true;
+  _repl_globals.clear();
+  push_frame(nullptr);
   push_scope();
 
   for (const auto& b : FREE_FUNCTIONS) {
@@ -366,5 +450,379 @@ auto Sema::init_repl() -> void {
 auto Sema::analyze_incremental(const StmtsPtr& stmts) -> void {
   _errors.clear();
   check_stmts(stmts);
+  infer_types(stmts);
   _errors.flush();
 }
+
+// ── Type inference ───────────────────────────────────────────────────
+//
+// Flow-insensitive: a variable's type is the join of everything ever
+// assigned to it anywhere, so it holds at every read, including reads from
+// nested functions and later loop iterations. The program is walked again
+// until no variable changes; declarations come before their uses, so a
+// read always finds its variable typed. Parameters, fields and (in the
+// REPL) globals stay UNKNOWN, since code the walk cannot see may assign
+// them.
+
+static auto join(StaticType a, StaticType b) -> StaticType {
+  return a == b ? a : StaticType::UNKNOWN;
+}
+
+static auto is_number(StaticType t) -> bool {
+  return t == StaticType::INT || t == StaticType::FLOAT;
+}
+
+// Result of a builtin whose return type never depends on its arguments.
+static auto builtin_type(std::string_view name) -> StaticType {
+  if (name == "longitud" || name == "entero") return StaticType::INT;
+  if (name == "decimal")                      return StaticType::FLOAT;
+  if (name == "cadena")                       return StaticType::STRING;
+  return StaticType::UNKNOWN;
+}
+
+auto Sema::infer_types(const StmtsPtr& program) -> void {
+  _var_types.clear();
+  _infer_depth = 0;
+  do {
+    _types_changed = false;
+    infer_stmts(program);
+  } while (_types_changed);
+
+  for (const auto& [var, type] : _var_types)
+    var->type = type;
+}
+
+auto Sema::infer_stmts(const StmtsPtr& stmts) -> void {
+  for (const auto& s : stmts) infer_stmt(s.get());
+}
+
+auto Sema::assign_type(const VariableDecl* var, StaticType t) -> void {
+  auto [it, inserted] = _var_types.try_emplace(var, t);
+  auto joined = inserted ? t : join(it->second, t);
+  if (inserted || joined != it->second) {
+    it->second     = joined;
+    _types_changed = true;
+  }
+}
+
+auto Sema::infer_stmt(const IAST* node) -> void {
+  if (!node) return;
+  using enum NodeType;
+  switch (node->node_type) {
+    case VARIABLEDECL: {
+      auto* var = static_cast<const VariableDecl*>(node);
+      auto  t   = type_of(var->expr.get());
+      if (_repl && _infer_depth == 0) {
+        _repl_globals.insert(var);
+        t = StaticType::UNKNOWN;
+      }
+      assign_type(var, t);
+      break;
+    }
+    case FUNCTIONDECL:
+      ++_infer_depth;
+      infer_stmts(static_cast<const FunctionDecl*>(node)->body);
+      --_infer_depth;
+      break;
+    case CLASSDECL:
+      for (const auto& m : static_cast<const ClassDecl*>(node)->members) {
+        if (m->node_type == VARIABLEDECL)
+          type_of(static_cast<const VariableDecl*>(m.get())->expr.get());
+        else
+          infer_stmt(m.get());
+      }
+      break;
+    case ASSIGNMENT: {
+      auto* as = static_cast<const Assignment*>(node);
+      auto  t  = type_of(as->expr.get());
+      if (as->target->node_type == LITERAL) {
+        if (auto* var = static_cast<const Literal*>(as->target.get())->decl)
+          assign_type(var, _repl_globals.contains(var) ? StaticType::UNKNOWN : t);
+      } else {
+        type_of(as->target.get());
+      }
+      break;
+    }
+    case IFSTATEMENT: {
+      auto* branch = static_cast<const IfStatement*>(node);
+      type_of(branch->condition.get());
+      infer_stmts(branch->then_body);
+      if (auto* els = std::get_if<StmtsPtr>(&branch->next))
+        infer_stmts(*els);
+      else if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&branch->next))
+        infer_stmt(elif->get());
+      break;
+    }
+    case WHILESTATEMENT: {
+      auto* loop = static_cast<const WhileStatement*>(node);
+      type_of(loop->condition.get());
+      infer_stmts(loop->body);
+      break;
+    }
+    case RETURNSTATEMENT:
+      type_of(static_cast<const ReturnStatement*>(node)->expr.get());
+      break;
+    case FUNCTIONCALL:
+    case METHODCALL:
+      type_of(node);
+      break;
+    default: break;
+  }
+}
+
+// Also records on each BinaryOp whether both operands have one numeric type.
+auto Sema::type_of(const IAST* node) -> StaticType {
+  using enum StaticType;
+  if (!node) return NIL;
+  switch (node->node_type) {
+    case NodeType::LITERAL: {
+      auto* lit = static_cast<const Literal*>(node);
+      switch (lit->token.type) {
+        case TokenType::INTEGER: return INT;
+        case TokenType::FLOAT:   return FLOAT;
+        case TokenType::BOOL:    return BOOL;
+        case TokenType::STRING:  return STRING;
+        case TokenType::NIL:     return NIL;
+        case TokenType::SELF:    return INSTANCE;
+        case TokenType::IDENTIFIER:
+          if (auto it = _var_types.find(lit->decl); lit->decl && it != _var_types.end())
+            return it->second;
+          return UNKNOWN;
+        default: return UNKNOWN;
+      }
+    }
+    case NodeType::BINARYOP: {
+      auto* bin = static_cast<const BinaryOp*>(node);
+      auto  l   = type_of(bin->left.get());
+      auto  r   = type_of(bin->right.get());
+      auto  op  = bin->op.type;
+      bin->operands = l == r && is_number(l) ? l : UNKNOWN;
+
+      auto numeric = [&] {
+        if (l == INT && r == INT)         return INT;
+        if (is_number(l) && is_number(r)) return FLOAT;
+        return UNKNOWN;
+      };
+      switch (op) {
+        case TokenType::PLUS:
+          if (l == STRING || r == STRING) return STRING;
+          return numeric();
+        case TokenType::MINUS:
+        case TokenType::STAR:
+        case TokenType::SLASH:
+          return numeric();
+        default:  // comparisons, 'y', 'o'
+          return BOOL;
+      }
+    }
+    case NodeType::UNARYOP: {
+      auto* un = static_cast<const UnaryOp*>(node);
+      auto  t  = type_of(un->operand.get());
+      if (un->op == TokenType::BANG) return BOOL;
+      return is_number(t) ? t : UNKNOWN;
+    }
+    case NodeType::FUNCTIONCALL: {
+      auto* call = static_cast<const FunctionCall*>(node);
+      for (const auto& a : call->exprs) type_of(a.get());
+      return builtin_type(call->id);
+    }
+    case NodeType::METHODCALL: {
+      auto* call = static_cast<const MethodCall*>(node);
+      type_of(call->object.get());
+      for (const auto& a : call->args) type_of(a.get());
+      return UNKNOWN;
+    }
+    case NodeType::ARRAYDECL:
+      for (const auto& el : static_cast<const ArrayDecl*>(node)->data) type_of(el.get());
+      return ARRAY;
+    case NodeType::INDEXEXPR: {
+      auto* idx = static_cast<const IndexExpr*>(node);
+      auto  obj = type_of(idx->object.get());
+      type_of(idx->index.get());
+      return obj == STRING ? STRING : UNKNOWN;
+    }
+    case NodeType::MEMBERACCESS:
+      type_of(static_cast<const MemberAccess*>(node)->object.get());
+      return UNKNOWN;
+    default:
+      return UNKNOWN;
+  }
+}
+
+namespace {
+// What a function body does besides computing its result, see mark_pure.
+struct Effects final {
+  bool                          impure{};
+  std::vector<std::string_view> callees{};
+};
+
+auto has_effect_builtin(std::string_view name) -> bool {
+  return name == "escribe" || name == "leer" || name == "aleatorio" || name == "salir";
+}
+
+// Outer variables a pure function may read: constants whose every value
+// is a scalar, so no later statement can change what it sees.
+auto is_frozen(const VariableDecl* var) -> bool {
+  using enum StaticType;
+  return var && var->is_const
+      && (var->type == INT || var->type == FLOAT || var->type == BOOL || var->type == STRING);
+}
+
+auto scan(const IAST* node, Effects& fx) -> void;
+
+auto scan_all(const StmtsPtr& stmts, Effects& fx) -> void {
+  for (const auto& s : stmts) scan(s.get(), fx);
+}
+
+auto scan(const IAST* node, Effects& fx) -> void {
+  if (!node || fx.impure) return;
+  using enum NodeType;
+  switch (node->node_type) {
+    case FUNCTIONDECL:
+    case CLASSDECL:
+    case METHODCALL:
+      fx.impure = true;
+      break;
+    case VARIABLEDECL:
+      scan(static_cast<const VariableDecl*>(node)->expr.get(), fx);
+      break;
+    case ASSIGNMENT: {
+      auto* as = static_cast<const Assignment*>(node);
+      if (as->target->node_type != LITERAL || static_cast<const Literal*>(as->target.get())->slot.depth != 0)
+        fx.impure = true;
+      scan(as->expr.get(), fx);
+      break;
+    }
+    case LITERAL: {
+      auto* lit = static_cast<const Literal*>(node);
+      if (lit->token.type == TokenType::SELF)
+        fx.impure = true;
+      else if (lit->token.type == TokenType::IDENTIFIER && lit->slot.depth != 0)
+        fx.impure = !is_frozen(lit->decl);
+      break;
+    }
+    case IFSTATEMENT: {
+      auto* branch = static_cast<const IfStatement*>(node);
+      scan(branch->condition.get(), fx);
+      scan_all(branch->then_body, fx);
+      if (auto* els = std::get_if<StmtsPtr>(&branch->next))
+        scan_all(*els, fx);
+      else if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&branch->next))
+        scan(elif->get(), fx);
+      break;
+    }
+    case WHILESTATEMENT: {
+      auto* loop = static_cast<const WhileStatement*>(node);
+      scan(loop->condition.get(), fx);
+      scan_all(loop->body, fx);
+      break;
+    }
+    case RETURNSTATEMENT:
+      scan(static_cast<const ReturnStatement*>(node)->expr.get(), fx);
+      break;
+    case FUNCTIONCALL: {
+      auto* call = static_cast<const FunctionCall*>(node);
+      fx.callees.push_back(call->id);
+      scan_all(call->exprs, fx);
+      break;
+    }
+    case BINARYOP: {
+      auto* bin = static_cast<const BinaryOp*>(node);
+      scan(bin->left.get(), fx);
+      scan(bin->right.get(), fx);
+      break;
+    }
+    case UNARYOP:
+      scan(static_cast<const UnaryOp*>(node)->operand.get(), fx);
+      break;
+    case ARRAYDECL:
+      scan_all(static_cast<const ArrayDecl*>(node)->data, fx);
+      break;
+    case INDEXEXPR: {
+      auto* idx = static_cast<const IndexExpr*>(node);
+      scan(idx->object.get(), fx);
+      scan(idx->index.get(), fx);
+      break;
+    }
+    case MEMBERACCESS:
+      scan(static_cast<const MemberAccess*>(node)->object.get(), fx);
+      break;
+    default: break;
+  }
+}
+
+// Functions outside class bodies and function bodies; 'classes' gets
+// every class name, wherever it is declared.
+auto collect(const StmtsPtr& stmts,
+             std::unordered_map<std::string_view, std::vector<const FunctionDecl*>>& functions,
+             std::vector<std::string_view>& classes) -> void {
+  using enum NodeType;
+  for (const auto& s : stmts) {
+    switch (s->node_type) {
+      case FUNCTIONDECL: {
+        auto* fn = static_cast<const FunctionDecl*>(s.get());
+        functions[fn->id].push_back(fn);
+        break;
+      }
+      case CLASSDECL:
+        classes.push_back(static_cast<const ClassDecl*>(s.get())->id);
+        break;
+      case IFSTATEMENT: {
+        for (auto* branch = static_cast<const IfStatement*>(s.get()); branch;) {
+          collect(branch->then_body, functions, classes);
+          if (auto* els = std::get_if<StmtsPtr>(&branch->next))
+            collect(*els, functions, classes);
+          auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&branch->next);
+          branch = elif ? elif->get() : nullptr;
+        }
+        break;
+      }
+      case WHILESTATEMENT:
+        collect(static_cast<const WhileStatement*>(s.get())->body, functions, classes);
+        break;
+      default: break;
+    }
+  }
+}
+}
+
+// A function is pure when a call's result depends only on its arguments
+// and the call changes nothing else: it writes no outer variable, fields
+// or elements, reads only frozen outer variables, calls no method and no
+// builtin with effects, and every function it calls is pure too. Nested
+// functions and methods are never pure. The callees are resolved by name
+// in the interpreter's order (builtins, classes, functions), and a name
+// declared more than once needs every declaration to be pure.
+auto Sema::mark_pure(const StmtsPtr& program) -> void {
+  std::unordered_map<std::string_view, std::vector<const FunctionDecl*>> functions;
+  std::vector<std::string_view> classes;
+  collect(program, functions, classes);
+
+  std::unordered_map<const FunctionDecl*, Effects> effects;
+  for (const auto& [name, decls] : functions)
+    for (auto* fn : decls) {
+      auto& fx = effects[fn];
+      fx.impure = fn->enclosing != nullptr;
+      scan_all(fn->body, fx);
+      fn->pure = !fx.impure;
+    }
+
+  auto pure_callee = [&](std::string_view name) {
+    if (name == "__index__") return true;
+    if (find_builtin(FREE_FUNCTIONS, name)) return !has_effect_builtin(name);
+    if (std::ranges::find(classes, name) != classes.end()) return false;
+    auto it = functions.find(name);
+    return it != functions.end()
+        && std::ranges::all_of(it->second, [](auto* fn) { return fn->pure; });
+  };
+
+  // Impurity spreads from callees to callers until nothing changes.
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const auto& [fn, fx] : effects)
+      if (fn->pure && !std::ranges::all_of(fx.callees, pure_callee)) {
+        fn->pure = false;
+        changed  = true;
+      }
+  }
+}
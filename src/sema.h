@@ -1,9 +1,11 @@
 #pragma once
 #include "nodes.h"
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <optional>
 #include "utilities.h"
@@ -19,10 +21,19 @@ struct Symbol {
   bool          has_ctor{false}; // whether the class defines 'crear'
   bool          defined{true};
   SourceLocation location{};
+  std::size_t   frame{};        // index of the owning frame in Sema::_frames
+  std::optional<uint32_t> slot{}; // unset for builtins and class members
+  const VariableDecl* decl{};       // for variables declared outside a class body
+  const IAST*   node{};         // FunctionDecl or ClassDecl (unset for builtins and methods)
 };
 
 class Scope {
 public:
+  Scope(std::size_t frame = 0, uint32_t first_slot = 0) : frame(frame), first_slot(first_slot) {}
+
+  std::size_t frame;      // frame the scope allocates its slots in
+  uint32_t    first_slot; // first free slot when the scope was opened
+
   auto define(Symbol sym)                          -> void;
   auto lookup(std::string_view name) const         -> std::optional<Symbol>;
   auto contains(std::string_view name) const       -> bool;
@@ -39,17 +50,37 @@ public:
   auto analyze_incremental(const StmtsPtr& stmts) -> void;
 
 private:
+  // One per function activation (plus the global one). Block scopes inside
+  // a frame hand their slots back when they close, so siblings share them.
+  struct FrameLayout final {
+    const IAST* owner{};
+    uint32_t    next_slot{};
+    uint32_t    max_slots{};
+  };
+
   std::vector<Scope>         _scopes{};
+  std::vector<FrameLayout>   _frames{};
   ErrorManager _errors;
 
   std::size_t _loop_depth{};
   std::size_t _func_depth{};
   bool _in_class{};
+  bool _in_class_body{}; // directly inside 'clase', where vars are fields
+  bool _repl{};          // later inputs may still assign the globals
+
+  // Type inference state, see infer_types.
+  std::unordered_map<const VariableDecl*, StaticType> _var_types{};
+  std::unordered_set<const VariableDecl*>             _repl_globals{};  // from every input so far
+  std::size_t _infer_depth{};
+  bool        _types_changed{};
 
   auto push_scope()                               -> void;
   auto pop_scope()                                -> void;
-  auto define(Symbol sym)                         -> void;
+  auto push_frame(const IAST* owner)              -> void;
+  auto pop_frame()                                -> std::size_t;
+  auto define(Symbol sym)                         -> VarSlot;
   auto resolve(std::string_view name) const       -> std::optional<Symbol>;
+  auto address_of(const Symbol& sym) const        -> VarSlot;
 
   auto error(SemanticErrorCode code, SourceLocation loc, std::string subject  = {}, std::size_t expected = 0, std::size_t got = 0) -> void;
 
@@ -70,4 +101,12 @@ private:
   auto check_array(const ArrayDecl*) -> void;
   auto check_literal(const Literal*) -> void;
   auto check_method_call(const MethodCall*) -> void;
+
+  auto infer_types(const StmtsPtr& program)               -> void;
+  auto infer_stmts(const StmtsPtr& stmts)                 -> void;
+  auto infer_stmt(const IAST* node)                       -> void;
+  auto assign_type(const VariableDecl* var, StaticType t) -> void;
+  auto type_of(const IAST* node)                          -> StaticType;
+
+  auto mark_pure(const StmtsPtr& program)                 -> void;
 };
@@ -1,5 +1,6 @@
 #include "std.h"
 #include "error_manager.h"
+#include "operators.h"
 #include "runtime_values.h"
 #include <algorithm>
 #include <cctype>
@@ -13,36 +14,36 @@
 
 // Helper
 namespace {
-auto to_double(const ValuePtr& v) -> double {
-  if (v->is_float())
-    return v->as_float();
-  else if (v->is_int())
-    return static_cast<double>(v->as_int());
+auto to_double(const Value& v) -> double {
+  if (v.is_float())
+    return v.as_float();
+  else if (v.is_int())
+    return static_cast<double>(v.as_int());
 
   throw RuntimeError("valor no numerico");
 }
 
-auto to_int(const ValuePtr& v) -> int64_t {
-  if (v->is_float())
-    return static_cast<int64_t>(v->as_float());
-  else if (v->is_int())
-    return v->as_int();
+auto to_int(const Value& v) -> int64_t {
+  if (v.is_float())
+    return static_cast<int64_t>(v.as_float());
+  else if (v.is_int())
+    return v.as_int();
 
   throw RuntimeError("valor no numerico");
 }
 
-auto is_number(const ValuePtr& v) {
-  return v->is_int() || v->is_float();
+auto is_number(const Value& v) {
+  return v.is_int() || v.is_float();
 };
 
-template<class... V> requires ((std::same_as<V, ValuePtr>) && ...)
+template<class... V> requires ((std::same_as<V, Value>) && ...)
 auto any_float(const V&... v) -> bool {
-  return ((v->is_float()) || ... || false);
+  return ((v.is_float()) || ... || false);
 }
 
-/*auto any_float(std::span<const ValuePtr> values) -> bool {
-  return std::ranges::any_of(values, [](const ValuePtr& v) {
-    return v->is_float();
+/*auto any_float(std::span<const Value> values) -> bool {
+  return std::ranges::any_of(values, [](const Value& v) {
+    return v.is_float();
   });
 }*/
 }
@@ -55,22 +56,22 @@ auto find_builtin(std::span<const NativeMethodDesc> methods, std::string_view na
   return nullptr;
 }
 
-auto std_is_int(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
-  return make(args[0]->is_int());
+auto std_is_int(Value, std::span<const Value> args) -> Value {
+  return make(args[0].is_int());
 }
-auto std_is_float(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
-  return make(args[0]->is_float());
+auto std_is_float(Value, std::span<const Value> args) -> Value {
+  return make(args[0].is_float());
 }
-auto std_is_str(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
-  return make(args[0]->is_string());
+auto std_is_str(Value, std::span<const Value> args) -> Value {
+  return make(args[0].is_string());
 }
-auto std_is_bool(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
-  return make(args[0]->is_bool());
+auto std_is_bool(Value, std::span<const Value> args) -> Value {
+  return make(args[0].is_bool());
 }
 
-auto escribe(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto escribe(Value, std::span<const Value> args) -> Value {
   for (auto i{0uz}; i < args.size(); i++) {
-    std::print("{}", args[i]->to_string());
+    std::print("{}", args[i].to_string());
     if (i + 1 < args.size())
       std::print(" ");
   }
@@ -78,13 +79,13 @@ auto escribe(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
   return make_null();
 }
 
-auto leer(ValuePtr, std::span<const ValuePtr>) -> ValuePtr {
+auto leer(Value, std::span<const Value>) -> Value {
   std::string str;
   std::getline(std::cin, str);
-  return std::make_shared<Value>(str);
+  return make(str);
 }
 
-auto aleatorio(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto aleatorio(Value, std::span<const Value> args) -> Value {
   if (!is_number(args[0]) || !is_number(args[1]))
     throw RuntimeError("aleatorio solo acepta numeros");
 
@@ -98,131 +99,131 @@ auto aleatorio(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
 
     return make(dist(gen));
   }
-  int64_t begin = args[0]->as_int();
-  int64_t end   = args[1]->as_int();
+  int64_t begin = args[0].as_int();
+  int64_t end   = args[1].as_int();
 
   std::uniform_int_distribution<int64_t> dist(begin, end);
 
   return make(dist(gen));
 }
 
-auto entero(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto entero(Value, std::span<const Value> args) -> Value {
   auto x = args[0];
-  if (x->is_array())
+  if (x.is_array())
     throw RuntimeError("No se puede convertir un array a numero");
-  else if (x->is_string()) {
-    auto str = args[0]->as_string();
+  else if (x.is_string()) {
+    auto str = args[0].as_string();
     return make(static_cast<int64_t>(std::stoi(str)));
   } 
   return make(to_int(x));
 }
 
-auto std_to_bool(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_to_bool(Value, std::span<const Value> args) -> Value {
   auto x = args[0];
-  if(x->is_int())
-    return make(x->as_int() != 0);
-  else if(x->is_null())
+  if(x.is_int())
+    return make(x.as_int() != 0);
+  else if(x.is_null())
     return make(false);
-  else if(x->is_string())
-    return make(!x->to_string().empty());
-  else if(x->is_float())
-    return make(x->as_float() != 0);
-  else if(x->is_array())
-    return make(!x->as_array().empty());
+  else if(x.is_string())
+    return make(!x.to_string().empty());
+  else if(x.is_float())
+    return make(x.as_float() != 0);
+  else if(x.is_array())
+    return make(!x.as_array().empty());
   return make(false);
 }
 
-auto decimal(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto decimal(Value, std::span<const Value> args) -> Value {
   auto x = args[0];
-  if (x->is_array())
+  if (x.is_array())
     throw RuntimeError("No se puede convertir un array a numero");
-  else if (x->is_string()) {
-    auto str = args[0]->as_string();
+  else if (x.is_string()) {
+    auto str = args[0].as_string();
     return make(std::stod(str));
   } 
   return make(to_double(x));
 }
 
-auto cadena(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
-  return make(args[0]->to_string());
+auto cadena(Value, std::span<const Value> args) -> Value {
+  return make(args[0].to_string());
 }
 
-auto longitud(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
-  if (!args[0]->is_array())
-    throw RuntimeError(std::format("'{}' no soporta longitud", args[0]->to_string()));
-  return make(static_cast<int64_t>(args[0]->as_array().size()));
+auto longitud(Value, std::span<const Value> args) -> Value {
+  if (!args[0].is_array())
+    throw RuntimeError(std::format("'{}' no soporta longitud", args[0].to_string()));
+  return make(static_cast<int64_t>(args[0].as_array().size()));
 }
 
-auto std_abs(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_abs(Value, std::span<const Value> args) -> Value {
   auto v = args[0];
 
-  if (v->is_float())
-    return make(std::abs(v->as_float()));
-  else if(v->is_int())
-    return make(static_cast<int64_t>(std::llabs(v->as_int())));
-  throw RuntimeError(std::format("abs espera un numeros, valor: {}", v->to_string()));
+  if (v.is_float())
+    return make(std::abs(v.as_float()));
+  else if(v.is_int())
+    return make(static_cast<int64_t>(std::llabs(v.as_int())));
+  throw RuntimeError(std::format("abs espera un numeros, valor: {}", v.to_string()));
 }
 
-auto std_max(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_max(Value, std::span<const Value> args) -> Value {
   auto a = args[0];
   auto b = args[1];
 
   if (any_float(a, b)) {
     double x = to_double(a);
     double y = to_double(b);
-    return std::make_shared<Value>(std::max(x, y));
+    return make(std::max(x, y));
   }
-  return std::make_shared<Value>(std::max(a->as_int(), b->as_int()));
+  return make(std::max(a.as_int(), b.as_int()));
 }
 
-auto std_min(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_min(Value, std::span<const Value> args) -> Value {
   auto a = args[0];
   auto b = args[1];
 
   if (any_float(a, b))
     return make(std::min(to_double(a), to_double(b)));
-  return make(std::min(a->as_int(), b->as_int()));
+  return make(std::min(a.as_int(), b.as_int()));
 }
 
-auto std_pow(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_pow(Value, std::span<const Value> args) -> Value {
   double base = to_double(args[0]);
   double exp = to_double(args[1]);
   return make(std::pow(base, exp));
 }
 
-auto std_sqrt(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_sqrt(Value, std::span<const Value> args) -> Value {
   return make(std::sqrt(to_double(args[0])));
 }
 
-auto std_floor(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_floor(Value, std::span<const Value> args) -> Value {
   return make(std::floor(to_double(args[0])));
 }
 
-auto std_ceil(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_ceil(Value, std::span<const Value> args) -> Value {
   return make(std::ceil(to_double(args[0])));
 }
 
-auto std_round(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr {
+auto std_round(Value, std::span<const Value> args) -> Value {
   return make(std::round(to_double(args[0])));
 }
 
-auto std_exit(ValuePtr, std::span<const ValuePtr>) -> ValuePtr { exit(0); }
+auto std_exit(Value, std::span<const Value>) -> Value { exit(0); }
 
-auto array_insertar(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
-  auto& arr = self->as_array();
+auto array_insertar(Value self, std::span<const Value> args) -> Value {
+  auto& arr = self.as_array();
   arr.push_back(args[0]);
   return make_null();
 }
 
-auto array_eliminar(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
-  auto& arr = self->as_array();
+auto array_eliminar(Value self, std::span<const Value> args) -> Value {
+  auto& arr = self.as_array();
 
   auto idx = args[0];
 
-  if (!idx->is_int())
+  if (!idx.is_int())
     throw RuntimeError("se esperaba entero");
 
-  auto i = idx->as_int();
+  auto i = idx.as_int();
 
   if (i < 0 || i >= static_cast<int64_t>(arr.size()))
     throw RuntimeError("Out of Bounce");
@@ -232,28 +233,28 @@ auto array_eliminar(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
   return make_null();
 }
 
-auto array_contiene(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
-  auto& arr = self->as_array();
+auto array_contiene(Value self, std::span<const Value> args) -> Value {
+  auto& arr = self.as_array();
   for (const auto& el : arr) {
-    if (el == args[0])
+    if (values_equal(el, args[0]))
       return make(true);
   }
   return make(false);
 }
 
 
-auto array_insertar_en(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
-  auto& arr = self->as_array();
+auto array_insertar_en(Value self, std::span<const Value> args) -> Value {
+  auto& arr = self.as_array();
 
   auto idx = args[0];
   auto val = args[1];
 
-  if (!idx->is_int())
+  if (!idx.is_int())
     throw RuntimeError(
       "insertar_en(): el indice debe ser un entero"
     );
 
-  auto i = idx->as_int();
+  auto i = idx.as_int();
 
   if (i < 0 ||
       i > static_cast<int64_t>(arr.size()))
@@ -269,27 +270,27 @@ auto array_insertar_en(ValuePtr self, std::span<const ValuePtr> args) -> ValuePt
   return make_null();
 }
 
-auto array_encuentra_index(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
-  auto& arr = self->as_array();
+auto array_encuentra_index(Value self, std::span<const Value> args) -> Value {
+  auto& arr = self.as_array();
 
   auto target = args[0];
 
   for (auto i{0uz}; i < arr.size(); ++i) {
 
-    if (arr[i]->to_string() == target->to_string())
+    if (arr[i].to_string() == target.to_string())
       return make(static_cast<int64_t>(i));
   }
   return make_null();
 }
 // STRING
 
-auto string_separar(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
-  auto& str = self->as_string();
-  auto delim = args[0]->to_string();
+auto string_separar(Value self, std::span<const Value> args) -> Value {
+  auto& str = self.as_string();
+  auto delim = args[0].to_string();
 
   std::stringstream ss(str);
   std::string item;
-  std::vector<ValuePtr> out;
+  std::vector<Value> out;
 
   while (std::getline(ss, item, delim[0]))
     out.push_back(make(item));
@@ -297,22 +298,22 @@ auto string_separar(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
   return make(out);
 }
 
-auto std_lower(ValuePtr self, std::span<const ValuePtr>) -> ValuePtr {
-  auto str = self->as_string();
+auto std_lower(Value self, std::span<const Value>) -> Value {
+  auto str = self.as_string();
   std::transform(str.begin(), str.end(), str.begin(), ::tolower);
   return make(str);
 }
 
-auto std_upper(ValuePtr self, std::span<const ValuePtr>) -> ValuePtr {
-  auto str = self->as_string();
+auto std_upper(Value self, std::span<const Value>) -> Value {
+  auto str = self.as_string();
   std::transform(str.begin(), str.end(), str.begin(), ::toupper);
   return make(str);
 }
 
-auto str_encuentra_index(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr {
-  auto str = self->as_string();
+auto str_encuentra_index(Value self, std::span<const Value> args) -> Value {
+  auto str = self.as_string();
 
-  std::size_t r = str.find(args[0]->to_string());
+  std::size_t r = str.find(args[0].to_string());
 
   if (std::string::npos == r)
     return make_null();
@@ -2,7 +2,7 @@
 #include "runtime_values.h"
 #include <string_view>
 
-using NativeMethod = ValuePtr(*)(ValuePtr self, std::span<const ValuePtr> args);
+using NativeMethod = Value(*)(Value self, std::span<const Value> args);
 
 struct NativeMethodDesc final {
   std::string_view name;
@@ -15,38 +15,38 @@ using NativeFuncDesc = NativeMethod;
 
 auto find_builtin(std::span<const NativeMethodDesc> list, std::string_view name) -> const NativeMethodDesc*;
 
-auto escribe(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto leer(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto aleatorio(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto entero(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto decimal(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto cadena(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_to_bool(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto longitud(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_abs(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_max (ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_min(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_pow(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_sqrt(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_floor(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_ceil(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_round(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_exit(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_is_int(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_is_float(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_is_str(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_is_bool(ValuePtr, std::span<const ValuePtr> args) -> ValuePtr;
+auto escribe(Value, std::span<const Value> args) -> Value;
+auto leer(Value, std::span<const Value> args) -> Value;
+auto aleatorio(Value, std::span<const Value> args) -> Value;
+auto entero(Value, std::span<const Value> args) -> Value;
+auto decimal(Value, std::span<const Value> args) -> Value;
+auto cadena(Value, std::span<const Value> args) -> Value;
+auto std_to_bool(Value, std::span<const Value> args) -> Value;
+auto longitud(Value, std::span<const Value> args) -> Value;
+auto std_abs(Value, std::span<const Value> args) -> Value;
+auto std_max (Value, std::span<const Value> args) -> Value;
+auto std_min(Value, std::span<const Value> args) -> Value;
+auto std_pow(Value, std::span<const Value> args) -> Value;
+auto std_sqrt(Value, std::span<const Value> args) -> Value;
+auto std_floor(Value, std::span<const Value> args) -> Value;
+auto std_ceil(Value, std::span<const Value> args) -> Value;
+auto std_round(Value, std::span<const Value> args) -> Value;
+auto std_exit(Value, std::span<const Value> args) -> Value;
+auto std_is_int(Value, std::span<const Value> args) -> Value;
+auto std_is_float(Value, std::span<const Value> args) -> Value;
+auto std_is_str(Value, std::span<const Value> args) -> Value;
+auto std_is_bool(Value, std::span<const Value> args) -> Value;
 
 // ARRAY
-auto array_insertar(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr;
-auto array_eliminar(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr;
-auto array_contiene(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr;
-auto array_insertar_en(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr;
-auto array_encuentra_index(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr;
+auto array_insertar(Value self, std::span<const Value> args) -> Value;
+auto array_eliminar(Value self, std::span<const Value> args) -> Value;
+auto array_contiene(Value self, std::span<const Value> args) -> Value;
+auto array_insertar_en(Value self, std::span<const Value> args) -> Value;
+auto array_encuentra_index(Value self, std::span<const Value> args) -> Value;
 
 // STRING
-auto string_separar(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_lower(ValuePtr self, std::span<const ValuePtr>) -> ValuePtr;
-auto std_upper(ValuePtr self, std::span<const ValuePtr>) -> ValuePtr;
-auto str_encuentra_index(ValuePtr self, std::span<const ValuePtr> args) -> ValuePtr;
-auto std_is_digit(ValuePtr self, std::span<const ValuePtr>) -> ValuePtr;
+auto string_separar(Value self, std::span<const Value> args) -> Value;
+auto std_lower(Value self, std::span<const Value>) -> Value;
+auto std_upper(Value self, std::span<const Value>) -> Value;
+auto str_encuentra_index(Value self, std::span<const Value> args) -> Value;
+auto std_is_digit(Value self, std::span<const Value>) -> Value;
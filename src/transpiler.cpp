@@ -0,0 +1,839 @@
+#include "transpiler.h"
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <string>
+#include <variant>
+#include "builtins.h"
+#include "error_manager.h"
+#include "nodes.h"
+#include "std.h"
+using enum NodeType;
+
+namespace {
+[[noreturn]] auto unsupported(std::string_view what) -> void {
+  throw RuntimeError(std::format("no se puede compilar a C++: {}", what));
+}
+
+auto pad(int indent) -> std::string {
+  return std::string(static_cast<std::size_t>(indent) * 2, ' ');
+}
+
+// C++ string literal with the bytes of 's'; anything outside printable
+// ASCII goes as a three-digit octal escape.
+auto quote(std::string_view s) -> std::string {
+  std::string out = "\"";
+  for (unsigned char c : s) {
+    if (c == '"' || c == '\\')
+      out += std::format("\\{}", static_cast<char>(c));
+    else if (c >= 0x20 && c < 0x7f)
+      out += static_cast<char>(c);
+    else
+      out += std::format("\\{:03o}", c);
+  }
+  return out + "\"";
+}
+
+auto int_literal(int64_t v) -> std::string {
+  if (v == std::numeric_limits<int64_t>::min())
+    return "std::numeric_limits<int64_t>::min()";
+  return std::format("int64_t{{{}}}", v);
+}
+
+auto float_literal(double v) -> std::string {
+  if (std::isnan(v)) return "std::numeric_limits<double>::quiet_NaN()";
+  if (std::isinf(v)) return v > 0 ? "std::numeric_limits<double>::infinity()" : "-std::numeric_limits<double>::infinity()";
+  auto text = std::format("{}", v);
+  if (text.find_first_of(".e") == std::string::npos) text += ".0";
+  return text;
+}
+
+auto token_name(TokenType op) -> std::string_view {
+  using enum TokenType;
+  switch (op) {
+    case PLUS:             return "PLUS";
+    case MINUS:            return "MINUS";
+    case STAR:             return "STAR";
+    case SLASH:            return "SLASH";
+    case EQUAL:            return "EQUAL";
+    case NOT_EQUAL:        return "NOT_EQUAL";
+    case LESSER_THAN:      return "LESSER_THAN";
+    case GREATER_THAN:     return "GREATER_THAN";
+    case LESSER_OR_EQUAL:  return "LESSER_OR_EQUAL";
+    case GREATER_OR_EQUAL: return "GREATER_OR_EQUAL";
+    default:               unsupported("operador binario desconocido");
+  }
+}
+
+auto comparison(TokenType op) -> std::string_view {
+  using enum TokenType;
+  switch (op) {
+    case EQUAL:            return "==";
+    case NOT_EQUAL:        return "!=";
+    case LESSER_THAN:      return "<";
+    case GREATER_THAN:     return ">";
+    case LESSER_OR_EQUAL:  return "<=";
+    case GREATER_OR_EQUAL: return ">=";
+    default:               return {};
+  }
+}
+
+// Keys of a name -> id table in id order, so output follows first use.
+template <class Key>
+auto by_id(const std::map<Key, std::size_t>& table) -> std::vector<Key> {
+  std::vector<Key> keys(table.size());
+  for (const auto& [key, id] : table) keys[id] = key;
+  return keys;
+}
+
+auto is_self(const IAST* node) -> bool {
+  return node->node_type == LITERAL && static_cast<const Literal*>(node)->token.type == TokenType::SELF;
+}
+
+// Layout the interpreter gives instances of 'node': the first declaration
+// of each field name, in order.
+auto fields_of(const ClassDecl* node) -> std::vector<const VariableDecl*> {
+  std::vector<const VariableDecl*> fields;
+  for (const auto& m : node->members) {
+    if (m->node_type != VARIABLEDECL) continue;
+    auto* vd = static_cast<const VariableDecl*>(m.get());
+    bool seen = false;
+    for (auto* f : fields) seen = seen || f->id == vd->id;
+    if (!seen) fields.push_back(vd);
+  }
+  return fields;
+}
+
+// Method 'name' of 'node' as ClassDef::methods keeps it: the last one.
+auto method_of(const ClassDecl* node, std::string_view name) -> const FunctionDecl* {
+  const FunctionDecl* found{};
+  for (const auto& m : node->members)
+    if (m->node_type == FUNCTIONDECL && static_cast<const FunctionDecl*>(m.get())->id == name)
+      found = static_cast<const FunctionDecl*>(m.get());
+  return found;
+}
+
+}
+
+auto Transpiler::translate(const StmtsPtr& program) -> std::string {
+  *this = Transpiler{};
+
+  // Everything a call or a global read can reach gets its C++ name up
+  // front, so definitions can be emitted in any order.
+  std::vector<const FunctionDecl*> frames{nullptr};
+  for (const auto& s : program)
+    declare(s.get(), frames);
+  _contexts.push_back({});
+
+  std::string defs;
+  for (auto* fn : _top_functions)
+    defs += "\n" + function(fn, nullptr, 0);
+  for (auto* cls : _class_list) {
+    for (const auto& m : cls->members)
+      if (m->node_type == FUNCTIONDECL)
+        defs += "\n" + function(static_cast<const FunctionDecl*>(m.get()), cls, 0);
+    defs += "\n" + constructor(cls);
+  }
+  defs += "\nauto run() -> void {\n" + stmts(program, 1) + "}\n";
+  for (const auto& [name, argc] : by_id(_dispatchers))
+    defs += "\n" + dispatcher(name, argc, _dispatchers.at({name, argc}));
+
+  std::string out =
+    "// Generado por 'olm --compilar'. Se compila junto al runtime de olm\n"
+    "// (src/*.cpp salvo main.cpp) con -std=c++23 -I<olm>/src.\n"
+    "#include <cstdint>\n"
+    "#include <cstdlib>\n"
+    "#include <functional>\n"
+    "#include <limits>\n"
+    "#include <memory>\n"
+    "#include <print>\n"
+    "#include <string>\n"
+    "#include <vector>\n"
+    "#include \"aot.h\"\n"
+    "\n"
+    "namespace {\n";
+
+  for (const auto& name : by_id(_names))
+    out += std::format("const std::string* const n{} = intern({});\n", _names.at(name), quote(name));
+  for (const auto& text : by_id(_strings))
+    out += std::format("const Value k{} = make(std::string({}, {}));\n", _strings.at(text), quote(text), text.size());
+  for (auto* cls : _class_list) {
+    std::string fields;
+    for (auto* f : fields_of(cls))
+      fields += (fields.empty() ? "" : ", ") + quote(f->id);
+    out += std::format("const auto c{} = aot::make_class({}, {{{}}});\n", _class_ids.at(cls), quote(cls->id), fields);
+  }
+  for (auto* g : _globals) {
+    const auto& var = _vars.at(g);
+    out += std::format("{} {}{{}};\nbool {}_set{{}};\n", type_name(var.repr), var.name, var.name);
+  }
+
+  out += "\n";
+  auto params = [](std::string_view prefix, std::size_t n) {
+    std::string text;
+    for (auto i {0uz}; i < n; ++i)
+      text += std::format("{}Value {}{}", text.empty() ? "" : ", ", prefix, i);
+    return text;
+  };
+  for (auto* fn : _top_functions)
+    out += std::format("auto f{}({}) -> Value;\n", _function_ids.at(fn), params("p", fn->params.size()));
+  for (auto* cls : _class_list) {
+    for (const auto& m : cls->members) {
+      if (m->node_type != FUNCTIONDECL) continue;
+      auto* fn = static_cast<const FunctionDecl*>(m.get());
+      out += std::format("auto m{}(const Value& self{}{}) -> Value;\n", _function_ids.at(fn),
+                         fn->params.empty() ? "" : ", ", params("p", fn->params.size()));
+    }
+    auto* ctor = method_of(cls, "crear");
+    out += std::format("auto new{}({}) -> Value;\n", _class_ids.at(cls), params("p", ctor ? ctor->params.size() : 0));
+  }
+  for (const auto& [name, argc] : by_id(_dispatchers))
+    out += std::format("auto d{}(const Value& recv{}{}) -> Value;\n", _dispatchers.at({name, argc}),
+                       argc ? ", " : "", params("p", argc));
+
+  out += defs;
+  out +=
+    "}\n"
+    "\n"
+    "auto main() -> int {\n"
+    "  try {\n"
+    "    run();\n"
+    "  } catch (const RuntimeError& e) {\n"
+    "    std::println(stderr, \"{}\", e.what());\n"
+    "    return EXIT_FAILURE;\n"
+    "  }\n"
+    "  return EXIT_SUCCESS;\n"
+    "}\n";
+  return out;
+}
+
+// 'frames' mirrors Sema's: the program, then one entry per function or
+// field initializer (null) around 'node'.
+auto Transpiler::declare(const IAST* node, std::vector<const FunctionDecl*>& frames) -> void {
+  if (!node) return;
+  switch (node->node_type) {
+    case FUNCTIONDECL: {
+      auto* fn = static_cast<const FunctionDecl*>(node);
+      _function_ids[fn] = _function_ids.size();
+      _functions[fn->id] = fn;
+      if (!fn->enclosing) _top_functions.push_back(fn);
+      frames.push_back(fn);
+      for (const auto& s : fn->body) declare(s.get(), frames);
+      frames.pop_back();
+      break;
+    }
+    case CLASSDECL:
+      declare_class(static_cast<const ClassDecl*>(node), frames);
+      break;
+    case VARIABLEDECL: {
+      auto* vd = static_cast<const VariableDecl*>(node);
+      if (frames.size() == 1) {
+        _vars[vd] = {.name = std::format("g{}", _globals.size()), .repr = repr_of(vd->type), .global = true};
+        _globals.push_back(vd);
+      }
+      break;
+    }
+    case ASSIGNMENT: {
+      // A local a nested function assigns can change under any call.
+      auto* as = static_cast<const Assignment*>(node);
+      if (as->target->node_type != LITERAL) break;
+      auto* lit = static_cast<const Literal*>(as->target.get());
+      if (!lit->slot.resolved() || lit->slot.depth == 0) break;
+      if (lit->decl) {
+        if (auto it = _vars.find(lit->decl); it == _vars.end() || !it->second.global)
+          _shared_vars.insert(lit->decl);
+      } else if (lit->slot.depth < frames.size()) {
+        auto* fn = frames[frames.size() - 1 - lit->slot.depth];
+        if (fn && lit->slot.index < fn->params.size())
+          _shared_params.insert({fn, lit->slot.index});
+      }
+      break;
+    }
+    case IFSTATEMENT: {
+      auto* s = static_cast<const IfStatement*>(node);
+      for (const auto& t : s->then_body) declare(t.get(), frames);
+      if (auto* els = std::get_if<StmtsPtr>(&s->next))
+        for (const auto& e : *els) declare(e.get(), frames);
+      else if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&s->next))
+        declare(elif->get(), frames);
+      break;
+    }
+    case WHILESTATEMENT:
+      for (const auto& b : static_cast<const WhileStatement*>(node)->body) declare(b.get(), frames);
+      break;
+    default: break;
+  }
+}
+
+auto Transpiler::declare_class(const ClassDecl* node, std::vector<const FunctionDecl*>& frames) -> void {
+  if (frames.size() != 1 || node->enclosing)
+    unsupported(std::format("la clase '{}' se declara dentro de una funcion", node->id));
+  _class_ids[node] = _class_list.size();
+  _class_list.push_back(node);
+  _classes[node->id] = node;
+
+  for (const auto& m : node->members) {
+    if (m->node_type == FUNCTIONDECL) {
+      auto* fn = static_cast<const FunctionDecl*>(m.get());
+      _function_ids[fn] = _function_ids.size();
+      frames.push_back(fn);
+      for (const auto& s : fn->body) declare(s.get(), frames);
+    } else {
+      frames.push_back(nullptr);
+    }
+    frames.pop_back();
+  }
+}
+
+// Top-level functions and methods come out as namespace-scope functions,
+// nested ones as an assignment to the std::function hoist() declared.
+auto Transpiler::function(const FunctionDecl* fn, const ClassDecl* klass, int indent) -> std::string {
+  auto id = _function_ids.at(fn);
+  std::string params = fn->enclosing || !klass ? "" : "const Value& self";
+  for (auto i {0uz}; i < fn->params.size(); ++i)
+    params += std::format("{}Value a{}_{}", params.empty() ? "" : ", ", id, i);
+
+  _contexts.push_back({.fn = fn, .klass = klass});
+  auto body = hoist(fn->body, indent + 1);
+  auto code = stmts(fn->body, indent + 1);
+  if (_contexts.back().tail) body += pad(indent) + "top:;\n";
+  _contexts.pop_back();
+  body += code + pad(indent + 1) + "return make_null();\n";
+
+  if (fn->enclosing)
+    return std::format("{}f{} = [&]({}) -> Value {{\n{}{}}};\n", pad(indent), id, params, body, pad(indent));
+  return std::format("auto {}{}({}) -> Value {{\n{}}}\n", klass ? "m" : "f", id, params, body);
+}
+
+// Functions declared in 'body' exist from its start, and fail like an
+// unknown name until their declaration runs.
+auto Transpiler::hoist(const StmtsPtr& body, int indent) -> std::string {
+  std::string out;
+  for (const auto& s : body) {
+    switch (s->node_type) {
+      case FUNCTIONDECL: {
+        auto* fn = static_cast<const FunctionDecl*>(s.get());
+        std::string params;
+        for (auto i {0uz}; i < fn->params.size(); ++i)
+          params += i ? ", Value" : "Value";
+        out += std::format("{}std::function<Value({})> f{} = aot::undefined({});\n",
+                           pad(indent), params, _function_ids.at(fn), quote(fn->id));
+        break;
+      }
+      case IFSTATEMENT: {
+        for (auto* node = static_cast<const IfStatement*>(s.get()); node;) {
+          out += hoist(node->then_body, indent);
+          if (auto* els = std::get_if<StmtsPtr>(&node->next)) {
+            out += hoist(*els, indent);
+            break;
+          }
+          auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&node->next);
+          node = elif ? elif->get() : nullptr;
+        }
+        break;
+      }
+      case WHILESTATEMENT:
+        out += hoist(static_cast<const WhileStatement*>(s.get())->body, indent);
+        break;
+      default: break;
+    }
+  }
+  return out;
+}
+
+// Same steps as Interpreter::instantiate: field initializers in layout
+// order, then 'crear'.
+auto Transpiler::constructor(const ClassDecl* node) -> std::string {
+  auto id    = _class_ids.at(node);
+  auto* ctor = method_of(node, "crear");
+  auto argc  = ctor ? ctor->params.size() : 0;
+
+  std::string params, args;
+  for (auto i {0uz}; i < argc; ++i) {
+    params += std::format("{}Value p{}", i ? ", " : "", i);
+    args   += std::format(", std::move(p{})", i);
+  }
+
+  auto out = std::format("auto new{}({}) -> Value {{\n  Value self{{InstancePtr::make(c{})}};\n", id, params, id);
+  _contexts.push_back({.klass = node});
+  auto fields = fields_of(node);
+  for (auto i {0uz}; i < fields.size(); ++i)
+    if (fields[i]->expr)
+      out += std::format("  self.as_instance()->slots[{}] = {};\n", i, box(expr(fields[i]->expr.get())));
+  _contexts.pop_back();
+  if (ctor)
+    out += std::format("  m{}(self{});\n", _function_ids.at(ctor), args);
+  return out + "  return self;\n}\n";
+}
+
+// Method call by name on a receiver only known at run time: instances of
+// every class with such a method, then arrays and strings.
+auto Transpiler::dispatcher(const std::string& name, std::size_t argc, std::size_t id) -> std::string {
+  std::string params, args;
+  for (auto i {0uz}; i < argc; ++i) {
+    params += std::format(", Value p{}", i);
+    args   += std::format("{}std::move(p{})", i ? ", " : "", i);
+  }
+
+  auto out = std::format("auto d{}(const Value& recv{}) -> Value {{\n  if (recv.is_instance()) {{\n"
+                         "    const auto* klass = recv.as_instance()->klass.get();\n", id, params);
+  for (auto* cls : _class_list) {
+    auto* method = method_of(cls, name);
+    if (!method) continue;
+    if (method->params.size() == argc)
+      out += std::format("    if (klass == c{}.get()) return m{}(recv{}{});\n",
+                         _class_ids.at(cls), _function_ids.at(method), argc ? ", " : "", args);
+    else
+      out += std::format("    if (klass == c{}.get()) return aot::fail({});\n", _class_ids.at(cls),
+                         quote(std::format("'{}' espera {} argumento(s), obtuvo {}", name, method->params.size(), argc)));
+  }
+  out += std::format("    return aot::fail(std::format(\"'{{}}' no tiene metodo '{{}}'\", klass->name, {}));\n  }}\n", quote(name));
+  return out + std::format("  return aot::invoke(recv, {}, {{{}}});\n}}\n", quote(name), args);
+}
+
+auto Transpiler::stmts(const StmtsPtr& body, int indent) -> std::string {
+  std::string out;
+  for (const auto& s : body)
+    out += stmt(s.get(), indent);
+  return out;
+}
+
+auto Transpiler::stmt(const IAST* node, int indent) -> std::string {
+  if (!node) return {};
+  switch (node->node_type) {
+    case VARIABLEDECL: {
+      auto* vd = static_cast<const VariableDecl*>(node);
+      auto value = expr(vd->expr.get());
+      if (auto it = _vars.find(vd); it != _vars.end() && it->second.global)
+        return std::format("{}{} = {};\n{}{}_set = true;\n", pad(indent), it->second.name,
+                           convert(value, it->second.repr), pad(indent), it->second.name);
+      auto repr = repr_of(vd->type);
+      auto& var = _vars[vd] = {.name = std::format("v{}", _locals++), .repr = repr};
+      return std::format("{}{} {} = {};\n", pad(indent), type_name(repr), var.name, convert(value, repr));
+    }
+    case FUNCTIONDECL: {
+      auto* fn = static_cast<const FunctionDecl*>(node);
+      return fn->enclosing ? function(fn, _contexts.back().klass, indent) : std::string{};
+    }
+    case CLASSDECL:      return {};
+    case ASSIGNMENT:     return assignment(static_cast<const Assignment*>(node), indent);
+    case IFSTATEMENT:    return pad(indent) + if_stmt(static_cast<const IfStatement*>(node), indent);
+    case WHILESTATEMENT: {
+      auto* s = static_cast<const WhileStatement*>(node);
+      return std::format("{}while ({}) {{\n{}{}}}\n", pad(indent), truthy(expr(s->condition.get())),
+                         stmts(s->body, indent + 1), pad(indent));
+    }
+    case RETURNSTATEMENT: return return_stmt(static_cast<const ReturnStatement*>(node), indent);
+    case CONTINUESTMT:    return pad(indent) + "continue;\n";
+    case FUNCTIONCALL:
+    case METHODCALL:      return std::format("{}{};\n", pad(indent), expr(node).text);
+    default:
+      unsupported("nodo de declaracion desconocido");
+  }
+}
+
+auto Transpiler::assignment(const Assignment* node, int indent) -> std::string {
+  auto value = expr(node->expr.get());
+
+  if (node->target->node_type == LITERAL) {
+    auto* lit = static_cast<const Literal*>(node->target.get());
+    if (lit->decl) {
+      const auto& var = _vars.at(lit->decl);
+      if (var.global && _contexts.size() > 1)
+        return std::format("{}aot::assign({}, {}_set, {}, {});\n", pad(indent), var.name, var.name,
+                           convert(value, var.repr), quote(lit->token.literal));
+      return std::format("{}{} = {};\n", pad(indent), var.name, convert(value, var.repr));
+    }
+    if (auto p = param(lit))
+      return std::format("{}a{}_{} = {};\n", pad(indent), _function_ids.at(p->first), p->second, box(value));
+    unsupported(std::format("asignacion a '{}'", lit->token.literal));
+  }
+
+  // The value is computed before the object, as in the interpreter.
+  auto t = std::format("t{}", _temps++);
+  auto out = std::format("{}{{\n{}auto {} = {};\n", pad(indent), pad(indent + 1), t, box(value));
+  if (node->target->node_type == MEMBERACCESS) {
+    auto* member = static_cast<const MemberAccess*>(node->target.get());
+    if (auto slot = self_slot(member->object.get(), member->field); slot != ClassDef::NO_SLOT)
+      out += std::format("{}self.as_instance()->slots[{}] = std::move({});\n", pad(indent + 1), slot, t);
+    else
+      out += std::format("{}aot::set_field({}, {}, std::move({}));\n", pad(indent + 1),
+                         box(expr(member->object.get())), name_of(*member->field), t);
+  } else if (node->target->node_type == INDEXEXPR) {
+    auto* idx = static_cast<const IndexExpr*>(node->target.get());
+    auto obj = std::format("t{}", _temps++);
+    auto at  = std::format("t{}", _temps++);
+    out += std::format("{}auto {} = {};\n", pad(indent + 1), obj, box(expr(idx->object.get())));
+    out += std::format("{}auto {} = {};\n", pad(indent + 1), at, box(expr(idx->index.get())));
+    out += std::format("{}assign_index({}, {}, std::move({}));\n", pad(indent + 1), obj, at, t);
+  } else {
+    unsupported("asignacion a objetivo invalido");
+  }
+  return out + pad(indent) + "}\n";
+}
+
+// Without the leading indentation, so 'sino si' chains as 'else if'.
+auto Transpiler::if_stmt(const IfStatement* node, int indent) -> std::string {
+  auto out = std::format("if ({}) {{\n{}{}}}", truthy(expr(node->condition.get())),
+                         stmts(node->then_body, indent + 1), pad(indent));
+  if (auto* els = std::get_if<StmtsPtr>(&node->next))
+    return out + std::format(" else {{\n{}{}}}\n", stmts(*els, indent + 1), pad(indent));
+  if (auto* elif = std::get_if<std::unique_ptr<IfStatement>>(&node->next))
+    return out + " else " + if_stmt(elif->get(), indent);
+  return out + "\n";
+}
+
+// A tail call to the function itself reuses its parameters and jumps back
+// to the top, like the interpreter reuses the frame.
+auto Transpiler::return_stmt(const ReturnStatement* node, int indent) -> std::string {
+  auto& ctx = _contexts.back();
+  if (!ctx.fn)
+    return pad(indent) + "return;\n";
+
+  if (node->tail_call) {
+    auto* call = static_cast<const FunctionCall*>(node->expr.get());
+    if (callee(call) == ctx.fn && call->exprs.size() == ctx.fn->params.size()) {
+      auto id = _function_ids.at(ctx.fn);
+      std::string out = pad(indent) + "{\n", moves;
+      for (auto i {0uz}; i < call->exprs.size(); ++i) {
+        auto t = std::format("t{}", _temps++);
+        out   += std::format("{}auto {} = {};\n", pad(indent + 1), t, box(expr(call->exprs[i].get())));
+        moves += std::format("{}a{}_{} = std::move({});\n", pad(indent + 1), id, i, t);
+      }
+      ctx.tail = true;
+      return out + moves + pad(indent + 1) + "goto top;\n" + pad(indent) + "}\n";
+    }
+  }
+  return std::format("{}return {};\n", pad(indent), node->expr ? box(expr(node->expr.get())) : "make_null()");
+}
+
+auto Transpiler::expr(const IAST* node) -> Code {
+  if (!node) return {.text = "make_null()", .repr = Repr::VALUE, .simple = true};
+  switch (node->node_type) {
+    case LITERAL:      return literal(static_cast<const Literal*>(node));
+    case BINARYOP:     return binary(static_cast<const BinaryOp*>(node));
+    case UNARYOP:      return unary(static_cast<const UnaryOp*>(node));
+    case FUNCTIONCALL: return call(static_cast<const FunctionCall*>(node));
+    case METHODCALL:   return method_call(static_cast<const MethodCall*>(node));
+    case MEMBERACCESS: return member(static_cast<const MemberAccess*>(node));
+    case ARRAYDECL: {
+      // A braced list is evaluated left to right.
+      std::string items;
+      for (const auto& el : static_cast<const ArrayDecl*>(node)->data)
+        items += (items.empty() ? "" : ", ") + box(expr(el.get()));
+      return {.text = std::format("make(std::vector<Value>{{{}}})", items), .repr = Repr::VALUE};
+    }
+    case INDEXEXPR: {
+      auto* idx = static_cast<const IndexExpr*>(node);
+      return sequenced({boxed(expr(idx->object.get())), boxed(expr(idx->index.get()))}, Repr::VALUE,
+        [](const auto& p) { return std::format("index_value({}, {})", p[0], p[1]); });
+    }
+    default:
+      unsupported("nodo de expresion desconocido");
+  }
+}
+
+auto Transpiler::literal(const Literal* node) -> Code {
+  switch (node->token.type) {
+    case TokenType::SELF:       return {.text = "self", .repr = Repr::VALUE, .simple = true};
+    case TokenType::IDENTIFIER: return variable(node);
+    default: break;
+  }
+  const auto& v = node->value;
+  if (v.is_int())    return {.text = int_literal(v.as_int()), .repr = Repr::INT, .simple = true};
+  if (v.is_float())  return {.text = float_literal(v.as_float()), .repr = Repr::FLOAT, .simple = true};
+  if (v.is_bool())   return {.text = v.as_bool() ? "true" : "false", .repr = Repr::BOOL, .simple = true};
+  if (v.is_string()) return {.text = string_of(v.as_string()), .repr = Repr::VALUE, .simple = true};
+  if (v.is_null())   return {.text = "make_null()", .repr = Repr::VALUE, .simple = true};
+  unsupported(std::format("literal desconocido '{}'", node->token.literal));
+}
+
+// Reads of the running function's own locals are 'simple' unless a nested
+// function assigns them; anything else may change during a call.
+auto Transpiler::variable(const Literal* node) -> Code {
+  const auto& name = node->token.literal;
+  if (node->decl) {
+    const auto& var = _vars.at(node->decl);
+    if (var.global && _contexts.size() > 1)
+      return {.text = std::format("aot::global({}, {}_set, {})", var.name, var.name, quote(name)), .repr = var.repr};
+    bool own = !var.global && node->slot.depth == 0 && !_shared_vars.contains(node->decl);
+    return {.text = var.name, .repr = var.repr, .simple = own};
+  }
+  if (auto p = param(node)) {
+    bool own = node->slot.depth == 0 && !_shared_params.contains(*p);
+    return {.text = std::format("a{}_{}", _function_ids.at(p->first), p->second), .repr = Repr::VALUE, .simple = own};
+  }
+  // A function or class name read as a value is the null sentinel its
+  // declaration stores.
+  if (_functions.contains(name) || _classes.contains(name))
+    return {.text = "make_null()", .repr = Repr::VALUE, .simple = true};
+  return {.text = std::format("aot::fail({})", quote(std::format("variable '{}' no definida", name))), .repr = Repr::VALUE};
+}
+
+auto Transpiler::binary(const BinaryOp* node) -> Code {
+  using enum TokenType;
+  auto op = node->op.type;
+  auto l  = expr(node->left.get());
+  auto r  = expr(node->right.get());
+
+  if (op == AND || op == OR)
+    return {.text = std::format("({} {} {})", truthy(l), op == AND ? "&&" : "||", truthy(r)),
+            .repr = Repr::BOOL, .simple = l.simple && r.simple};
+
+  auto kind = node->operands;
+  if (kind == StaticType::UNKNOWN && l.repr == r.repr && (l.repr == Repr::INT || l.repr == Repr::FLOAT))
+    kind = l.repr == Repr::INT ? StaticType::INT : StaticType::FLOAT;
+
+  if (kind == StaticType::INT || kind == StaticType::FLOAT) {
+    auto repr = kind == StaticType::INT ? Repr::INT : Repr::FLOAT;
+    std::vector<Code> parts{
+      {.text = convert(l, repr), .repr = repr, .simple = l.simple},
+      {.text = convert(r, repr), .repr = repr, .simple = r.simple},
+    };
+    if (auto cmp = comparison(op); !cmp.empty()) {
+      auto out = sequenced(std::move(parts), Repr::BOOL,
+        [cmp](const auto& p) { return std::format("({} {} {})", p[0], cmp, p[1]); });
+      out.simple = l.simple && r.simple;
+      return out;
+    }
+    std::string_view fn, sym;
+    switch (op) {
+      case PLUS:  fn = "add"; sym = "+"; break;
+      case MINUS: fn = "sub"; sym = "-"; break;
+      case STAR:  fn = "mul"; sym = "*"; break;
+      case SLASH: fn = "div"; break;
+      default:    unsupported("operador binario desconocido");
+    }
+    // Float +, - and * cannot fail; everything else checks its operands.
+    bool checked = repr == Repr::INT || op == SLASH;
+    auto out = sequenced(std::move(parts), repr, [checked, fn, sym](const auto& p) {
+      if (checked) return std::format("aot::{}({}, {})", fn, p[0], p[1]);
+      return std::format("({} {} {})", p[0], sym, p[1]);
+    });
+    out.simple = !checked && l.simple && r.simple;
+    return out;
+  }
+
+  return sequenced({boxed(l), boxed(r)}, Repr::VALUE, [op](const auto& p) {
+    return std::format("binary_op(TokenType::{}, {}, {})", token_name(op), p[0], p[1]);
+  });
+}
+
+auto Transpiler::unary(const UnaryOp* node) -> Code {
+  auto operand = expr(node->operand.get());
+  switch (node->op) {
+    case TokenType::BANG:
+      return {.text = std::format("(!{})", truthy(operand)), .repr = Repr::BOOL, .simple = operand.simple};
+    case TokenType::MINUS:
+      if (operand.repr == Repr::INT)
+        return {.text = std::format("aot::neg({})", operand.text), .repr = Repr::INT};
+      if (operand.repr == Repr::FLOAT)
+        return {.text = std::format("(-{})", operand.text), .repr = Repr::FLOAT, .simple = operand.simple};
+      return {.text = std::format("unary_op(TokenType::MINUS, {})", box(operand)), .repr = Repr::VALUE};
+    default:
+      unsupported("operador unario desconocido");
+  }
+}
+
+// Resolved like the bytecode Compiler does: builtins, then classes, then
+// the last function declared with the name.
+auto Transpiler::call(const FunctionCall* node) -> Code {
+  std::vector<Code> args;
+  for (const auto& a : node->exprs)
+    args.push_back(boxed(expr(a.get())));
+  auto joined = [](const auto& p, std::size_t from = 0) {
+    std::string text;
+    for (auto i = from; i < p.size(); ++i)
+      text += std::format("{}{}", i > from ? ", " : "", p[i]);
+    return text;
+  };
+  // Arguments still run, in order, before the call fails.
+  auto failing = [&](std::string msg) {
+    std::string text = "(";
+    for (const auto& a : args) text += std::format("(void)({}), ", a.text);
+    return Code{.text = text + std::format("aot::fail({}))", quote(msg)), .repr = Repr::VALUE};
+  };
+
+  if (node->id == "__index__" && args.size() == 2)
+    return sequenced(std::move(args), Repr::VALUE,
+      [](const auto& p) { return std::format("index_value({}, {})", p[0], p[1]); });
+
+  if (auto* desc = find_builtin(FREE_FUNCTIONS, node->id)) {
+    if (!desc->variadic && args.size() != desc->arity)
+      return failing(std::format("'{}' espera {} argumento(s) pero recibio {}", desc->name, desc->arity, args.size()));
+    std::string list;
+    for (const auto& a : args) list += (list.empty() ? "" : ", ") + a.text;
+    return {.text = std::format("aot::builtin(FREE_FUNCTIONS[{}], {{{}}})", desc - FREE_FUNCTIONS, list), .repr = Repr::VALUE};
+  }
+
+  if (auto it = _classes.find(node->id); it != _classes.end()) {
+    auto* ctor = method_of(it->second, "crear");
+    if (!ctor && !args.empty())
+      return failing(std::format("clase '{}' no tiene constructor: ", node->id));
+    if (ctor && ctor->params.size() != args.size())
+      return failing(std::format("'crear' espera {} argumento(s), obtuvo {}", ctor->params.size(), args.size()));
+    auto id = _class_ids.at(it->second);
+    return sequenced(std::move(args), Repr::VALUE,
+      [&](const auto& p) { return std::format("new{}({})", id, joined(p)); });
+  }
+
+  auto* fn = callee(node);
+  if (!fn)
+    return failing(std::format("funcion '{}' no definida", node->id));
+  if (fn->params.size() != args.size())
+    return failing(std::format("'{}' espera {} argumento(s), obtuvo {}", fn->id, fn->params.size(), args.size()));
+  if (fn->enclosing) {
+    bool visible = false;
+    for (const auto& ctx : _contexts) visible = visible || ctx.fn == fn->enclosing;
+    if (!visible)
+      return failing("funcion anidada llamada fuera de la funcion que la declara");
+  }
+  auto id = _function_ids.at(fn);
+  return sequenced(std::move(args), Repr::VALUE,
+    [&](const auto& p) { return std::format("f{}({})", id, joined(p)); });
+}
+
+auto Transpiler::method_call(const MethodCall* node) -> Code {
+  std::vector<Code> parts{boxed(expr(node->object.get()))};
+  for (const auto& a : node->args)
+    parts.push_back(boxed(expr(a.get())));
+  auto joined = [](const auto& p) {
+    std::string text;
+    for (auto i {0uz}; i < p.size(); ++i)
+      text += std::format("{}{}", i ? ", " : "", p[i]);
+    return text;
+  };
+
+  // 'este.m()' inside the class that declares 'm' needs no dispatch.
+  if (auto* klass = _contexts.back().klass; klass && is_self(node->object.get()))
+    if (auto* method = method_of(klass, node->name); method && method->params.size() == node->args.size()) {
+      auto id = _function_ids.at(method);
+      return sequenced(std::move(parts), Repr::VALUE,
+        [&](const auto& p) { return std::format("m{}({})", id, joined(p)); });
+    }
+
+  auto [it, _] = _dispatchers.try_emplace({node->name, node->args.size()}, _dispatchers.size());
+  auto id = it->second;
+  return sequenced(std::move(parts), Repr::VALUE,
+    [&](const auto& p) { return std::format("d{}({})", id, joined(p)); });
+}
+
+auto Transpiler::member(const MemberAccess* node) -> Code {
+  if (auto slot = self_slot(node->object.get(), node->field); slot != ClassDef::NO_SLOT)
+    return {.text = std::format("self.as_instance()->slots[{}]", slot), .repr = Repr::VALUE};
+  return {.text = std::format("aot::get_field({}, {})", box(expr(node->object.get())), name_of(*node->field)),
+          .repr = Repr::VALUE};
+}
+
+// 'build' gets the C++ text of each part. C++ leaves the order of function
+// arguments and operands open, so when more than one part can observe or
+// cause side effects they are first stored, in order, in temporaries.
+auto Transpiler::sequenced(std::vector<Code> parts, Repr repr, auto build) -> Code {
+  std::size_t effects = 0;
+  for (const auto& p : parts) effects += !p.simple;
+
+  std::vector<std::string> texts;
+  if (effects < 2) {
+    for (auto& p : parts) texts.push_back(std::move(p.text));
+    return {.text = build(texts), .repr = repr};
+  }
+  std::string init;
+  for (auto& p : parts) {
+    if (p.simple) {
+      texts.push_back(std::move(p.text));
+      continue;
+    }
+    texts.push_back(std::format("t{}", _temps++));
+    init += std::format("auto {} = {}; ", texts.back(), p.text);
+  }
+  return {.text = std::format("[&] {{ {}return {}; }}()", init, build(texts)), .repr = repr};
+}
+
+// Slot of 'field' when 'object' is 'este' and the enclosing class declares it.
+auto Transpiler::self_slot(const IAST* object, const std::string* field) const -> std::size_t {
+  auto* klass = _contexts.empty() ? nullptr : _contexts.back().klass;
+  if (!klass || !is_self(object))
+    return ClassDef::NO_SLOT;
+  auto fields = fields_of(klass);
+  for (auto i {0uz}; i < fields.size(); ++i)
+    if (fields[i]->id == *field) return i;
+  return ClassDef::NO_SLOT;
+}
+
+// Parameter an identifier Sema resolved without a VariableDecl names.
+auto Transpiler::param(const Literal* node) const -> std::optional<Param> {
+  if (!node->slot.resolved() || node->slot.depth >= _contexts.size())
+    return std::nullopt;
+  auto* fn = _contexts[_contexts.size() - 1 - node->slot.depth].fn;
+  if (!fn || node->slot.index >= fn->params.size() || fn->params[node->slot.index] != node->token.literal)
+    return std::nullopt;
+  return Param{fn, node->slot.index};
+}
+
+// The declaration Sema resolved the call to, so a nested function only
+// shadows its name inside the function that declares it.
+auto Transpiler::callee(const FunctionCall* node) const -> const FunctionDecl* {
+  if (node->id == "__index__" || find_builtin(FREE_FUNCTIONS, node->id) || _classes.contains(node->id))
+    return nullptr;
+  if (node->decl)
+    return node->decl->node_type == FUNCTIONDECL ? static_cast<const FunctionDecl*>(node->decl) : nullptr;
+  auto it = _functions.find(node->id);
+  return it == _functions.end() ? nullptr : it->second;
+}
+
+auto Transpiler::name_of(std::string_view field) -> std::string {
+  auto [it, _] = _names.try_emplace(std::string(field), _names.size());
+  return std::format("n{}", it->second);
+}
+
+auto Transpiler::string_of(const std::string& s) -> std::string {
+  auto [it, _] = _strings.try_emplace(s, _strings.size());
+  return std::format("k{}", it->second);
+}
+
+auto Transpiler::boxed(Code code) -> Code {
+  return {.text = box(code), .repr = Repr::VALUE, .simple = code.simple};
+}
+
+auto Transpiler::box(const Code& code) -> std::string {
+  return code.repr == Repr::VALUE ? code.text : std::format("make({})", code.text);
+}
+
+// Sema guarantees the value has the representation asked for.
+auto Transpiler::convert(const Code& code, Repr repr) -> std::string {
+  if (code.repr == repr) return code.text;
+  switch (repr) {
+    case Repr::INT:   return std::format("{}.as_int()", box(code));
+    case Repr::FLOAT: return std::format("{}.as_float()", box(code));
+    case Repr::BOOL:  return std::format("{}.as_bool()", box(code));
+    default:          return box(code);
+  }
+}
+
+auto Transpiler::truthy(const Code& code) -> std::string {
+  switch (code.repr) {
+    case Repr::INT:   return std::format("({} != 0)", code.text);
+    case Repr::FLOAT: return std::format("({} != 0.0)", code.text);
+    case Repr::BOOL:  return code.text;
+    default:          return std::format("{}.truthy()", code.text);
+  }
+}
+
+auto Transpiler::repr_of(StaticType type) -> Repr {
+  switch (type) {
+    case StaticType::INT:   return Repr::INT;
+    case StaticType::FLOAT: return Repr::FLOAT;
+    case StaticType::BOOL:  return Repr::BOOL;
+    default:                return Repr::VALUE;
+  }
+}
+
+auto Transpiler::type_name(Repr repr) -> std::string_view {
+  switch (repr) {
+    case Repr::INT:   return "int64_t";
+    case Repr::FLOAT: return "double";
+    case Repr::BOOL:  return "bool";
+    default:          return "Value";
+  }
+}
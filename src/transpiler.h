@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "nodes.h"
+
+// Translates an analyzed program into C++ that links against the runtime
+// (Value, operators.h, the builtins) and needs no interpreter: functions
+// become C++ functions, variables C++ variables (int64_t, double or bool
+// where Sema inferred the type) and every call is resolved here, the way
+// the bytecode Compiler resolves it. Nested functions become lambdas over
+// the enclosing locals. Used by 'olm --compilar'; the generated code calls
+// into aot.h.
+class Transpiler final {
+public:
+  auto translate(const StmtsPtr& program) -> std::string;
+
+private:
+  enum class Repr : uint8_t { VALUE, INT, FLOAT, BOOL };
+
+  // A C++ expression and the type it evaluates to. 'simple' ones (constants
+  // and locals nothing else assigns) may be evaluated in any order.
+  struct Code final {
+    std::string text{};
+    Repr        repr{};
+    bool        simple{};
+  };
+
+  struct Var final {
+    std::string name{};
+    Repr        repr{};
+    bool        global{};
+  };
+
+  // One per Sema frame: the program, a function or method, or a field
+  // initializer, so a VarSlot depth indexes it from the back.
+  struct Context final {
+    const FunctionDecl* fn{};
+    const ClassDecl*    klass{};  // whose 'este' is in scope
+    bool                tail{};   // 'fn' jumps back to its start for a tail call to itself
+  };
+
+  using Param = std::pair<const FunctionDecl*, std::size_t>;
+
+  std::vector<Context>                                     _contexts{};
+  std::unordered_map<const VariableDecl*, Var>             _vars{};
+  std::unordered_map<std::string_view, const FunctionDecl*> _functions{};  // last declaration wins
+  std::unordered_map<std::string_view, const ClassDecl*>   _classes{};
+  std::unordered_map<const FunctionDecl*, std::size_t>     _function_ids{};
+  std::unordered_map<const ClassDecl*, std::size_t>        _class_ids{};
+  std::vector<const FunctionDecl*>                         _top_functions{};
+  std::vector<const ClassDecl*>                            _class_list{};
+  std::vector<const VariableDecl*>                         _globals{};
+  std::set<const VariableDecl*>                            _shared_vars{};    // assigned from a nested function
+  std::set<Param>                                          _shared_params{};
+  std::map<std::string, std::size_t>                       _names{};
+  std::map<std::string, std::size_t>                       _strings{};
+  std::map<std::pair<std::string, std::size_t>, std::size_t> _dispatchers{};
+  std::size_t                                              _locals{};
+  std::size_t                                              _temps{};
+
+  auto declare(const IAST* node, std::vector<const FunctionDecl*>& frames) -> void;
+  auto declare_class(const ClassDecl* node, std::vector<const FunctionDecl*>& frames) -> void;
+
+  auto function(const FunctionDecl* fn, const ClassDecl* klass, int indent) -> std::string;
+  auto hoist(const StmtsPtr& body, int indent)                   -> std::string;
+  auto constructor(const ClassDecl* node)                        -> std::string;
+  auto dispatcher(const std::string& name, std::size_t argc, std::size_t id) -> std::string;
+
+  auto stmts(const StmtsPtr& body, int indent)                   -> std::string;
+  auto stmt(const IAST* node, int indent)                        -> std::string;
+  auto assignment(const Assignment* node, int indent)            -> std::string;
+  auto if_stmt(const IfStatement* node, int indent)              -> std::string;
+  auto return_stmt(const ReturnStatement* node, int indent)      -> std::string;
+
+  auto expr(const IAST* node)                                    -> Code;
+  auto literal(const Literal* node)                              -> Code;
+  auto variable(const Literal* node)                             -> Code;
+  auto binary(const BinaryOp* node)                              -> Code;
+  auto unary(const UnaryOp* node)                                -> Code;
+  auto call(const FunctionCall* node)                            -> Code;
+  auto method_call(const MethodCall* node)                       -> Code;
+  auto member(const MemberAccess* node)                          -> Code;
+  auto sequenced(std::vector<Code> parts, Repr repr, auto build) -> Code;
+
+  auto self_slot(const IAST* object, const std::string* field) const -> std::size_t;
+  auto param(const Literal* node) const                          -> std::optional<Param>;
+  auto callee(const FunctionCall* node) const                    -> const FunctionDecl*;
+  auto name_of(std::string_view field)                           -> std::string;
+  auto string_of(const std::string& s)                           -> std::string;
+
+  static auto boxed(Code code)                                   -> Code;
+  static auto box(const Code& code)                              -> std::string;
+  static auto convert(const Code& code, Repr repr)               -> std::string;
+  static auto truthy(const Code& code)                           -> std::string;
+  static auto repr_of(StaticType type)                           -> Repr;
+  static auto type_name(Repr repr)                               -> std::string_view;
+};
@@ -2,9 +2,15 @@
 #include <print>
 #include <fstream>
 #include <sstream>
+#include <unordered_set>
 
 auto SourceLocation::to_string() const -> std::string { return std::format("{}:{}", row, col); }
 
+auto intern(std::string_view name) -> const std::string* {
+  static std::unordered_set<std::string> table;
+  return &*table.emplace(name).first;
+}
+
 auto read_file(std::string_view filename) -> std::optional<std::string> {
   std::ifstream file{filename.data()};
   if (!file.is_open())
@@ -1,6 +1,7 @@
 #pragma once
 #include <string_view>
 #include <optional>
+#include <string>
 
 struct SourceLocation final {
   std::size_t row {};
@@ -14,6 +15,9 @@ struct SourceLocation final {
 
 auto read_file(std::string_view filename) -> std::optional<std::string>;
 
+// Unique, never-freed copy of 'name': equal names give the same pointer.
+auto intern(std::string_view name) -> const std::string*;
+
 template<std::size_t N, class T>
 constexpr std::size_t countof(T(&)[N]) { return N; }
 
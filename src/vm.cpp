@@ -0,0 +1,338 @@
+#include "vm.h"
+#include <format>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "builtins.h"
+#include "error_manager.h"
+#include "operators.h"
+#include "std.h"
+
+auto VM::run() -> void {
+  _stack.clear();
+  _frames.clear();
+  _globals.assign(_program.globals.size(), make_unbound());
+  _stack.reserve(256);
+
+  push_frame(_program.script, 0, 0, {});
+  execute();
+}
+
+auto VM::pop() -> Value {
+  auto v = std::move(_stack.back());
+  _stack.pop_back();
+  return v;
+}
+
+auto VM::push_frame(const Function& fn, std::size_t argc, std::size_t ret, Value self) -> void {
+  if (argc != fn.arity)
+    throw RuntimeError(std::format("'{}' espera {} argumento(s), obtuvo {}", fn.name, fn.arity, argc));
+
+  // The script's own frame is not a call.
+  if (_frames.size() > _max_depth)
+    throw stack_overflow(_max_depth);
+
+  // A function nested in a method sees the method's 'este'.
+  auto parent = _frames.empty() ? 0 : static_link(fn);
+  if (!self.is_instance() && !_frames.empty())
+    self = _frames[parent].self;
+
+  auto base = _stack.size() - argc;
+  _stack.resize(base + fn.num_locals);
+  _frames.emplace_back(&fn, fn.chunk.code.data(), base, ret, parent, std::move(self));
+}
+
+// The innermost live frame of the function 'fn' is declared in.
+auto VM::static_link(const Function& fn) const -> std::size_t {
+  if (fn.enclosing == Function::TOP_LEVEL)
+    return 0;
+  const auto* enclosing = &_program.functions[fn.enclosing];
+  for (auto i = _frames.size(); i-- > 0;)
+    if (_frames[i].fn == enclosing)
+      return i;
+  throw RuntimeError("funcion anidada llamada fuera de la funcion que la declara");
+}
+
+auto VM::outer_slot(const CallFrame& frame, uint16_t slot, uint8_t hops) -> Value& {
+  const auto* f = &frame;
+  while (hops-- > 0)
+    f = &_frames[f->parent];
+  return _stack[f->base + slot];
+}
+
+auto VM::invoke(uint16_t name, std::size_t argc) -> void {
+  auto  recv_at  = _stack.size() - argc - 1;
+  auto  receiver = _stack[recv_at];
+  const auto& method_name = *_program.names[name];
+
+  if (receiver.is_instance()) {
+    const auto& inst  = receiver.as_instance();
+    const auto& klass = _program.classes[inst->klass->id];
+    auto it = klass.methods.find(name);
+    if (it == klass.methods.end())
+      throw RuntimeError(std::format("'{}' no tiene metodo '{}'", inst->klass->name, method_name));
+    return push_frame(_program.functions[it->second], argc, recv_at, std::move(receiver));
+  }
+
+  std::span<const NativeMethodDesc> methods;
+  if (receiver.is_array())
+    methods = ARRAY_METHODS;
+  else if (receiver.is_string())
+    methods = STRING_METHODS;
+  else
+    throw RuntimeError("Metodo Invalido");
+
+  auto* method = find_builtin(methods, method_name);
+  if (!method)
+    throw RuntimeError("Invalido metodo");
+  if (!method->variadic && argc != method->arity)
+    throw RuntimeError("argumento(s) invalido(s)");
+
+  auto result = method->fn(receiver, std::span<const Value>(_stack.data() + recv_at + 1, argc));
+  _stack.resize(recv_at);
+  _stack.push_back(std::move(result));
+}
+
+auto VM::execute() -> void {
+  auto* frame = &_frames.back();
+  auto* ip    = frame->ip;
+
+  auto read_u8  = [&]() -> uint8_t  { return *ip++; };
+  auto read_u16 = [&]() -> uint16_t {
+    auto v = static_cast<uint16_t>(ip[0] | (ip[1] << 8));
+    ip += 2;
+    return v;
+  };
+  // Saves the caller position before a call and switches to the new top frame.
+  auto enter = [&](auto&& call) {
+    frame->ip = ip;
+    call();
+    frame = &_frames.back();
+    ip    = frame->ip;
+  };
+  auto binary = [&](TokenType op) {
+    auto rv = pop();
+    auto& lv = _stack.back();
+    lv = binary_op(op, lv, rv);
+  };
+  // 'x se x + a + b ...' with the addends on top of the stack. Unless
+  // the string is x's alone, the sums are built as ADD would.
+  auto append = [&](Value& target, uint8_t count) {
+    auto addends = std::span(_stack).last(count);
+    if (unique_string(target)) {
+      for (const auto& a : addends) append_to(target.as_string(), a);
+    } else {
+      auto sum = target;
+      for (const auto& a : addends) sum = binary_op(TokenType::PLUS, sum, a);
+      target = std::move(sum);
+    }
+    _stack.resize(_stack.size() - count);
+  };
+
+  while (true) {
+    switch (static_cast<OpCode>(read_u8())) {
+      using enum OpCode;
+      case CONSTANT:   _stack.push_back(frame->fn->chunk.constants[read_u16()]); break;
+      case PUSH_NIL:   _stack.push_back(make_null());  break;
+      case PUSH_TRUE:  _stack.push_back(make(true));   break;
+      case PUSH_FALSE: _stack.push_back(make(false));  break;
+      case POP:        _stack.pop_back();              break;
+
+      case GET_LOCAL: _stack.push_back(_stack[frame->base + read_u16()]); break;
+      case SET_LOCAL: {
+        auto slot = read_u16();
+        _stack[frame->base + slot] = pop();
+        break;
+      }
+      case GET_OUTER: {
+        auto slot = read_u16();
+        _stack.push_back(outer_slot(*frame, slot, read_u8()));
+        break;
+      }
+      case SET_OUTER: {
+        auto slot = read_u16();
+        outer_slot(*frame, slot, read_u8()) = pop();
+        break;
+      }
+      case GET_GLOBAL: {
+        auto id = read_u16();
+        if (_globals[id].is_unbound())
+          throw RuntimeError(std::format("variable '{}' no definida", _program.globals[id]));
+        _stack.push_back(_globals[id]);
+        break;
+      }
+      case SET_GLOBAL: {
+        auto id = read_u16();
+        if (_globals[id].is_unbound())
+          throw RuntimeError(std::format("asignacion a variable no declarada '{}'", _program.globals[id]));
+        _globals[id] = pop();
+        break;
+      }
+      case DEFINE_GLOBAL: _globals[read_u16()] = pop(); break;
+      case APPEND_LOCAL: {
+        auto slot = read_u16();
+        append(_stack[frame->base + slot], read_u8());
+        break;
+      }
+      case APPEND_GLOBAL: {
+        auto id = read_u16();
+        if (_globals[id].is_unbound())
+          throw RuntimeError(std::format("variable '{}' no definida", _program.globals[id]));
+        append(_globals[id], read_u8());
+        break;
+      }
+
+      case GET_SELF:
+        if (!frame->self.is_instance())
+          throw RuntimeError("'este' usado fuera de una clase o metodo");
+        _stack.push_back(frame->self);
+        break;
+      case GET_FIELD: {
+        const auto* field = _program.names[read_u16()];
+        auto obj = pop();
+        if (!obj.is_instance())
+          throw RuntimeError(std::format("'{}' no es una instancia", obj.to_string()));
+        auto* value = obj.as_instance()->field(field);
+        if (!value)
+          throw RuntimeError(std::format("la instancia no tiene campo '{}'", *field));
+        _stack.push_back(*value);
+        break;
+      }
+      case SET_FIELD: {
+        const auto* field = _program.names[read_u16()];
+        auto obj = pop();
+        auto val = pop();
+        if (!obj.is_instance())
+          throw RuntimeError(std::format("'{}' no es una instancia", obj.to_string()));
+        obj.as_instance()->set_field(field, std::move(val));
+        break;
+      }
+      case GET_INDEX: {
+        auto idx = pop();
+        auto& obj = _stack.back();
+        obj = index_value(obj, idx);
+        break;
+      }
+      case SET_INDEX: {
+        auto idx = pop();
+        auto obj = pop();
+        assign_index(obj, idx, pop());
+        break;
+      }
+
+      case ADD:           binary(TokenType::PLUS);             break;
+      case SUB:           binary(TokenType::MINUS);            break;
+      case MUL:           binary(TokenType::STAR);             break;
+      case DIV:           binary(TokenType::SLASH);            break;
+      case EQUAL:         binary(TokenType::EQUAL);            break;
+      case NOT_EQUAL:     binary(TokenType::NOT_EQUAL);        break;
+      case LESS:          binary(TokenType::LESSER_THAN);      break;
+      case GREATER:       binary(TokenType::GREATER_THAN);     break;
+      case LESS_EQUAL:    binary(TokenType::LESSER_OR_EQUAL);  break;
+      case GREATER_EQUAL: binary(TokenType::GREATER_OR_EQUAL); break;
+      case NEGATE:  _stack.back() = unary_op(TokenType::MINUS, _stack.back()); break;
+      case NOT:     _stack.back() = make(!_stack.back().truthy());           break;
+      case TO_BOOL: _stack.back() = make(_stack.back().truthy());            break;
+
+      case JUMP: {
+        auto offset = read_u16();
+        ip += offset;
+        break;
+      }
+      case JUMP_IF_FALSE: {
+        auto offset = read_u16();
+        if (!pop().truthy()) ip += offset;
+        break;
+      }
+      case JUMP_IF_TRUE: {
+        auto offset = read_u16();
+        if (pop().truthy()) ip += offset;
+        break;
+      }
+      case LOOP: {
+        auto offset = read_u16();
+        ip -= offset;
+        break;
+      }
+
+      case CALL: {
+        const auto& fn = _program.functions[read_u16()];
+        auto argc = read_u8();
+        enter([&] { push_frame(fn, argc, _stack.size() - argc, {}); });
+        break;
+      }
+      case TAIL_CALL: {
+        const auto& fn = _program.functions[read_u16()];
+        std::size_t argc = read_u8();
+        // The arguments slide down over the caller's slots and the callee
+        // returns straight to where the caller would have.
+        auto first = _stack.end() - static_cast<std::ptrdiff_t>(argc);
+        auto base  = frame->base;
+        auto ret   = frame->ret;
+        std::move(first, _stack.end(), _stack.begin() + static_cast<std::ptrdiff_t>(base));
+        _stack.resize(base + argc);
+        _frames.pop_back();
+        push_frame(fn, argc, ret, {});
+        frame = &_frames.back();
+        ip    = frame->ip;
+        break;
+      }
+      case CALL_BUILTIN: {
+        const auto& desc = FREE_FUNCTIONS[read_u16()];
+        std::size_t argc = read_u8();
+        if (!desc.variadic && argc != desc.arity)
+          throw RuntimeError(std::format(
+            "'{}' espera {} argumento(s) pero recibio {}",
+            desc.name, desc.arity, argc));
+        auto first  = _stack.size() - argc;
+        auto result = desc.fn({}, std::span<const Value>(_stack.data() + first, argc));
+        _stack.resize(first);
+        _stack.push_back(std::move(result));
+        break;
+      }
+      case NEW: {
+        const auto& klass = _program.classes[read_u16()];
+        std::size_t argc = read_u8();
+        if (!klass.has_ctor && argc != 0)
+          throw RuntimeError(std::format("clase '{}' no tiene constructor: ", klass.def->name));
+        auto inst   = InstancePtr::make(klass.def);
+        enter([&] {
+          push_frame(_program.functions[klass.init], argc, _stack.size() - argc,
+                     Value{std::move(inst)});
+        });
+        break;
+      }
+      case INVOKE: {
+        auto name = read_u16();
+        auto argc = read_u8();
+        enter([&] { invoke(name, argc); });
+        break;
+      }
+      case ARRAY: {
+        std::size_t count = read_u16();
+        auto first = _stack.end() - static_cast<std::ptrdiff_t>(count);
+        std::vector<Value> items(std::make_move_iterator(first), std::make_move_iterator(_stack.end()));
+        _stack.erase(first, _stack.end());
+        _stack.push_back(make(std::move(items)));
+        break;
+      }
+
+      case RETURN: {
+        auto result = pop();
+        if (_frames.size() == 1)
+          throw ReturnSignal{std::move(result)};
+        _stack.resize(frame->ret);
+        _frames.pop_back();
+        _stack.push_back(std::move(result));
+        frame = &_frames.back();
+        ip    = frame->ip;
+        break;
+      }
+      case HALT:
+        return;
+      default:
+        throw RuntimeError("instruccion desconocida");
+    }
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bytecode.h"
+#include "error_manager.h"
+#include "runtime_values.h"
+
+class VM final {
+public:
+  explicit VM(const Program& program, std::size_t max_depth = DEFAULT_MAX_DEPTH)
+  : _program(program), _max_depth(max_depth) {}
+
+  auto run() -> void;
+
+private:
+  struct CallFrame final {
+    const Function* fn{};
+    const uint8_t*  ip{};
+    std::size_t     base{};    // slot 0 of the frame
+    std::size_t     ret{};     // stack height restored on return
+    std::size_t     parent{};  // frame of the enclosing function (static link)
+    Value           self{};
+  };
+
+  const Program&         _program;
+  std::size_t            _max_depth;
+  std::vector<Value>     _stack{};
+  std::vector<CallFrame> _frames{};
+  std::vector<Value>     _globals{};
+
+  auto execute()                                                           -> void;
+  auto push_frame(const Function& fn, std::size_t argc, std::size_t ret, Value self) -> void;
+  auto static_link(const Function& fn) const                               -> std::size_t;
+  auto outer_slot(const CallFrame& frame, uint16_t slot, uint8_t hops)     -> Value&;
+  auto invoke(uint16_t name, std::size_t argc)                             -> void;
+  auto pop()                                                               -> Value;
+};
@@ -1,37 +1,58 @@
 #include <cstdint>
 #include <gtest/gtest.h>
+#include <optional>
 #include <limits>
 #include "nodes.h"
 #include "parser.h"
 #include "sema.h"
 #include "interpreter.h"
+#include "optimizer.h"
+#include "pool.h"
+#include "gc.h"
+#include "test_support.h"
+#include "programs.h"
 
 struct RunResult {
   std::shared_ptr<StmtsPtr> ast;
   Interpreter interp;
 };
 
-static auto run_ok(std::string_view src) -> Interpreter {
-  Parser p{src};
-  auto ast = p.parse();
-  Sema sema;
-  sema.analyze(ast);
-  Interpreter interp;
-  interp.run(ast);
-  return interp;
-}
 
+// Every program runs on the tree walker and again, from a fresh parse (the
+// JIT and the quickened sites annotate the tree), in closure mode and with
+// the memo table.
+static constexpr InterpreterOptions MODES[] {
+  {},
+  {.jit = false, .closures = true},
+  {.memo = true},
+};
 
-static auto run_error(std::string_view src, std::string_view substr) -> void {
-  Parser p{src};
-  auto ast = p.parse();
-  Interpreter interp;
-  try {
+static auto run_ok(std::string_view src) -> void {
+  for (auto options : MODES) {
+    Parser p{src};
+    auto ast = p.parse();
+    Sema sema;
+    sema.analyze(ast);
+    Interpreter interp{options};
     interp.run(ast);
-    FAIL() << "Expected RuntimeError containing '" << substr << "'";
-  } catch (const RuntimeError& e) {
-    EXPECT_NE(std::string(e.what()).find(substr), std::string::npos)
-        << "Got: " << e.what();
+  }
+}
+
+
+static auto run_error(std::string_view src, std::string_view substr,
+                      AllowedErrors allowed = HARNESS_ERRORS) -> void {
+  for (auto options : MODES) {
+    Parser p{src};
+    auto ast = p.parse();
+    analyze(ast, allowed);
+    Interpreter interp{options};
+    try {
+      interp.run(ast);
+      FAIL() << "Expected RuntimeError containing '" << substr << "'";
+    } catch (const RuntimeError& e) {
+      EXPECT_NE(std::string(e.what()).find(substr), std::string::npos)
+          << "Got: " << e.what();
+    }
   }
 }
 
@@ -39,7 +60,8 @@ static auto run_error(std::string_view src, std::string_view substr) -> void {
 //
 // Each test program must define:   func resultado() ret <value> fin
 // This helper runs the program + calls resultado() and returns the Value.
-static auto get_result(std::string_view src) -> ValuePtr {
+static auto get_result(std::string_view src,
+                       AllowedErrors allowed = HARNESS_ERRORS) -> std::optional<Value> {
   std::string full = std::string(src) + "\nvar __answer__ se resultado()";
   // We can't read __answer__ from outside.
   // Solution: subclass Interpreter and expose eval — but we can't change prod.
@@ -51,15 +73,27 @@ static auto get_result(std::string_view src) -> ValuePtr {
   //
   // Since ReturnSignal is public, we can catch it from outside:
   std::string trigger = std::string(src) + "\ndevolver resultado()";
-  Parser p{trigger};
-  auto ast = p.parse();
-  Interpreter interp;
-  try {
-    interp.run(ast);
-  } catch (ReturnSignal& rs) {
-    return rs.value;
+  std::optional<Value> results[std::size(MODES)];
+  for (auto i {0uz}; i < std::size(MODES); ++i) {
+    Parser p{trigger};
+    auto ast = p.parse();
+    analyze(ast, allowed);
+    Interpreter interp{MODES[i]};
+    try {
+      interp.run(ast);
+    } catch (ReturnSignal& rs) {
+      results[i] = rs.value;
+    }
   }
-  return nullptr;
+  // Every mode in MODES has to agree with the first.
+  for (const auto& r : results) {
+    EXPECT_EQ(r.has_value(), results[0].has_value());
+    if (r && results[0]) {
+      EXPECT_EQ(r->type(), results[0]->type());
+      EXPECT_EQ(r->to_string(), results[0]->to_string());
+    }
+  }
+  return results[0];
 }
 
 
@@ -92,92 +126,168 @@ TEST(Value, ToStringFalse)  { EXPECT_EQ(Value{false}.to_string(), "falso"); }
 TEST(Value, ToStringInt)    { EXPECT_EQ(Value{int64_t{42}}.to_string(), "42"); }
 TEST(Value, ToStringString) { EXPECT_EQ(Value{std::string{"hola"}}.to_string(), "hola"); }
 TEST(Value, ToStringArray)  {
-  std::vector<ValuePtr> v;
-  v.push_back(std::make_shared<Value>(int64_t{1}));
-  v.push_back(std::make_shared<Value>(int64_t{2}));
+  std::vector<Value> v;
+  v.emplace_back(int64_t{1});
+  v.emplace_back(int64_t{2});
   EXPECT_EQ(Value{std::move(v)}.to_string(), "[1, 2]");
 }
 
+TEST(Value, CopiesShareTheHeapObject) {
+  Value a{std::string{"hola"}};
+  {
+    Value b = a;
+    EXPECT_EQ(&a.as_string(), &b.as_string());
+    EXPECT_EQ(std::get<StringPtr>(a.inner).use_count(), 2u);
+  }
+  EXPECT_EQ(std::get<StringPtr>(a.inner).use_count(), 1u);
+  Value c = std::move(a);
+  EXPECT_EQ(std::get<StringPtr>(c.inner).use_count(), 1u);
+}
+
+TEST(Pool, FreedBlocksAreReusedByTheirClass) {
+  auto& pool = Pool::instance();
+  auto* a = pool.allocate(40);
+  pool.release(a, 40);
+  auto* b = pool.allocate(33);  // same 48-byte class
+  EXPECT_EQ(a, b);
+  pool.release(b, 33);
+}
+
+TEST(Pool, StatsCountLiveBlocks) {
+  auto live = [] {
+    for (const auto& c : Pool::instance().stats())
+      if (c.block == 64) return c.live;  // an array and its GcNode header
+    return 0uz;
+  };
+  auto before = live();
+  {
+    Value arr{std::vector<Value>{Value{int64_t{1}}}};
+    Value copy = arr;
+    EXPECT_EQ(live(), before + 1);
+  }
+  EXPECT_EQ(live(), before);
+}
+
+TEST(Gc, ReclaimsCycles) {
+  auto& gc = Collector::instance();
+  gc.collect();
+  auto before = gc.live();
+  auto freed  = gc.stats().reclaimed_objects;
+  {
+    Value a{std::vector<Value>{}};
+    Value b{std::vector<Value>{a}};
+    a.as_array().push_back(b);
+    a.as_array().push_back(a);
+  }
+  EXPECT_EQ(gc.live(), before + 2);
+  gc.collect();
+  EXPECT_EQ(gc.live(), before);
+  EXPECT_EQ(gc.stats().reclaimed_objects, freed + 2);
+}
+
+TEST(Gc, KeepsCyclesReachableFromOutside) {
+  auto& gc = Collector::instance();
+  Value a{std::vector<Value>{Value{int64_t{7}}}};
+  {
+    Value b{std::vector<Value>{a}};
+    a.as_array().push_back(b);
+  }
+  gc.collect();
+  ASSERT_EQ(a.as_array().size(), 2uz);
+  EXPECT_EQ(a.as_array()[0].as_int(), 7);
+  EXPECT_EQ(a.as_array()[1].as_array()[0].as_array()[0].as_int(), 7);
+}
+
+// Enough garbage cycles for collections to start mid-run; the list the
+// program keeps must come through them whole.
+TEST(Gc, CollectsWhileTheProgramRuns) {
+  auto& gc = Collector::instance();
+  auto collections = gc.stats().collections;
+  auto v = get_result(programs::GC_COLLECTS_WHILE_THE_PROGRAM_RUNS);
+  EXPECT_INT(v, 1990000);
+  EXPECT_GT(gc.stats().collections, collections);
+}
+
 TEST(Interp, LiteralInt) {
-  auto v = get_result("func resultado() devolver 42 fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::LITERAL_INT);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, 42);
 }
 
 TEST(Interp, LiteralFloat) {
-  auto v = get_result("func resultado() devolver 3.14 fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::LITERAL_FLOAT);
+  ASSERT_TRUE(v.has_value());
   EXPECT_TRUE(v->is_float());
 }
 
 TEST(Interp, LiteralBoolTrue) {
-  auto v = get_result("func resultado() devolver verdadero fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::LITERAL_BOOL_TRUE);
+  ASSERT_TRUE(v.has_value());
   EXPECT_BOOL(v, true);
 }
 
 TEST(Interp, LiteralBoolFalse) {
-  auto v = get_result("func resultado() devolver falso fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::LITERAL_BOOL_FALSE);
+  ASSERT_TRUE(v.has_value());
   EXPECT_BOOL(v, false);
 }
 
 TEST(Interp, LiteralString) {
-  auto v = get_result(R"(func resultado() devolver "hola" fin)");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::LITERAL_STRING);
+  ASSERT_TRUE(v.has_value());
   EXPECT_STR(v, "hola");
 }
 
 
 TEST(Interp, VarDeclAndRead) {
-  auto v = get_result("var x se 7\nfunc resultado() devolver x fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::VAR_DECL_AND_READ);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, 7);
 }
 
 TEST(Interp, ConstDeclAndRead) {
-  auto v = get_result("const MAX se 100\nfunc resultado() devolver MAX fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::CONST_DECL_AND_READ);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, 100);
 }
 
 TEST(Interp, VarDeclRhsExpression) {
-  auto v = get_result("var x se 3 + 4\nfunc resultado() devolver x fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::VAR_DECL_RHS_EXPRESSION);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, 7);
 }
 
 TEST(Interp, Assignment) {
-  auto v = get_result("var x se 1\nx se 99\nfunc resultado() devolver x fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::ASSIGNMENT);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, 99);
 }
 
 TEST(Interp, AssignmentOverwrite) {
-  auto v = get_result("var x se 1\nx se 2\nx se 3\nfunc resultado() devolver x fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::ASSIGNMENT_OVERWRITE);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, 3);
 }
 
 TEST(Interp, AssignmentUndeclaredThrows) {
-  run_error("x se 1", "no declarada");
+  run_error("x se 1", "no declarada", {SemanticErrorCode::ASSIGNMENT_TO_UNDECLARED});
 }
 
-TEST(Interp, Add)  { auto v = get_result("func resultado() devolver 2 + 3 fin");    EXPECT_INT(v, 5); }
-TEST(Interp, Sub)  { auto v = get_result("func resultado() devolver 10 - 4 fin");   EXPECT_INT(v, 6); }
-TEST(Interp, Mul)  { auto v = get_result("func resultado() devolver 3 * 4 fin");    EXPECT_INT(v, 12); }
-TEST(Interp, Div)  { auto v = get_result("func resultado() devolver 10 / 2 fin");   EXPECT_INT(v, 5); }
+TEST(Interp, Add)  { auto v = get_result(programs::ADD);    EXPECT_INT(v, 5); }
+TEST(Interp, Sub)  { auto v = get_result(programs::SUB);   EXPECT_INT(v, 6); }
+TEST(Interp, Mul)  { auto v = get_result(programs::MUL);    EXPECT_INT(v, 12); }
+TEST(Interp, Div)  { auto v = get_result(programs::DIV);   EXPECT_INT(v, 5); }
 
 TEST(Interp, FloatAdd) {
-  auto v = get_result("func resultado() devolver 1.5 + 1.5 fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::FLOAT_ADD);
+  ASSERT_TRUE(v.has_value());
   EXPECT_TRUE(v->is_float());
   EXPECT_DOUBLE_EQ(v->as_float(), 3);
 }
 
 TEST(Interp, IntFloatMixed) {
-  auto v = get_result("func resultado() devolver 1 + 0.5 fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::INT_FLOAT_MIXED);
+  ASSERT_TRUE(v.has_value());
   EXPECT_TRUE(v->is_float());
   EXPECT_DOUBLE_EQ(v->as_float(), 1.5);
 }
@@ -186,54 +296,136 @@ TEST(Interp, DivisionByZero) {
   run_error("func f() devolver 1 / 0 fin\nf()", "cero");
 }
 
+TEST(Interp, LargeIntsStayExact) {
+  // 2^53 + 1 is not representable as a double.
+  auto v = get_result(programs::LARGE_INT_COMPARISON);
+  EXPECT_BOOL(v, true);
+  auto w = get_result(programs::LARGE_INT_SUM);
+  EXPECT_INT(w, 9007199254740995);
+}
+
+TEST(Interp, IntOverflow) {
+  run_error("var x se 9223372036854775807 + 1", "desbordamiento");
+  run_error("var x se 4611686018427387904 * 2", "desbordamiento");
+}
+
+TEST(Interp, SpecializedArithmeticKeepsErrors) {
+  run_error("func f() var a se 7 var b se 0 devolver a / b fin\nf()", "cero");
+  run_error("func f() var a se 1.5 var b se 0.0 devolver a / b fin\nf()", "cero");
+}
+
+TEST(Interp, TypedLoopMatchesGenericResult) {
+  auto v = get_result(programs::TYPED_LOOP_MATCHES_GENERIC_RESULT);
+  ASSERT_TRUE(v.has_value());
+  EXPECT_FLOAT(v, 13.0);
+}
+
+TEST(Interp, PolymorphicSiteRespecializes) {
+  auto v = get_result(programs::POLYMORPHIC_SITE_RESPECIALIZES);
+  ASSERT_TRUE(v.has_value());
+  EXPECT_INT(v, 3224);
+}
+
+// The '+' inside suma() after running 'calls'.
+static auto suma_site(std::string_view calls) -> QuickSite {
+  Parser p{"func suma(a, b) devolver a + b fin\n" + std::string(calls)};
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+  Interpreter{}.run(ast);
+  const auto* fn  = static_cast<const FunctionDecl*>(ast[0].get());
+  const auto* ret = static_cast<const ReturnStatement*>(fn->body[0].get());
+  return static_cast<const BinaryOp*>(ret->expr.get())->quick;
+}
+
+TEST(Interp, QuickenedSiteFollowsOperandTypes) {
+  auto site = suma_site("suma(1, 2)");
+  EXPECT_EQ(site.left, ValueType::INT);
+  EXPECT_EQ(site.right, ValueType::INT);
+  EXPECT_NE(site.run, nullptr);
+
+  site = suma_site("suma(1, 2) suma(0.5, 1.5)");
+  EXPECT_EQ(site.left, ValueType::FLOAT);
+  EXPECT_NE(site.run, nullptr);
+
+  // A site whose types keep changing ends up on the generic path.
+  site = suma_site("suma(1, 2) suma('a', 1) suma(1, 2) suma('a', 1) suma(1, 2)");
+  EXPECT_EQ(site.run, nullptr);
+  EXPECT_EQ(site.misses, QuickSite::MAX_MISSES);
+}
+
+TEST(Interp, QuickenedIndexKeepsBoundsCheck) {
+  run_error(
+    "func en(a, i) devolver a[i] fin\n"
+    "en([1, 2], 0)\n"
+    "en([1, 2], 5)\n",
+    "indice fuera de rango");
+}
+
 TEST(Interp, NegationUnary) {
-  auto v = get_result("func resultado() devolver -5 fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::NEGATION_UNARY);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, -5);
 }
 
 TEST(Interp, Precedence) {
-  auto v = get_result("func resultado() devolver 2 + 3 * 4 fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::PRECEDENCE);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, 14);
 }
 
 TEST(Interp, Parentheses) {
-  auto v = get_result("func resultado() devolver (2 + 3) * 4 fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::PARENTHESES);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INT(v, 20);
 }
 
 TEST(Interp, StringConcat) {
-  auto v = get_result(R"(func resultado() devolver "hola" + " mundo" fin)");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::STRING_CONCAT);
+  ASSERT_TRUE(v.has_value());
   EXPECT_STR(v, "hola mundo");
 }
 
 TEST(Interp, StringIntConcat) {
-  auto v = get_result(R"(func resultado() devolver "n=" + 42 fin)");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::STRING_INT_CONCAT);
+  ASSERT_TRUE(v.has_value());
   EXPECT_STR(v, "n=42");
 }
 
-TEST(Interp, CmpLT_True)  { auto v = get_result("func resultado() devolver 1 < 2 fin");  EXPECT_BOOL(v, true); }
-TEST(Interp, CmpLT_False) { auto v = get_result("func resultado() devolver 2 < 1 fin");  EXPECT_BOOL(v, false); }
-TEST(Interp, CmpGT)       { auto v = get_result("func resultado() devolver 3 > 2 fin");  EXPECT_BOOL(v, true); }
-TEST(Interp, CmpLE)       { auto v = get_result("func resultado() devolver 2 <= 2 fin"); EXPECT_BOOL(v, true); }
-TEST(Interp, CmpGE)       { auto v = get_result("func resultado() devolver 3 >= 4 fin"); EXPECT_BOOL(v, false); }
-TEST(Interp, CmpEQ_Int)   { auto v = get_result("func resultado() devolver 5 = 5 fin");  EXPECT_BOOL(v, true); }
-TEST(Interp, CmpNEQ)      { auto v = get_result("func resultado() devolver 5 != 6 fin"); EXPECT_BOOL(v, true); }
+TEST(Interp, AppendingKeepsOtherCopies) {
+  auto v = get_result(programs::APPENDING_KEEPS_OTHER_COPIES);
+  EXPECT_STR(v, "a|ab1c|ab1c!");
+}
+
+TEST(Interp, AppendingAStringToItself) {
+  auto v = get_result(programs::APPENDING_A_STRING_TO_ITSELF);
+  EXPECT_STR(v, "ab-ab");
+}
+
+TEST(Interp, AppendingInALoop) {
+  auto v = get_result(programs::APPENDING_IN_A_LOOP);
+  ASSERT_TRUE(v->is_string());
+  EXPECT_EQ(v->as_string().size(), 200000uz);
+  EXPECT_EQ(v->as_string().substr(0, 20), "xverdaderoxverdadero");
+}
+
+TEST(Interp, CmpLT_True)  { auto v = get_result(programs::CMP_LT_TRUE);  EXPECT_BOOL(v, true); }
+TEST(Interp, CmpLT_False) { auto v = get_result(programs::CMP_LT_FALSE);  EXPECT_BOOL(v, false); }
+TEST(Interp, CmpGT)       { auto v = get_result(programs::CMP_GT);  EXPECT_BOOL(v, true); }
+TEST(Interp, CmpLE)       { auto v = get_result(programs::CMP_LE); EXPECT_BOOL(v, true); }
+TEST(Interp, CmpGE)       { auto v = get_result(programs::CMP_GE); EXPECT_BOOL(v, false); }
+TEST(Interp, CmpEQ_Int)   { auto v = get_result(programs::CMP_EQ_INT);  EXPECT_BOOL(v, true); }
+TEST(Interp, CmpNEQ)      { auto v = get_result(programs::CMP_NEQ); EXPECT_BOOL(v, true); }
 TEST(Interp, CmpEQ_Str)   {
-  auto v = get_result(R"(func resultado() devolver "a" = "a" fin)");
+  auto v = get_result(programs::CMP_EQ_STR);
   EXPECT_BOOL(v, true);
 }
 
-TEST(Interp, LogicalAnd_TT) { auto v = get_result("func resultado() devolver verdadero y verdadero fin"); EXPECT_BOOL(v, true); }
-TEST(Interp, LogicalAnd_TF) { auto v = get_result("func resultado() devolver verdadero y falso fin");     EXPECT_BOOL(v, false); }
-TEST(Interp, LogicalOr_FF)  { auto v = get_result("func resultado() devolver falso o falso fin");         EXPECT_BOOL(v, false); }
-TEST(Interp, LogicalOr_TF)  { auto v = get_result("func resultado() devolver verdadero o falso fin");     EXPECT_BOOL(v, true); }
-TEST(Interp, LogicalBang)   { auto v = get_result("func resultado() devolver !verdadero fin");            EXPECT_BOOL(v, false); }
-TEST(Interp, LogicalBangFalse){ auto v = get_result("func resultado() devolver !falso fin");              EXPECT_BOOL(v, true); }
+TEST(Interp, LogicalAnd_TT) { auto v = get_result(programs::LOGICAL_AND_TT); EXPECT_BOOL(v, true); }
+TEST(Interp, LogicalAnd_TF) { auto v = get_result(programs::LOGICAL_AND_TF);     EXPECT_BOOL(v, false); }
+TEST(Interp, LogicalOr_FF)  { auto v = get_result(programs::LOGICAL_OR_FF);         EXPECT_BOOL(v, false); }
+TEST(Interp, LogicalOr_TF)  { auto v = get_result(programs::LOGICAL_OR_TF);     EXPECT_BOOL(v, true); }
+TEST(Interp, LogicalBang)   { auto v = get_result(programs::LOGICAL_BANG);            EXPECT_BOOL(v, false); }
+TEST(Interp, LogicalBangFalse){ auto v = get_result(programs::LOGICAL_BANG_FALSE);              EXPECT_BOOL(v, true); }
 
 TEST(Interp, ShortCircuitAnd) {
   run_ok("func resultado() devolver falso y verdadero fin");
@@ -241,73 +433,37 @@ TEST(Interp, ShortCircuitAnd) {
 
 
 TEST(Interp, IfTaken) {
-  auto v = get_result(
-    "var x se 0\n"
-    "si verdadero haz x se 1 fin\n"
-    "func resultado() devolver  x fin"
-  );
+  auto v = get_result(programs::IF_TAKEN);
   EXPECT_INT(v, 1);
 }
 
 TEST(Interp, IfNotTaken) {
-  auto v = get_result(
-    "var x se 0\n"
-    "si falso haz x se 1 fin\n"
-    "func resultado() devolver x fin"
-  );
+  auto v = get_result(programs::IF_NOT_TAKEN);
   EXPECT_INT(v, 0);
 }
 
 TEST(Interp, IfElseTaken) {
-  auto v = get_result(
-    "var x se 0\n"
-    "si falso haz x se 1 sino x se 2 fin\n"
-    "func resultado() devolver x fin"
-  );
+  auto v = get_result(programs::IF_ELSE_TAKEN);
   EXPECT_INT(v, 2);
 }
 
 TEST(Interp, IfElseIfChain) {
-  auto v = get_result(
-    "var n se 2\n"
-    "var r se 0\n"
-    "si n = 1 haz r se 10\n"
-    "sino si n = 2 haz r se 20\n"
-    "sino r se 30\n"
-    "fin\n"
-    "func resultado() devolver r fin"
-  );
+  auto v = get_result(programs::IF_ELSE_IF_CHAIN);
   EXPECT_INT(v, 20);
 }
 
 TEST(Interp, WhileBasic) {
-  auto v = get_result(
-    "var i se 0\n"
-    "mientras i < 5 haz i se i + 1 fin\n"
-    "func resultado() devolver i fin"
-  );
+  auto v = get_result(programs::WHILE_BASIC);
   EXPECT_INT(v, 5);
 }
 
 TEST(Interp, WhileNotEntered) {
-  auto v = get_result(
-    "var i se 10\n"
-    "mientras i < 5 haz i se i + 1 fin\n"
-    "func resultado() devolver i fin"
-  );
+  auto v = get_result(programs::WHILE_NOT_ENTERED);
   EXPECT_INT(v, 10);
 }
 
 TEST(Interp, WhileAccumulator) {
-  auto v = get_result(
-    "var sum se 0\n"
-    "var i se 1\n"
-    "mientras i <= 10 haz\n"
-    "  sum se sum + i\n"
-    "  i se i + 1\n"
-    "fin\n"
-    "func resultado() devolver sum fin"
-  );
+  auto v = get_result(programs::WHILE_ACCUMULATOR);
   EXPECT_INT(v, 55);
 }
 
@@ -317,31 +473,23 @@ TEST(Interp, WhileScopedVarDoesNotLeak) {
     " var x se 1\n"
     "fin\n"
     "var a se x",
-    "no definida"
+    "no definida",
+    {SemanticErrorCode::UNDECLARED_ID}
   );
 }
 
 TEST(Interp, FuncNoParams) {
-  auto v = get_result("func resultado() devolver 42 fin");
+  auto v = get_result(programs::FUNC_NO_PARAMS);
   EXPECT_INT(v, 42);
 }
 
 TEST(Interp, FuncWithParams) {
-  auto v = get_result(
-    "func suma(a, b) devolver a + b fin\n"
-    "func resultado() devolver suma(3, 4) fin"
-  );
+  auto v = get_result(programs::FUNC_WITH_PARAMS);
   EXPECT_INT(v, 7);
 }
 
 TEST(Interp, FuncRecursion) {
-  auto v = get_result(
-    "func fib(n)\n"
-    "  si n < 2 haz devolver n fin\n"
-    "  devolver fib(n - 1) + fib(n - 2)\n"
-    "fin\n"
-    "func resultado() devolver fib(10) fin"
-  );
+  auto v = get_result(programs::FUNC_RECURSION);
   EXPECT_INT(v, 55);
 }
 
@@ -350,7 +498,8 @@ TEST(Interp, FuncLocalVarDoesNotLeak) {
     "func f() var local se 1 fin\n"
     "f()\n"
     "var x se local",
-    "no definida"
+    "no definida",
+    {SemanticErrorCode::UNDECLARED_ID}
   );
 }
 
@@ -358,50 +507,41 @@ TEST(Interp, FuncArityMismatch) {
   run_error(
     "func f(a, b) devolver a + b fin\n"
     "f(1)",
-    "argumento"
+    "argumento",
+    {SemanticErrorCode::FUNC_ARITY_MISMATCH}
   );
 }
 
 TEST(Interp, FuncReturnsNull) {
-  auto v = get_result(
-    "func nada() fin\n"
-    "func resultado() devolver nada() fin"
-  );
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::FUNC_RETURNS_NULL);
+  ASSERT_TRUE(v.has_value());
   EXPECT_NULL(v);
 }
 
 TEST(Interp, FuncNestedCalls) {
-  auto v = get_result(
-    "func doble(x) devolver x + x fin\n"
-    "func cuadruple(x) devolver doble(doble(x)) fin\n"
-    "func resultado() devolver cuadruple(3) fin"
-  );
+  auto v = get_result(programs::FUNC_NESTED_CALLS);
   EXPECT_INT(v, 12);
 }
 
 TEST(Interp, ArrayEmpty) {
-  auto v = get_result("func resultado() devolver [] fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::ARRAY_EMPTY);
+  ASSERT_TRUE(v.has_value());
   EXPECT_TRUE(v->is_array());
   EXPECT_TRUE(v->as_array().empty());
 }
 
 TEST(Interp, ArrayLiteral) {
-  auto v = get_result("func resultado() devolver [1, 2, 3] fin");
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::ARRAY_LITERAL);
+  ASSERT_TRUE(v.has_value());
   ASSERT_TRUE(v->is_array());
   EXPECT_EQ(v->as_array().size(), 3u);
-  EXPECT_EQ(v->as_array()[0]->as_int(), 1);
-  EXPECT_EQ(v->as_array()[1]->as_int(), 2);
-  EXPECT_EQ(v->as_array()[2]->as_int(), 3);
+  EXPECT_EQ(v->as_array()[0].as_int(), 1);
+  EXPECT_EQ(v->as_array()[1].as_int(), 2);
+  EXPECT_EQ(v->as_array()[2].as_int(), 3);
 }
 
 TEST(Interp, ArrayIndex) {
-  auto v = get_result(
-    "var a se [10, 20, 30]\n"
-    "func resultado() devolver a[1] fin"
-  );
+  auto v = get_result(programs::ARRAY_INDEX);
   EXPECT_INT(v, 20);
 }
 
@@ -418,92 +558,67 @@ TEST(Interp, ArrayIndexOnNonArray) {
 }
 
 TEST(Interp, ArrayWithExpressions) {
-  auto v = get_result(
-    "var n se 3\n"
-    "func resultado() devolver [n, n + 1, n + 2] fin"
-  );
+  auto v = get_result(programs::ARRAY_WITH_EXPRESSIONS);
   ASSERT_TRUE(v->is_array());
-  EXPECT_EQ(v->as_array()[0]->as_int(), 3);
-  EXPECT_EQ(v->as_array()[1]->as_int(), 4);
-  EXPECT_EQ(v->as_array()[2]->as_int(), 5);
+  EXPECT_EQ(v->as_array()[0].as_int(), 3);
+  EXPECT_EQ(v->as_array()[1].as_int(), 4);
+  EXPECT_EQ(v->as_array()[2].as_int(), 5);
 }
 
 TEST(Interp, ClassInstantiationNoctor) {
-  auto v = get_result(
-    "clase Punto\n"
-    "  var px se 0\n"
-    "  var py se 0\n"
-    "fin\n"
-    "func resultado() devolver Punto() fin"
-  );
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::CLASS_INSTANTIATION_NOCTOR);
+  ASSERT_TRUE(v.has_value());
   EXPECT_INSTANCE(v);
 }
 
 TEST(Interp, ClassInstanceFields) {
-  auto v = get_result(
-    "clase Punto\n"
-    "  var px se 0\n"
-    "  var py se 0\n"
-    "  func crear(nx, ny)\n"
-    "    este.px se nx\n"
-    "    este.py se ny\n"
-    "  fin\n"
-    "fin\n"
-    "var p se Punto(3,1)\n"
-    "func resultado() devolver p.px fin"
-  );
+  auto v = get_result(programs::CLASS_INSTANCE_FIELDS);
   EXPECT_INT(v, 3);
 }
 
 TEST(Interp, ClassFieldWrite) {
-  auto v = get_result(
-    "clase Caja\n"
-    "  var ancho se 0\n"
-    "  func crear(w) este.ancho se w fin\n"
-    "fin\n"
-    "var c se Caja(10)\n"
-    "c.ancho se 99\n"
-    "func resultado() devolver c.ancho fin"
-  );
+  auto v = get_result(programs::CLASS_FIELD_WRITE);
   EXPECT_INT(v, 99);
 }
 
+TEST(Interp, FieldInitializersRunInOrder) {
+  auto v = get_result(programs::FIELD_INITIALIZERS_RUN_IN_ORDER);
+  EXPECT_ARRAY(v, "[1, 2, 3]");
+}
+
+TEST(Interp, FieldSiteSeesSeveralLayouts) {
+  auto v = get_result(programs::FIELD_SITE_SEES_SEVERAL_LAYOUTS);
+  EXPECT_INT(v, 45);
+}
+
+TEST(Interp, MemberAccessOnExpressions) {
+  auto v = get_result(programs::MEMBER_ACCESS_ON_EXPRESSIONS);
+  EXPECT_INT(v, 7);
+}
+
+TEST(Interp, PolymorphicCallSite) {
+  auto v = get_result(programs::POLYMORPHIC_CALL_SITE);
+  EXPECT_STR(v, "abab");
+}
+
+TEST(Interp, CallSiteSeesInstancesAndNatives) {
+  auto v = get_result(programs::CALL_SITE_SEES_INSTANCES_AND_NATIVES);
+  EXPECT_INT(v, 4);
+}
+
 TEST(Interp, ClassMethodCall) {
-  auto v = get_result(
-    "clase Contador\n"
-    "  var n se 0\n"
-    "  func crear(inicio) este.n se inicio fin\n"
-    "  func incrementar() este.n se este.n + 1 fin\n"
-    "  func valor() devolver este.n fin\n"
-    "fin\n"
-    "var c se Contador(0)\n"
-    "c.incrementar()\n"
-    "c.incrementar()\n"
-    "c.incrementar()\n"
-    "func resultado() devolver c.valor() fin"
-  );
+  auto v = get_result(programs::CLASS_METHOD_CALL);
   EXPECT_INT(v, 3);
 }
 
 TEST(Interp, ClassSiblingMethodCall) {
-  auto v = get_result(
-    "clase A\n"
-    "  func doble(x) devolver x + x fin\n"
-    "  func cuad(x) devolver este.doble(este.doble(x)) fin\n"
-    "fin\n"
-    "var a se A()\n"
-    "func resultado() devolver a.cuad(3) fin"
-  );
+  auto v = get_result(programs::CLASS_SIBLING_METHOD_CALL);
   EXPECT_INT(v, 12);
 }
 
 TEST(Interp, ClassToString) {
-  auto v = get_result(
-    "clase Cosa fin\n"
-    "func resultado() devolver Cosa() fin"
-  );
-  ASSERT_NE(v, nullptr);
+  auto v = get_result(programs::CLASS_TO_STRING);
+  ASSERT_TRUE(v.has_value());
   EXPECT_NE(v->to_string().find("Cosa"), std::string::npos);
 }
 
@@ -513,180 +628,257 @@ TEST(Interp, ClassCtorArityMismatch) {
     "  func crear(a, b) fin\n"
     "fin\n"
     "var p se P(1)",
-    "argumento"
+    "argumento",
+    {SemanticErrorCode::CTOR_ARITY_MISMATCH}
   );
 }
 TEST(Interp, Fibonacci) {
-  auto v = get_result(
-    "func fib(n)\n"
-    "  si n < 2 haz\n"
-    "   devolver n\n"
-    "  sino\n"
-    "   devolver fib(n - 1) + fib(n - 2)\n"
-    "  fin\n"
-    "fin\n"
-    "func resultado() devolver fib(10) fin"
-  );
+  auto v = get_result(programs::FIBONACCI);
   EXPECT_INT(v, 55);
 }
 
 TEST(Interp, Factorial) {
-  auto v = get_result(
-    "func fact(n)\n"
-    "  si n <= 1 haz devolver 1 fin\n"
-    "  devolver n * fact(n - 1)\n"
-    "fin\n"
-    "func resultado() devolver fact(10) fin"
-  );
+  auto v = get_result(programs::FACTORIAL);
   EXPECT_INT(v, 3628800);
 }
 
 TEST(Interp, SumArray) {
-  auto v = get_result(
-    "func suma_hasta(n)\n"
-    "  var acc se 0\n"
-    "  var i se 1\n"
-    "  mientras i <= n haz\n"
-    "    acc se acc + i\n"
-    "    i se i + 1\n"
-    "  fin\n"
-    "  devolver acc\n"
-    "fin\n"
-    "func resultado() devolver suma_hasta(100) fin"
-  );
+  auto v = get_result(programs::SUM_ARRAY);
   EXPECT_INT(v, 5050);
 }
 
 TEST(Interp, CounterClass) {
-  auto v = get_result(
-    "clase Contador\n"
-    "  var n se 0\n"
-    "  func crear(start) este.n se start fin\n"
-    "  func tick() este.n se este.n + 1 fin\n"
-    "  func get() devolver este.n fin\n"
-    "fin\n"
-    "var c se Contador(10)\n"
-    "c.tick()\n"
-    "c.tick()\n"
-    "c.tick()\n"
-    "func resultado() devolver c.get() fin"
-  );
+  auto v = get_result(programs::COUNTER_CLASS);
   EXPECT_INT(v, 13);
 }
 
 TEST(Interp, HigherOrderViaWrapper) {
-  auto v = get_result(
-    "func aplicar_doble(x) devolver x + x fin\n"
-    "func componer(x) devolver aplicar_doble(aplicar_doble(x)) fin\n"
-    "func resultado() devolver componer(5) fin"
-  );
+  auto v = get_result(programs::HIGHER_ORDER_VIA_WRAPPER);
   EXPECT_INT(v, 20);
 }
 
 TEST(Interp, StringToInt) {
-  auto v = get_result(
-    "var str se '3.14'"
-    "var num se decimal(str)"
-    "func resultado() devolver num fin"
-  );
+  auto v = get_result(programs::STRING_TO_INT);
   EXPECT_FLOAT(v, 3.14);
 }
 
 TEST(Interp, NumToStr) {
-  auto v = get_result(
-    "var num se 3.14"
-    "var str se cadena(num)"
-    "func resultado() devolver str fin"
-  );
+  auto v = get_result(programs::NUM_TO_STR);
   EXPECT_STR(v, "3.14");
 }
 
 TEST(Interp, IndexStr) {
-  auto v = get_result(
-    "var str se 'Holis'"
-    "var char se str[0]"
-    "func resultado() devolver char fin"
-  );
+  auto v = get_result(programs::INDEX_STR);
   EXPECT_STR(v, "H");
 }
 
 TEST(Interp, Index2dArray) {
-  auto v = get_result(
-    "var array se [['#', 'x', '#']]"
-    "func resultado() devolver array[0][1] fin"
-  );
+  auto v = get_result(programs::INDEX2D_ARRAY);
   EXPECT_STR(v, "x");
 }
 
 TEST(Interp, LhsArrayAssignment) {
-  auto v = get_result(
-    "var array se [['#', 'x', '#']]"
-    "array[0][1] se '#'"
-    "func resultado() devolver array[0][1] fin"
-  );
+  auto v = get_result(programs::LHS_ARRAY_ASSIGNMENT);
   EXPECT_STR(v, "#");
 }
 
 TEST(Interp, RoundNumber) {
-  auto v = get_result(
-    "func resultado() devolver redondear(0.6) fin"
-  );
+  auto v = get_result(programs::ROUND_NUMBER);
   EXPECT_FLOAT(v, 1);
 }
 
-TEST(Array, Insertar) {
-  auto v = get_result(
-    "var x se []"
-    "x.insertar(10)"
-    "x.insertar('hello')"
+// Deep enough to overflow the C++ stack if every call nested.
+TEST(Interp, TailRecursionRunsInConstantStack) {
+  auto v = get_result(programs::TAIL_RECURSION_RUNS_IN_CONSTANT_STACK);
+  EXPECT_INT(v, 500000500000);
+}
 
-    "func resultado() devolver x fin"
+// Sema has no forward references and reports 'es_impar'; the walker looks
+// the name up when the call runs.
+TEST(Interp, MutualTailCallsFromMethod) {
+  auto v = get_result(
+    "func es_par(n) si n = 0 haz devolver verdadero fin devolver es_impar(n - 1) fin\n"
+    "func es_impar(n) si n = 0 haz devolver falso fin devolver es_par(n - 1) fin\n"
+    "clase P\n"
+    "  var n se 300001\n"
+    "  func paridad() devolver es_par(este.n) fin\n"
+    "fin\n"
+    "func resultado() devolver P().paridad() fin",
+    {SemanticErrorCode::RET_OUTSIDE_FUNC, SemanticErrorCode::UNDECLARED_FUNC}
   );
+  EXPECT_BOOL(v, false);
+}
+
+TEST(Interp, TailCallToNestedFunctionKeepsFrame) {
+  auto v = get_result(programs::TAIL_CALL_TO_NESTED_FUNCTION_KEEPS_FRAME);
+  EXPECT_INT(v, 42);
+}
+
+// The left operand is read before the call on the right reassigns it.
+TEST(Interp, OperandsKeepTheirValueAcrossCalls) {
+  auto v = get_result(programs::OPERANDS_KEEP_THEIR_VALUE_ACROSS_CALLS);
+  EXPECT_INT(v, 4);
+}
+
+TEST(Interp, TailCallToLargerFrame) {
+  auto v = get_result(programs::TAIL_CALL_TO_LARGER_FRAME);
+  EXPECT_INT(v, 505500);
+}
+
+// Frames spill over several ValueStack chunks; locals must stay intact.
+TEST(Interp, DeepRecursionKeepsEveryFrame) {
+  auto v = get_result(programs::DEEP_RECURSION_KEEPS_EVERY_FRAME);
+  EXPECT_INT(v, 4501500);
+}
+
+// Past max_depth a run fails cleanly instead of running out of native stack.
+TEST(Interp, DeepRecursionOverflowsCleanly) {
+  for (auto options : MODES) {
+    options.max_depth = 1000;
+    Parser p{"func f(n) devolver 1 + f(n + 1) fin\nf(0)"};
+    auto ast = p.parse();
+    Sema{}.analyze(ast);
+    Interpreter interp{options};
+    try {
+      interp.run(ast);
+      FAIL() << "Expected a stack overflow";
+    } catch (const RuntimeError& e) {
+      EXPECT_NE(std::string(e.what()).find("desbordamiento de pila"), std::string::npos) << e.what();
+    }
+  }
+}
+
+TEST(Interp, RecursionDeeperThanTheNativeStack) {
+  Parser p{
+    "func f(n) si n = 0 haz devolver 0 fin devolver 1 + f(n - 1) fin\n"
+    "devolver f(200000)"
+  };
+  auto ast = p.parse();
+  analyze(ast);
+  Interpreter interp{{.jit = false, .max_depth = 300'000}};
+  try {
+    interp.run(ast);
+    FAIL() << "Expected ReturnSignal";
+  } catch (const ReturnSignal& rs) {
+    EXPECT_EQ(rs.value.as_int(), 200000);
+  }
+}
+
+// A depth whose stack cannot even be sized is an error, not a stack small
+// enough to disable the check.
+TEST(Interp, UnsizableStackIsRejected) {
+  Parser p{"func f(n) devolver 1 + f(n + 1) fin\nf(0)"};
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+  Interpreter interp{{.max_depth = SIZE_MAX / 2}};
+  try {
+    interp.run(ast);
+    FAIL() << "Expected a RuntimeError";
+  } catch (const RuntimeError& e) {
+    EXPECT_NE(std::string(e.what()).find("no cabe una pila"), std::string::npos) << e.what();
+  }
+}
+
+// Every run() of an interpreter goes to the same thread, and an error in
+// one does not stop the next.
+TEST(Interp, RunsReuseTheInterpreterThread) {
+  Interpreter interp{{.max_depth = 1000}};
+  Parser fails{"func f(n) devolver 1 + f(n + 1) fin\nf(0)"};
+  auto ast = fails.parse();
+  Sema{}.analyze(ast);
+  EXPECT_THROW(interp.run(ast), RuntimeError);
+  Parser works{"devolver 7"};
+  auto again = works.parse();
+  try {
+    interp.run(again);
+    FAIL() << "Expected ReturnSignal";
+  } catch (const ReturnSignal& rs) {
+    EXPECT_EQ(rs.value.as_int(), 7);
+  }
+}
+
+// The REPL keeps one interpreter across inputs, so a call site that ran
+// before must notice when its name is later bound to something else.
+TEST(Interp, RedefinitionReachesResolvedCallSites) {
+  Sema sema;
+  sema.init_repl();
+  Interpreter interp;
+  std::vector<StmtsPtr> inputs;
+  auto feed = [&](std::string_view src) -> std::optional<Value> {
+    Parser p{src};
+    inputs.push_back(p.parse());
+    // A top-level 'devolver' is how the result gets out. The REPL's Sema
+    // turns redefinitions away, but the interpreter must cope with them
+    // on its own.
+    analyze_input(sema, inputs.back(), {SemanticErrorCode::RET_OUTSIDE_FUNC, SemanticErrorCode::REDEFINITION});
+    try {
+      interp.run(inputs.back());
+    } catch (ReturnSignal& rs) {
+      return rs.value;
+    }
+    return std::nullopt;
+  };
+
+  feed("func valor() devolver 1 fin\nfunc usar() devolver valor() fin");
+  auto before = feed("devolver usar()");
+  EXPECT_INT(before, 1);
+
+  feed("func valor() devolver 2 fin");
+  auto after = feed("devolver usar()");
+  EXPECT_INT(after, 2);
+
+  feed("clase valor\n  var n se 3\nfin");
+  auto shadowed = feed("devolver usar().n");
+  EXPECT_INT(shadowed, 3);
+}
+
+// A global from an earlier input may hold any type, whatever a later one
+// assigns to it: 'x + 1' must not be specialized to ints.
+TEST(Interp, ReplGlobalsKeepTheirTypeOpen) {
+  Sema sema;
+  sema.init_repl();
+  Interpreter interp;
+  std::vector<StmtsPtr> inputs;
+  for (std::string_view src : {"var x se 1.5", "escribe(x + 1) x se 2"}) {
+    Parser p{src};
+    inputs.push_back(p.parse());
+    sema.analyze_incremental(inputs.back());
+    Optimizer{}.optimize(inputs.back());
+  }
+  testing::internal::CaptureStdout();
+  try {
+    interp.run(inputs[0]);
+    interp.run(inputs[1]);
+  } catch (...) {
+    testing::internal::GetCapturedStdout();
+    throw;
+  }
+  EXPECT_EQ(testing::internal::GetCapturedStdout(), "2.5\n");
+}
+
+TEST(Array, Insertar) {
+  auto v = get_result(programs::ARRAY_INSERTAR);
   EXPECT_ARRAY(v, "[10, hello]");
 }
 
 TEST(Array, Eliminar) {
-  auto v = get_result(
-    "var x se [0.05, 10, 30, 'hello']"
-    "x.eliminar(0)"
-    "func resultado() devolver x fin"
-  );
+  auto v = get_result(programs::ARRAY_ELIMINAR);
   EXPECT_ARRAY(v, "[10, 30, hello]");
 }
 
 TEST(Array, Contiene) {
-  auto v = get_result(
-    "var id se 'random'"
-    "var x se [0, 0, 3, id]"
-    "func resultado() devolver x.contiene('random') fin"
-  );
-  EXPECT_TRUE(v);
+  auto v = get_result(programs::ARRAY_CONTIENE);
+  EXPECT_BOOL(v, true);
 }
 
 TEST(Array, InsertarEn) {
-  auto v = get_result(
-    "var id se 'target'"
-    "var x se [0, 0, 3]"
-    "x.insertar_en(1, id)"
-    "func resultado() devolver x.encuentra(id) fin"
-  );
+  auto v = get_result(programs::ARRAY_INSERTAR_EN);
   EXPECT_INT(v, 1);
 }
 
 
 TEST(Continuar, ReturnStillWorksWithContinuar) {
-  auto v = get_result(
-    "func f()\n"
-    "  var i se 0\n"
-    "  mientras i < 10 haz\n"
-    "    i se i + 1\n"
-    "    si i = 5 haz devolver i fin\n"
-    "    continuar\n"
-    "  fin\n"
-    "  devolver 0\n"
-    "fin\n"
-    "func resultado() devolver f() fin"
-  );
+  auto v = get_result(programs::CONTINUAR_RETURN_STILL_WORKS_WITH_CONTINUAR);
   EXPECT_INT(v, 5);
 }
 
@@ -702,65 +894,115 @@ TEST(Continuar, ScopeCleanedUpOnContinue) {
 }
 
 TEST(Continuar, InsideFuncLoop) {
-  auto v = get_result(
-    "func sumar_pares(n)\n"
-    "  var sum se 0\n"
-    "  var i se 0\n"
-    "  mientras i < n haz\n"
-    "    i se i + 1\n"
-    "    si i = 1 o i = 3 o i = 5 haz continuar fin\n"
-    "    sum se sum + i\n"
-    "  fin\n"
-    "  devolver sum\n"
-    "fin\n"
-    "func resultado() devolver sumar_pares(6) fin" // 6
-  );
+  auto v = get_result(programs::CONTINUAR_INSIDE_FUNC_LOOP);
   // 2+4+6 = 12
   EXPECT_INT(v, 12);
 }
 
+TEST(Continuar, OnlyAffectsInnermostLoop) {
+  auto v = get_result(programs::CONTINUAR_ONLY_AFFECTS_INNERMOST_LOOP);
+  EXPECT_INT(v, 5);
+}
+
 
 TEST(StrMethod, separar) {
-  auto v = get_result(
-    "var str se 'key|value'"
-    "var array se str.separar('|')"
-    "func resultado() devolver array fin"
-  );
+  auto v = get_result(programs::STR_METHOD_SEPARAR);
   EXPECT_ARRAY(v, "[key, value]");
 }
 
 TEST(StrMethod, SplitStrLiteral) {
-  auto v = get_result(
-    "func resultado() devolver 'hello world'.separar(' ') fin"
-  );
+  auto v = get_result(programs::STR_METHOD_SPLIT_STR_LITERAL);
   EXPECT_ARRAY(v, "[hello, world]");
 }
 
 TEST(StrMethod, ToUpper) {
-  auto v = get_result(
-    "func resultado() devolver 'hello world'.en_mayuscula() fin"
-  );
+  auto v = get_result(programs::STR_METHOD_TO_UPPER);
   EXPECT_STR(v, "HELLO WORLD");
 }
 
 TEST(StrMethod, ToLower) {
-  auto v = get_result(
-    "func resultado() devolver 'HELLO WORLD'.en_minuscula() fin"
-  );
+  auto v = get_result(programs::STR_METHOD_TO_LOWER);
   EXPECT_STR(v, "hello world");
 }
 
 TEST(StrMethod, Find) {
-  auto v = get_result(
-    "func resultado() devolver 'HELLO WORLD'.encuentra('E') fin"
-  );
+  auto v = get_result(programs::STR_METHOD_FIND);
   EXPECT_INT(v, 1);
 }
 
 TEST(StrMethod, NotFound) {
-  auto v = get_result(
-    "func resultado() devolver 'HELLO WORLD'.encuentra('z') fin"
-  );
+  auto v = get_result(programs::STR_METHOD_NOT_FOUND);
   EXPECT_NULL(v);
 }
 
+
+TEST(Scoping, FunctionsSeeGlobalsNotCallerLocals) {
+  auto v = get_result(programs::SCOPING_FUNCTIONS_SEE_GLOBALS_NOT_CALLER_LOCALS);
+  EXPECT_INT(v, 1);
+}
+
+TEST(Scoping, NestedFunctionReadsEnclosingLocals) {
+  auto v = get_result(programs::SCOPING_NESTED_FUNCTION_READS_ENCLOSING_LOCALS);
+  EXPECT_INT(v, 16);
+}
+
+TEST(Scoping, ThisVisibleInNestedFunction) {
+  auto v = get_result(programs::SCOPING_THIS_VISIBLE_IN_NESTED_FUNCTION);
+  EXPECT_INT(v, 6);
+}
+
+TEST(Scoping, NestedDeclarationsShadowOnlyTheirScope) {
+  auto v = get_result(programs::SCOPING_NESTED_DECLARATIONS_SHADOW_ONLY_THEIR_SCOPE);
+  EXPECT_INT(v, 121);
+}
+
+static auto memo_run(std::string_view src) -> MemoStats {
+  Parser p{src};
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+  Interpreter interp{{.memo = true}};
+  interp.run(ast);
+  return interp.memo_stats();
+}
+
+TEST(Memo, PureRecursionComputesEachArgumentOnce) {
+  auto stats = memo_run(
+    "func fib(n)\n"
+    "  si n < 2 haz devolver n fin\n"
+    "  devolver fib(n - 1) + fib(n - 2)\n"
+    "fin\n"
+    "var r se fib(25)"
+  );
+  EXPECT_EQ(stats.misses, 26u);
+  EXPECT_EQ(stats.hits, 23u);
+}
+
+TEST(Memo, ImpureFunctionsAreNotCached) {
+  auto stats = memo_run(
+    "var g se 1\n"
+    "func lee() devolver g fin\n"
+    "func muestra(n) escribe(n) devolver n fin\n"
+    "var a se lee() + lee()\n"
+    "var b se muestra(1) + muestra(1)"
+  );
+  EXPECT_EQ(stats.hits, 0u);
+  EXPECT_EQ(stats.misses, 0u);
+}
+
+TEST(Memo, ArrayResultsAreRecomputed) {
+  auto stats = memo_run(
+    "func par(n) devolver [n, n] fin\n"
+    "var a se par(1)\n"
+    "a[0] se 5\n"
+    "var b se par(1)\n"
+    "si b[0] != 1 haz salir() fin"
+  );
+  EXPECT_EQ(stats.hits, 0u);
+  EXPECT_EQ(stats.misses, 2u);
+}
+
+TEST(Memo, StringArgumentsAreKeys) {
+  auto result = get_result(programs::MEMO_STRING_ARGUMENTS_ARE_KEYS);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ(result->as_string(), "hola ana/hola eva");
+}
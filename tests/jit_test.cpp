@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <format>
+#include <optional>
+#include <string>
+#include "nodes.h"
+#include "parser.h"
+#include "sema.h"
+#include "interpreter.h"
+#include "test_support.h"
+
+struct JitRun {
+  StmtsPtr             ast;
+  std::optional<Value> result;
+};
+
+// Runs 'src' followed by 'devolver resultado()' on the tree walker.
+static auto run(std::string_view src, InterpreterOptions options = {}) -> JitRun {
+  std::string trigger = std::string(src) + "\ndevolver resultado()";
+  Parser p{trigger};
+  JitRun out{.ast = p.parse(), .result = std::nullopt};
+  analyze(out.ast);
+  try {
+    Interpreter{options}.run(out.ast);
+  } catch (ReturnSignal& rs) {
+    out.result = rs.value;
+  }
+  return out;
+}
+
+static auto function(const JitRun& r, std::size_t i) -> const FunctionDecl* {
+  return static_cast<const FunctionDecl*>(r.ast[i].get());
+}
+
+static constexpr std::string_view FIB =
+  "func fib(n)\n"
+  "  si n < 2 haz devolver n fin\n"
+  "  devolver fib(n - 1) + fib(n - 2)\n"
+  "fin\n"
+  "func resultado() devolver fib(20) fin";
+
+TEST(Jit, HotFunctionIsCompiled) {
+  auto r = run(FIB);
+  ASSERT_TRUE(r.result.has_value());
+  EXPECT_EQ(r.result->as_int(), 6765);
+  EXPECT_NE(function(r, 0)->native, nullptr);
+}
+
+TEST(Jit, OptionTurnsItOff) {
+  auto r = run(FIB, {.jit = false});
+  ASSERT_TRUE(r.result.has_value());
+  EXPECT_EQ(r.result->as_int(), 6765);
+  EXPECT_EQ(function(r, 0)->native, nullptr);
+}
+
+TEST(Jit, LoopsLocalsAndBooleans) {
+  static constexpr std::string_view src =
+    "func pasos(n)\n"
+    "  var k se 0\n"
+    "  mientras n != 1 haz\n"
+    "    si n / 2 * 2 = n haz n se n / 2 sino n se 3 * n + 1 fin\n"
+    "    k se k + 1\n"
+    "  fin\n"
+    "  devolver k\n"
+    "fin\n"
+    "func impar(n) devolver !(n / 2 * 2 = n) y n > 0 fin\n"
+    "func resultado()\n"
+    "  var total se 0\n"
+    "  var i se 1\n"
+    "  mientras i <= 300 haz\n"
+    "    total se total + pasos(i)\n"
+    "    si impar(i) haz total se total - max(i, 1) fin\n"
+    "    i se i + 1\n"
+    "  fin\n"
+    "  devolver total\n"
+    "fin";
+  auto jit  = run(src);
+  auto tree = run(src, {.jit = false});
+  ASSERT_TRUE(jit.result.has_value());
+  ASSERT_TRUE(tree.result.has_value());
+  EXPECT_EQ(jit.result->as_int(), tree.result->as_int());
+  EXPECT_NE(function(jit, 0)->native, nullptr);
+  EXPECT_NE(function(jit, 1)->native, nullptr);
+}
+
+TEST(Jit, SideEffectsStayInterpreted) {
+  auto r = run(
+    "func marca(n) devolver 'n=' + n fin\n"
+    "func resultado()\n"
+    "  var i se 0\n"
+    "  mientras i < 200 haz marca(i) i se i + 1 fin\n"
+    "  devolver marca(i)\n"
+    "fin"
+  );
+  ASSERT_TRUE(r.result.has_value());
+  EXPECT_EQ(r.result->as_string(), "n=200");
+  EXPECT_EQ(function(r, 0)->native, nullptr);
+}
+
+// Native frames must fit the stack run() reserves per call, whether it
+// is the locals or the operands waiting on the stack that take it.
+TEST(Jit, FramesLargerThanACallStayInterpreted) {
+  std::string locals = "func muchas(n)\n  var v0 se n\n";
+  for (auto i {1}; i < 300; ++i)
+    locals += std::format("  var v{} se v{} + 1\n", i, i - 1);
+  locals += "  devolver v299\nfin\n";
+  std::string operands = "func anidada(n) devolver ";
+  for (auto i {0}; i < 300; ++i)
+    operands += "n + (";
+  operands += "n" + std::string(300, ')') + " fin\n";
+
+  auto r = run(
+    locals + operands +
+    "func resultado()\n"
+    "  var total se 0\n"
+    "  var i se 0\n"
+    "  mientras i < 200 haz total se total + muchas(i) + anidada(i) i se i + 1 fin\n"
+    "  devolver total\n"
+    "fin"
+  );
+  ASSERT_TRUE(r.result.has_value());
+  EXPECT_EQ(r.result->as_int(), 200 * 299 + 199 * 200 / 2 + 301 * 199 * 200 / 2);
+  EXPECT_EQ(function(r, 0)->native, nullptr);
+  EXPECT_EQ(function(r, 1)->native, nullptr);
+}
+
+TEST(Jit, OverflowFallsBackToTheInterpreterError) {
+  Parser p{
+    "func doble(n) devolver n * 2 fin\n"
+    "var i se 0\n"
+    "mientras i < 200 haz doble(i) i se i + 1 fin\n"
+    "doble(9223372036854775807)\n"
+  };
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+  EXPECT_THROW(Interpreter{}.run(ast), RuntimeError);
+}
+
+TEST(Jit, NonIntArgumentsUseTheInterpreter) {
+  auto r = run(
+    "func suma(a, b) devolver a + b fin\n"
+    "func resultado()\n"
+    "  var i se 0\n"
+    "  mientras i < 200 haz suma(i, 1) i se i + 1 fin\n"
+    "  devolver suma('a', 'b')\n"
+    "fin"
+  );
+  ASSERT_TRUE(r.result.has_value());
+  EXPECT_EQ(r.result->as_string(), "ab");
+  EXPECT_NE(function(r, 0)->native, nullptr);
+}
+
+TEST(Jit, DeepRecursionGoesBackToTheInterpreter) {
+  auto r = run(
+    "func suma(n, acc)\n"
+    "  si n = 0 haz devolver acc fin\n"
+    "  devolver suma(n - 1, acc + n)\n"
+    "fin\n"
+    "func resultado() devolver suma(200000, 0) fin"
+  );
+  ASSERT_TRUE(r.result.has_value());
+  EXPECT_EQ(r.result->as_int(), 20000100000);
+}
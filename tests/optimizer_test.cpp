@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <optional>
+#include "nodes.h"
+#include "parser.h"
+#include "sema.h"
+#include "optimizer.h"
+#include "interpreter.h"
+#include "compiler.h"
+#include "vm.h"
+#include "test_support.h"
+
+static auto optimized(std::string_view src, AllowedErrors allowed = {}) -> StmtsPtr {
+  Parser p{src};
+  auto ast = p.parse();
+  analyze(ast, allowed);
+  Optimizer{}.optimize(ast);
+  return ast;
+}
+
+static auto pruned(std::string_view src) -> StmtsPtr {
+  auto ast = optimized(src);
+  Optimizer{}.prune(ast);
+  return ast;
+}
+
+// Runs the optimized program on both backends; they must agree.
+static auto get_result(std::string_view src) -> std::optional<Value> {
+  auto ast = optimized(std::string(src) + "\ndevolver resultado()", HARNESS_ERRORS);
+
+  std::optional<Value> tree, vm;
+  try {
+    Interpreter{}.run(ast);
+  } catch (ReturnSignal& rs) {
+    tree = rs.value;
+  }
+  try {
+    auto program = Compiler{}.compile(ast);
+    VM{program}.run();
+  } catch (ReturnSignal& rs) {
+    vm = rs.value;
+  }
+  if (!tree || !vm) return std::nullopt;
+  EXPECT_EQ(tree->to_string(), vm->to_string());
+  return tree;
+}
+
+static auto initializer(const StmtsPtr& ast, std::size_t i) -> const IAST* {
+  return static_cast<const VariableDecl*>(ast[i].get())->expr.get();
+}
+
+static auto as_literal(const IAST* node) -> const Literal* {
+  EXPECT_EQ(node->node_type, NodeType::LITERAL);
+  return static_cast<const Literal*>(node);
+}
+
+TEST(Optimizer, FoldsIntArithmetic) {
+  auto ast = optimized("var x se (2 + 3) * 4 - 1");
+  auto* lit = as_literal(initializer(ast, 0));
+  ASSERT_TRUE(lit->value.is_int());
+  EXPECT_EQ(lit->value.as_int(), 19);
+}
+
+TEST(Optimizer, FoldsMixedFloat) {
+  auto ast = optimized("var x se 2 * 3.14");
+  auto* lit = as_literal(initializer(ast, 0));
+  ASSERT_TRUE(lit->value.is_float());
+  EXPECT_DOUBLE_EQ(lit->value.as_float(), 6.28);
+}
+
+TEST(Optimizer, FoldsUnaryAndStrings) {
+  auto ast = optimized("var a se -(-5)\nvar b se !falso\nvar c se 'n=' + 4");
+  EXPECT_EQ(as_literal(initializer(ast, 0))->value.as_int(), 5);
+  EXPECT_EQ(as_literal(initializer(ast, 1))->value.as_bool(), true);
+  EXPECT_EQ(as_literal(initializer(ast, 2))->value.as_string(), "n=4");
+}
+
+TEST(Optimizer, PropagatesConstIntoUses) {
+  auto ast = optimized(
+    "const FILAS se 3\n"
+    "const CELDAS se FILAS * FILAS\n"
+    "var x se CELDAS + 1"
+  );
+  EXPECT_EQ(as_literal(initializer(ast, 1))->value.as_int(), 9);
+  EXPECT_EQ(as_literal(initializer(ast, 2))->value.as_int(), 10);
+}
+
+TEST(Optimizer, LeavesVariablesAlone) {
+  auto ast = optimized("var n se 3\nvar x se n + 1");
+  EXPECT_EQ(initializer(ast, 1)->node_type, NodeType::BINARYOP);
+}
+
+TEST(Optimizer, KeepsOperationsThatFail) {
+  auto ast = optimized("var x se 1 / 0");
+  EXPECT_EQ(initializer(ast, 0)->node_type, NodeType::BINARYOP);
+}
+
+TEST(Optimizer, ShortCircuitWithConstantLeft) {
+  auto ast = optimized(
+    "func toca() devolver 1 fin\n"
+    "var a se falso y toca()\n"
+    "var b se verdadero y toca()\n"
+    "var c se verdadero o toca()"
+  );
+  EXPECT_EQ(as_literal(initializer(ast, 1))->value.as_bool(), false);
+  EXPECT_EQ(initializer(ast, 2)->node_type, NodeType::BINARYOP);
+  EXPECT_EQ(as_literal(initializer(ast, 3))->value.as_bool(), true);
+}
+
+TEST(Optimizer, DropsWhileFalse) {
+  auto ast = optimized("mientras 1 > 2 haz escribe(1) fin");
+  EXPECT_TRUE(ast.empty());
+}
+
+TEST(Optimizer, IfTrueBecomesItsBody) {
+  auto ast = optimized("si 1 < 2 haz escribe(1) sino escribe(2) fin");
+  ASSERT_EQ(ast.size(), 1u);
+  EXPECT_EQ(ast[0]->node_type, NodeType::FUNCTIONCALL);
+}
+
+TEST(Optimizer, IfFalseFallsToElseIf) {
+  auto ast = optimized(
+    "var a se 1\n"
+    "si falso haz a se 2\n"
+    "sino si a = 1 haz a se 3\n"
+    "fin"
+  );
+  ASSERT_EQ(ast.size(), 2u);
+  ASSERT_EQ(ast[1]->node_type, NodeType::IFSTATEMENT);
+  auto* node = static_cast<const IfStatement*>(ast[1].get());
+  EXPECT_EQ(node->condition->node_type, NodeType::BINARYOP);
+}
+
+TEST(Optimizer, BlockWithDeclarationsKeepsItsScope) {
+  auto v = get_result(
+    "const K se 3\n"
+    "var x se 1\n"
+    "si K > 2 haz var x se K * 2 fin\n"
+    "func resultado() devolver x fin"
+  );
+  ASSERT_TRUE(v.has_value());
+  EXPECT_EQ(v->as_int(), 1);
+}
+
+TEST(Optimizer, BackendsAgreeAfterFolding) {
+  auto v = get_result(
+    "const BASE se 10\n"
+    "func resultado()\n"
+    "  var acc se 0\n"
+    "  var i se 0\n"
+    "  mientras i < BASE / 2 haz\n"
+    "    si BASE > 5 haz acc se acc + BASE * 2 sino acc se 0 fin\n"
+    "    i se i + 1\n"
+    "  fin\n"
+    "  devolver acc\n"
+    "fin"
+  );
+  ASSERT_TRUE(v.has_value());
+  EXPECT_EQ(v->as_int(), 100);
+}
+
+TEST(Optimizer, DropsStatementsAfterReturn) {
+  auto ast = optimized(
+    "func f(n)\n"
+    "  si n > 0 haz devolver 1 escribe('nunca') fin\n"
+    "  devolver 0\n"
+    "  escribe('nunca')\n"
+    "fin"
+  );
+  auto* fn = static_cast<const FunctionDecl*>(ast[0].get());
+  ASSERT_EQ(fn->body.size(), 2u);
+  EXPECT_EQ(static_cast<const IfStatement*>(fn->body[0].get())->then_body.size(), 1u);
+}
+
+TEST(Optimizer, PruneKeepsOnlyReachableDeclarations) {
+  auto ast = pruned(
+    "func hoja() devolver 1 fin\n"
+    "func usada() devolver hoja() fin\n"
+    "func muerta() devolver hoja() fin\n"
+    "clase Nunca fin\n"
+    "escribe(usada())"
+  );
+  ASSERT_EQ(ast.size(), 3u);
+  EXPECT_EQ(static_cast<const FunctionDecl*>(ast[0].get())->id, "hoja");
+  EXPECT_EQ(static_cast<const FunctionDecl*>(ast[1].get())->id, "usada");
+}
+
+TEST(Optimizer, PruneKeepsInvokedMethods) {
+  auto ast = pruned(
+    "clase P\n"
+    "  var n se 0\n"
+    "  func crear(n) este.n se n fin\n"
+    "  func doble() devolver este.n * 2 fin\n"
+    "  func nunca() devolver 0 fin\n"
+    "fin\n"
+    "var p se P(4)\n"
+    "escribe(p.doble())"
+  );
+  auto* klass = static_cast<const ClassDecl*>(ast[0].get());
+  EXPECT_EQ(klass->members.size(), 3u);
+}
+
+TEST(Optimizer, PruneDropsFunctionsOnlyDeadCodeCalls) {
+  auto ast = pruned(
+    "func usada() devolver 1 fin\n"
+    "si falso haz usada() fin"
+  );
+  EXPECT_TRUE(ast.empty());
+}
@@ -26,6 +26,17 @@ TEST(Parser, VarDeclInteger) {
   EXPECT_EQ(lit->token.literal, "42");
 }
 
+TEST(Parser, LiteralValueMaterialized) {
+  auto stmts = parse_ok("var x se [42, 2.5, 'hola', falso, nulo]");
+  auto* arr = as<ArrayDecl>(as<VariableDecl>(stmts[0])->expr);
+  ASSERT_EQ(arr->data.size(), 5u);
+  EXPECT_EQ(as<Literal>(arr->data[0])->value.as_int(), 42);
+  EXPECT_DOUBLE_EQ(as<Literal>(arr->data[1])->value.as_float(), 2.5);
+  EXPECT_EQ(as<Literal>(arr->data[2])->value.as_string(), "hola");
+  EXPECT_FALSE(as<Literal>(arr->data[3])->value.as_bool());
+  EXPECT_TRUE(as<Literal>(arr->data[4])->value.is_null());
+}
+
 TEST(Parser, VarDeclFloat) {
   auto stmts = parse_ok("var pi se 3.14");
   auto* decl = as<VariableDecl>(stmts[0]);
@@ -312,6 +323,20 @@ TEST(Parser, MethodCall) {
   ASSERT_EQ(call->args.size(), 2u);
 }
 
+TEST(Parser, MemberAccessChain) {
+  auto stmts = parse_ok("a.b.c se x.w");
+  auto* assign = as<Assignment>(stmts[0]);
+  ASSERT_NE(assign, nullptr);
+  auto* outer = as<MemberAccess>(assign->target);
+  ASSERT_EQ(outer->node_type, NodeType::MEMBERACCESS);
+  EXPECT_EQ(*outer->field, "c");
+  auto* inner = as<MemberAccess>(outer->object);
+  ASSERT_EQ(inner->node_type, NodeType::MEMBERACCESS);
+  EXPECT_EQ(*inner->field, "b");
+  EXPECT_EQ(as<Literal>(inner->object)->token.literal, "a");
+  EXPECT_EQ(as<MemberAccess>(assign->expr)->node_type, NodeType::MEMBERACCESS);
+}
+
 TEST(Parser, IfSimple) {
   auto stmts = parse_ok("si verdadero haz fin");
   ASSERT_EQ(stmts.size(), 1u);
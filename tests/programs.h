@@ -0,0 +1,655 @@
+#pragma once
+#include <string_view>
+
+// The programs the interpreter tests run, shared with the transpiler test,
+// which translates each one followed by 'escribe(resultado())' and expects
+// the tree walker's output. Each defines 'resultado'; the tests check what
+// it returns. Named after the test that runs them.
+namespace programs {
+inline constexpr std::string_view GC_COLLECTS_WHILE_THE_PROGRAM_RUNS =
+  "clase Nodo\n"
+  "  var valor se 0\n"
+  "  var sig se nulo\n"
+  "  func crear(v) este.valor se v fin\n"
+  "fin\n"
+  "var lista se nulo\n"
+  "var i se 0\n"
+  "var j se 0\n"
+  "mientras i < 20000 haz\n"
+  "  var a se Nodo(i)\n"
+  "  a.sig se a\n"
+  "  si j = 0 haz\n"
+  "    var n se Nodo(i)\n"
+  "    n.sig se lista\n"
+  "    lista se n\n"
+  "  fin\n"
+  "  j se j + 1\n"
+  "  si j = 100 haz j se 0 fin\n"
+  "  i se i + 1\n"
+  "fin\n"
+  "func resultado()\n"
+  "  var total se 0\n"
+  "  var n se lista\n"
+  "  mientras n != nulo haz\n"
+  "    total se total + n.valor\n"
+  "    n se n.sig\n"
+  "  fin\n"
+  "  devolver total\n"
+  "fin";
+
+inline constexpr std::string_view LITERAL_INT = "func resultado() devolver 42 fin";
+inline constexpr std::string_view LITERAL_FLOAT = "func resultado() devolver 3.14 fin";
+inline constexpr std::string_view LITERAL_BOOL_TRUE = "func resultado() devolver verdadero fin";
+inline constexpr std::string_view LITERAL_BOOL_FALSE = "func resultado() devolver falso fin";
+inline constexpr std::string_view LITERAL_STRING = R"(func resultado() devolver "hola" fin)";
+inline constexpr std::string_view VAR_DECL_AND_READ = "var x se 7\nfunc resultado() devolver x fin";
+inline constexpr std::string_view CONST_DECL_AND_READ = "const MAX se 100\nfunc resultado() devolver MAX fin";
+inline constexpr std::string_view VAR_DECL_RHS_EXPRESSION = "var x se 3 + 4\nfunc resultado() devolver x fin";
+inline constexpr std::string_view ASSIGNMENT = "var x se 1\nx se 99\nfunc resultado() devolver x fin";
+inline constexpr std::string_view ASSIGNMENT_OVERWRITE =
+  "var x se 1\nx se 2\nx se 3\nfunc resultado() devolver x fin";
+inline constexpr std::string_view ADD = "func resultado() devolver 2 + 3 fin";
+inline constexpr std::string_view SUB = "func resultado() devolver 10 - 4 fin";
+inline constexpr std::string_view MUL = "func resultado() devolver 3 * 4 fin";
+inline constexpr std::string_view DIV = "func resultado() devolver 10 / 2 fin";
+inline constexpr std::string_view FLOAT_ADD = "func resultado() devolver 1.5 + 1.5 fin";
+inline constexpr std::string_view INT_FLOAT_MIXED = "func resultado() devolver 1 + 0.5 fin";
+inline constexpr std::string_view LARGE_INT_COMPARISON =
+  "func resultado() devolver 9007199254740993 - 1 > 9007199254740991 fin";
+inline constexpr std::string_view LARGE_INT_SUM = "func resultado() devolver 9007199254740993 + 2 fin";
+inline constexpr std::string_view TYPED_LOOP_MATCHES_GENERIC_RESULT =
+  "func resultado()\n"
+  "  var i se 0\n"
+  "  var f se 0.0\n"
+  "  mientras i < 10 haz i se i + 1 f se f + 0.5 fin\n"
+  "  devolver f * 2.0 + i / 3\n"
+  "fin";
+
+inline constexpr std::string_view POLYMORPHIC_SITE_RESPECIALIZES =
+  "func suma(a, b) devolver a + b fin\n"
+  "func resultado()\n"
+  "  devolver suma(1, 2) * 1000 + suma('ab', 'c').encuentra('c') * 100\n"
+  "       + entero(suma(0.5, 1.5)) * 10 + suma(2, 2)\n"
+  "fin";
+
+inline constexpr std::string_view NEGATION_UNARY = "func resultado() devolver -5 fin";
+inline constexpr std::string_view PRECEDENCE = "func resultado() devolver 2 + 3 * 4 fin";
+inline constexpr std::string_view PARENTHESES = "func resultado() devolver (2 + 3) * 4 fin";
+inline constexpr std::string_view STRING_CONCAT = R"(func resultado() devolver "hola" + " mundo" fin)";
+inline constexpr std::string_view STRING_INT_CONCAT = R"(func resultado() devolver "n=" + 42 fin)";
+inline constexpr std::string_view APPENDING_KEEPS_OTHER_COPIES =
+  "var s se \"a\"\n"
+  "var t se s\n"
+  "s se s + \"b\" + 1\n"
+  "s se s + \"c\"\n"
+  "func agrega(x) x se x + \"!\" devolver x fin\n"
+  "var u se agrega(s)\n"
+  "func resultado() devolver t + \"|\" + s + \"|\" + u fin";
+
+inline constexpr std::string_view APPENDING_A_STRING_TO_ITSELF =
+  "var s se \"a\"\n"
+  "s se s + \"b\"\n"
+  "s se s + \"-\" + s\n"
+  "func resultado() devolver s fin";
+
+inline constexpr std::string_view APPENDING_IN_A_LOOP =
+  "func resultado()\n"
+  "  var s se \"\"\n"
+  "  var i se 0\n"
+  "  mientras i < 20000 haz\n"
+  "    s se s + \"x\" + verdadero\n"
+  "    i se i + 1\n"
+  "  fin\n"
+  "  devolver s\n"
+  "fin";
+
+inline constexpr std::string_view CMP_LT_TRUE = "func resultado() devolver 1 < 2 fin";
+inline constexpr std::string_view CMP_LT_FALSE = "func resultado() devolver 2 < 1 fin";
+inline constexpr std::string_view CMP_GT = "func resultado() devolver 3 > 2 fin";
+inline constexpr std::string_view CMP_LE = "func resultado() devolver 2 <= 2 fin";
+inline constexpr std::string_view CMP_GE = "func resultado() devolver 3 >= 4 fin";
+inline constexpr std::string_view CMP_EQ_INT = "func resultado() devolver 5 = 5 fin";
+inline constexpr std::string_view CMP_NEQ = "func resultado() devolver 5 != 6 fin";
+inline constexpr std::string_view CMP_EQ_STR = R"(func resultado() devolver "a" = "a" fin)";
+inline constexpr std::string_view LOGICAL_AND_TT = "func resultado() devolver verdadero y verdadero fin";
+inline constexpr std::string_view LOGICAL_AND_TF = "func resultado() devolver verdadero y falso fin";
+inline constexpr std::string_view LOGICAL_OR_FF = "func resultado() devolver falso o falso fin";
+inline constexpr std::string_view LOGICAL_OR_TF = "func resultado() devolver verdadero o falso fin";
+inline constexpr std::string_view LOGICAL_BANG = "func resultado() devolver !verdadero fin";
+inline constexpr std::string_view LOGICAL_BANG_FALSE = "func resultado() devolver !falso fin";
+inline constexpr std::string_view IF_TAKEN =
+  "var x se 0\n"
+  "si verdadero haz x se 1 fin\n"
+  "func resultado() devolver  x fin";
+
+inline constexpr std::string_view IF_NOT_TAKEN =
+  "var x se 0\n"
+  "si falso haz x se 1 fin\n"
+  "func resultado() devolver x fin";
+
+inline constexpr std::string_view IF_ELSE_TAKEN =
+  "var x se 0\n"
+  "si falso haz x se 1 sino x se 2 fin\n"
+  "func resultado() devolver x fin";
+
+inline constexpr std::string_view IF_ELSE_IF_CHAIN =
+  "var n se 2\n"
+  "var r se 0\n"
+  "si n = 1 haz r se 10\n"
+  "sino si n = 2 haz r se 20\n"
+  "sino r se 30\n"
+  "fin\n"
+  "func resultado() devolver r fin";
+
+inline constexpr std::string_view WHILE_BASIC =
+  "var i se 0\n"
+  "mientras i < 5 haz i se i + 1 fin\n"
+  "func resultado() devolver i fin";
+
+inline constexpr std::string_view WHILE_NOT_ENTERED =
+  "var i se 10\n"
+  "mientras i < 5 haz i se i + 1 fin\n"
+  "func resultado() devolver i fin";
+
+inline constexpr std::string_view WHILE_ACCUMULATOR =
+  "var sum se 0\n"
+  "var i se 1\n"
+  "mientras i <= 10 haz\n"
+  "  sum se sum + i\n"
+  "  i se i + 1\n"
+  "fin\n"
+  "func resultado() devolver sum fin";
+
+inline constexpr std::string_view FUNC_NO_PARAMS = "func resultado() devolver 42 fin";
+inline constexpr std::string_view FUNC_WITH_PARAMS =
+  "func suma(a, b) devolver a + b fin\n"
+  "func resultado() devolver suma(3, 4) fin";
+
+inline constexpr std::string_view FUNC_RECURSION =
+  "func fib(n)\n"
+  "  si n < 2 haz devolver n fin\n"
+  "  devolver fib(n - 1) + fib(n - 2)\n"
+  "fin\n"
+  "func resultado() devolver fib(10) fin";
+
+inline constexpr std::string_view FUNC_RETURNS_NULL =
+  "func nada() fin\n"
+  "func resultado() devolver nada() fin";
+
+inline constexpr std::string_view FUNC_NESTED_CALLS =
+  "func doble(x) devolver x + x fin\n"
+  "func cuadruple(x) devolver doble(doble(x)) fin\n"
+  "func resultado() devolver cuadruple(3) fin";
+
+inline constexpr std::string_view ARRAY_EMPTY = "func resultado() devolver [] fin";
+inline constexpr std::string_view ARRAY_LITERAL = "func resultado() devolver [1, 2, 3] fin";
+inline constexpr std::string_view ARRAY_INDEX =
+  "var a se [10, 20, 30]\n"
+  "func resultado() devolver a[1] fin";
+
+inline constexpr std::string_view ARRAY_WITH_EXPRESSIONS =
+  "var n se 3\n"
+  "func resultado() devolver [n, n + 1, n + 2] fin";
+
+inline constexpr std::string_view CLASS_INSTANTIATION_NOCTOR =
+  "clase Punto\n"
+  "  var px se 0\n"
+  "  var py se 0\n"
+  "fin\n"
+  "func resultado() devolver Punto() fin";
+
+inline constexpr std::string_view CLASS_INSTANCE_FIELDS =
+  "clase Punto\n"
+  "  var px se 0\n"
+  "  var py se 0\n"
+  "  func crear(nx, ny)\n"
+  "    este.px se nx\n"
+  "    este.py se ny\n"
+  "  fin\n"
+  "fin\n"
+  "var p se Punto(3,1)\n"
+  "func resultado() devolver p.px fin";
+
+inline constexpr std::string_view CLASS_FIELD_WRITE =
+  "clase Caja\n"
+  "  var ancho se 0\n"
+  "  func crear(w) este.ancho se w fin\n"
+  "fin\n"
+  "var c se Caja(10)\n"
+  "c.ancho se 99\n"
+  "func resultado() devolver c.ancho fin";
+
+inline constexpr std::string_view FIELD_INITIALIZERS_RUN_IN_ORDER =
+  "var orden se []\n"
+  "func marca(n) orden.insertar(n) devolver n fin\n"
+  "clase P\n"
+  "  var z se marca(1)\n"
+  "  var a se marca(2)\n"
+  "  var m se marca(3)\n"
+  "fin\n"
+  "var p se P()\n"
+  "func resultado() devolver orden fin";
+
+inline constexpr std::string_view FIELD_SITE_SEES_SEVERAL_LAYOUTS =
+  "clase A\n"
+  "  var x se 1\n"
+  "  var w se 10\n"
+  "fin\n"
+  "clase B\n"
+  "  var w se 20\n"
+  "fin\n"
+  "func ancho_de(obj) devolver obj.w fin\n"
+  "var extra se A()\n"
+  "extra.nuevo se 5\n"
+  "func resultado() devolver ancho_de(A()) + ancho_de(B()) + ancho_de(A()) + extra.nuevo fin";
+
+inline constexpr std::string_view MEMBER_ACCESS_ON_EXPRESSIONS =
+  "clase Nodo\n"
+  "  var valor se 0\n"
+  "  var sig se nulo\n"
+  "  func crear(v) este.valor se v fin\n"
+  "fin\n"
+  "var a se Nodo(1)\n"
+  "a.sig se Nodo(2)\n"
+  "a.sig.sig se Nodo(3)\n"
+  "var lista se [a]\n"
+  "func resultado() devolver lista[0].sig.sig.valor + Nodo(4).valor fin";
+
+inline constexpr std::string_view POLYMORPHIC_CALL_SITE =
+  "clase A func nombre() devolver 'a' fin fin\n"
+  "clase B func nombre() devolver 'b' fin fin\n"
+  "var xs se [A(), B(), A(), B()]\n"
+  "func resultado()\n"
+  "  var s se ''\n"
+  "  var i se 0\n"
+  "  mientras i < 4 haz\n"
+  "    s se s + xs[i].nombre()\n"
+  "    i se i + 1\n"
+  "  fin\n"
+  "  devolver s\n"
+  "fin";
+
+inline constexpr std::string_view CALL_SITE_SEES_INSTANCES_AND_NATIVES =
+  "clase Lista\n"
+  "  var n se 0\n"
+  "  func insertar(x) este.n se este.n + x fin\n"
+  "fin\n"
+  "var l se Lista()\n"
+  "var xs se [l, [], l, []]\n"
+  "func resultado()\n"
+  "  var i se 0\n"
+  "  mientras i < 4 haz\n"
+  "    xs[i].insertar(i)\n"
+  "    i se i + 1\n"
+  "  fin\n"
+  "  devolver l.n + longitud(xs[1]) + longitud(xs[3])\n"
+  "fin";
+
+inline constexpr std::string_view CLASS_METHOD_CALL =
+  "clase Contador\n"
+  "  var n se 0\n"
+  "  func crear(inicio) este.n se inicio fin\n"
+  "  func incrementar() este.n se este.n + 1 fin\n"
+  "  func valor() devolver este.n fin\n"
+  "fin\n"
+  "var c se Contador(0)\n"
+  "c.incrementar()\n"
+  "c.incrementar()\n"
+  "c.incrementar()\n"
+  "func resultado() devolver c.valor() fin";
+
+inline constexpr std::string_view CLASS_SIBLING_METHOD_CALL =
+  "clase A\n"
+  "  func doble(x) devolver x + x fin\n"
+  "  func cuad(x) devolver este.doble(este.doble(x)) fin\n"
+  "fin\n"
+  "var a se A()\n"
+  "func resultado() devolver a.cuad(3) fin";
+
+inline constexpr std::string_view CLASS_TO_STRING =
+  "clase Cosa fin\n"
+  "func resultado() devolver Cosa() fin";
+
+inline constexpr std::string_view FIBONACCI =
+  "func fib(n)\n"
+  "  si n < 2 haz\n"
+  "   devolver n\n"
+  "  sino\n"
+  "   devolver fib(n - 1) + fib(n - 2)\n"
+  "  fin\n"
+  "fin\n"
+  "func resultado() devolver fib(10) fin";
+
+inline constexpr std::string_view FACTORIAL =
+  "func fact(n)\n"
+  "  si n <= 1 haz devolver 1 fin\n"
+  "  devolver n * fact(n - 1)\n"
+  "fin\n"
+  "func resultado() devolver fact(10) fin";
+
+inline constexpr std::string_view SUM_ARRAY =
+  "func suma_hasta(n)\n"
+  "  var acc se 0\n"
+  "  var i se 1\n"
+  "  mientras i <= n haz\n"
+  "    acc se acc + i\n"
+  "    i se i + 1\n"
+  "  fin\n"
+  "  devolver acc\n"
+  "fin\n"
+  "func resultado() devolver suma_hasta(100) fin";
+
+inline constexpr std::string_view COUNTER_CLASS =
+  "clase Contador\n"
+  "  var n se 0\n"
+  "  func crear(start) este.n se start fin\n"
+  "  func tick() este.n se este.n + 1 fin\n"
+  "  func get() devolver este.n fin\n"
+  "fin\n"
+  "var c se Contador(10)\n"
+  "c.tick()\n"
+  "c.tick()\n"
+  "c.tick()\n"
+  "func resultado() devolver c.get() fin";
+
+inline constexpr std::string_view HIGHER_ORDER_VIA_WRAPPER =
+  "func aplicar_doble(x) devolver x + x fin\n"
+  "func componer(x) devolver aplicar_doble(aplicar_doble(x)) fin\n"
+  "func resultado() devolver componer(5) fin";
+
+inline constexpr std::string_view STRING_TO_INT =
+  "var str se '3.14'"
+  "var num se decimal(str)"
+  "func resultado() devolver num fin";
+
+inline constexpr std::string_view NUM_TO_STR =
+  "var num se 3.14"
+  "var str se cadena(num)"
+  "func resultado() devolver str fin";
+
+inline constexpr std::string_view INDEX_STR =
+  "var str se 'Holis'"
+  "var char se str[0]"
+  "func resultado() devolver char fin";
+
+inline constexpr std::string_view INDEX2D_ARRAY =
+  "var array se [['#', 'x', '#']]"
+  "func resultado() devolver array[0][1] fin";
+
+inline constexpr std::string_view LHS_ARRAY_ASSIGNMENT =
+  "var array se [['#', 'x', '#']]"
+  "array[0][1] se '#'"
+  "func resultado() devolver array[0][1] fin";
+
+inline constexpr std::string_view ROUND_NUMBER = "func resultado() devolver redondear(0.6) fin";
+inline constexpr std::string_view TAIL_RECURSION_RUNS_IN_CONSTANT_STACK =
+  "func suma(n, acc)\n"
+  "  si n = 0 haz devolver acc fin\n"
+  "  devolver suma(n - 1, acc + n)\n"
+  "fin\n"
+  "func resultado() devolver suma(1000000, 0) fin";
+
+inline constexpr std::string_view TAIL_CALL_TO_NESTED_FUNCTION_KEEPS_FRAME =
+  "func exterior(n)\n"
+  "  func interior(k) devolver n + k fin\n"
+  "  devolver interior(1)\n"
+  "fin\n"
+  "func resultado() devolver exterior(41) fin";
+
+inline constexpr std::string_view OPERANDS_KEEP_THEIR_VALUE_ACROSS_CALLS =
+  "var x se 1\n"
+  "var a se [1, 2]\n"
+  "func cambia_x() x se 10 devolver 1 fin\n"
+  "func cambia_a() a se [7, 8] devolver 1 fin\n"
+  "func resultado() devolver x + cambia_x() + a[cambia_a()] fin";
+
+inline constexpr std::string_view TAIL_CALL_TO_LARGER_FRAME =
+  "func grande(n)\n"
+  "  var a se 1 var b se 2 var c se 3\n"
+  "  devolver a + b + c + n\n"
+  "fin\n"
+  "func chico(n) devolver grande(n) fin\n"
+  "func resultado()\n"
+  "  var i se 0 var t se 0\n"
+  "  mientras i < 1000 haz t se t + chico(i) i se i + 1 fin\n"
+  "  devolver t\n"
+  "fin";
+
+inline constexpr std::string_view DEEP_RECURSION_KEEPS_EVERY_FRAME =
+  "func prof(n, s)\n"
+  "  var x se [n, s]\n"
+  "  si n = 0 haz devolver 0 fin\n"
+  "  var r se prof(n - 1, s)\n"
+  "  devolver r + x[0]\n"
+  "fin\n"
+  "func resultado() devolver prof(3000, 'a') fin";
+
+inline constexpr std::string_view ARRAY_INSERTAR =
+  "var x se []"
+  "x.insertar(10)"
+  "x.insertar('hello')"
+  "func resultado() devolver x fin";
+
+inline constexpr std::string_view ARRAY_ELIMINAR =
+  "var x se [0.05, 10, 30, 'hello']"
+  "x.eliminar(0)"
+  "func resultado() devolver x fin";
+
+inline constexpr std::string_view ARRAY_CONTIENE =
+  "var id se 'random'"
+  "var x se [0, 0, 3, id]"
+  "func resultado() devolver x.contiene('random') fin";
+
+inline constexpr std::string_view ARRAY_INSERTAR_EN =
+  "var id se 'target'"
+  "var x se [0, 0, 3]"
+  "x.insertar_en(1, id)"
+  "func resultado() devolver x.encuentra(id) fin";
+
+inline constexpr std::string_view CONTINUAR_RETURN_STILL_WORKS_WITH_CONTINUAR =
+  "func f()\n"
+  "  var i se 0\n"
+  "  mientras i < 10 haz\n"
+  "    i se i + 1\n"
+  "    si i = 5 haz devolver i fin\n"
+  "    continuar\n"
+  "  fin\n"
+  "  devolver 0\n"
+  "fin\n"
+  "func resultado() devolver f() fin";
+
+inline constexpr std::string_view CONTINUAR_INSIDE_FUNC_LOOP =
+  "func sumar_pares(n)\n"
+  "  var sum se 0\n"
+  "  var i se 0\n"
+  "  mientras i < n haz\n"
+  "    i se i + 1\n"
+  "    si i = 1 o i = 3 o i = 5 haz continuar fin\n"
+  "    sum se sum + i\n"
+  "  fin\n"
+  "  devolver sum\n"
+  "fin\n"
+  "func resultado() devolver sumar_pares(6) fin";
+
+inline constexpr std::string_view CONTINUAR_ONLY_AFFECTS_INNERMOST_LOOP =
+  "func contar()\n"
+  "  var total se 0\n"
+  "  var i se 0\n"
+  "  mientras i < 3 haz\n"
+  "    i se i + 1\n"
+  "    var j se 0\n"
+  "    mientras j < 3 haz\n"
+  "      j se j + 1\n"
+  "      si j = 2 haz continuar fin\n"
+  "      si i = 3 y j = 3 haz devolver total fin\n"
+  "      total se total + 1\n"
+  "    fin\n"
+  "  fin\n"
+  "  devolver -1\n"
+  "fin\n"
+  "func resultado() devolver contar() fin";
+
+inline constexpr std::string_view STR_METHOD_SEPARAR =
+  "var str se 'key|value'"
+  "var array se str.separar('|')"
+  "func resultado() devolver array fin";
+
+inline constexpr std::string_view STR_METHOD_SPLIT_STR_LITERAL =
+  "func resultado() devolver 'hello world'.separar(' ') fin";
+inline constexpr std::string_view STR_METHOD_TO_UPPER = "func resultado() devolver 'hello world'.en_mayuscula() fin";
+inline constexpr std::string_view STR_METHOD_TO_LOWER = "func resultado() devolver 'HELLO WORLD'.en_minuscula() fin";
+inline constexpr std::string_view STR_METHOD_FIND = "func resultado() devolver 'HELLO WORLD'.encuentra('E') fin";
+inline constexpr std::string_view STR_METHOD_NOT_FOUND =
+  "func resultado() devolver 'HELLO WORLD'.encuentra('z') fin";
+inline constexpr std::string_view SCOPING_FUNCTIONS_SEE_GLOBALS_NOT_CALLER_LOCALS =
+  "var x se 1\n"
+  "func leer_x() devolver x fin\n"
+  "func f() var x se 2 devolver leer_x() fin\n"
+  "func resultado() devolver f() fin";
+
+inline constexpr std::string_view SCOPING_NESTED_FUNCTION_READS_ENCLOSING_LOCALS =
+  "func f(n)\n"
+  "  var base se 10\n"
+  "  func g(k) devolver base + n + k fin\n"
+  "  devolver g(1)\n"
+  "fin\n"
+  "func resultado() devolver f(5) fin";
+
+inline constexpr std::string_view SCOPING_THIS_VISIBLE_IN_NESTED_FUNCTION =
+  "clase P\n"
+  "  var x se 3\n"
+  "  func doble()\n"
+  "    func aux() devolver este.x * 2 fin\n"
+  "    devolver aux()\n"
+  "  fin\n"
+  "fin\n"
+  "var p se P()\n"
+  "func resultado() devolver p.doble() fin";
+
+inline constexpr std::string_view SCOPING_NESTED_DECLARATIONS_SHADOW_ONLY_THEIR_SCOPE =
+  "func g() devolver 1 fin\n"
+  "func f()\n"
+  "  func g() devolver 2 fin\n"
+  "  devolver g()\n"
+  "fin\n"
+  "func resultado() devolver g() * 100 + f() * 10 + g() fin";
+
+inline constexpr std::string_view MEMO_STRING_ARGUMENTS_ARE_KEYS =
+  "func saludo(s) devolver 'hola ' + s fin\n"
+  "var a se saludo('ana')\n"
+  "func resultado() devolver saludo('ana') + '/' + saludo('eva') fin";
+
+
+struct Named final {
+  std::string_view test;
+  std::string_view src;
+};
+
+inline constexpr Named ALL[] {
+  {"Gc.CollectsWhileTheProgramRuns", GC_COLLECTS_WHILE_THE_PROGRAM_RUNS},
+  {"Interp.LiteralInt", LITERAL_INT},
+  {"Interp.LiteralFloat", LITERAL_FLOAT},
+  {"Interp.LiteralBoolTrue", LITERAL_BOOL_TRUE},
+  {"Interp.LiteralBoolFalse", LITERAL_BOOL_FALSE},
+  {"Interp.LiteralString", LITERAL_STRING},
+  {"Interp.VarDeclAndRead", VAR_DECL_AND_READ},
+  {"Interp.ConstDeclAndRead", CONST_DECL_AND_READ},
+  {"Interp.VarDeclRhsExpression", VAR_DECL_RHS_EXPRESSION},
+  {"Interp.Assignment", ASSIGNMENT},
+  {"Interp.AssignmentOverwrite", ASSIGNMENT_OVERWRITE},
+  {"Interp.Add", ADD},
+  {"Interp.Sub", SUB},
+  {"Interp.Mul", MUL},
+  {"Interp.Div", DIV},
+  {"Interp.FloatAdd", FLOAT_ADD},
+  {"Interp.IntFloatMixed", INT_FLOAT_MIXED},
+  {"Interp.LargeIntsStayExact", LARGE_INT_COMPARISON},
+  {"Interp.LargeIntsStayExact", LARGE_INT_SUM},
+  {"Interp.TypedLoopMatchesGenericResult", TYPED_LOOP_MATCHES_GENERIC_RESULT},
+  {"Interp.PolymorphicSiteRespecializes", POLYMORPHIC_SITE_RESPECIALIZES},
+  {"Interp.NegationUnary", NEGATION_UNARY},
+  {"Interp.Precedence", PRECEDENCE},
+  {"Interp.Parentheses", PARENTHESES},
+  {"Interp.StringConcat", STRING_CONCAT},
+  {"Interp.StringIntConcat", STRING_INT_CONCAT},
+  {"Interp.AppendingKeepsOtherCopies", APPENDING_KEEPS_OTHER_COPIES},
+  {"Interp.AppendingAStringToItself", APPENDING_A_STRING_TO_ITSELF},
+  {"Interp.AppendingInALoop", APPENDING_IN_A_LOOP},
+  {"Interp.CmpLT_True", CMP_LT_TRUE},
+  {"Interp.CmpLT_False", CMP_LT_FALSE},
+  {"Interp.CmpGT", CMP_GT},
+  {"Interp.CmpLE", CMP_LE},
+  {"Interp.CmpGE", CMP_GE},
+  {"Interp.CmpEQ_Int", CMP_EQ_INT},
+  {"Interp.CmpNEQ", CMP_NEQ},
+  {"Interp.CmpEQ_Str", CMP_EQ_STR},
+  {"Interp.LogicalAnd_TT", LOGICAL_AND_TT},
+  {"Interp.LogicalAnd_TF", LOGICAL_AND_TF},
+  {"Interp.LogicalOr_FF", LOGICAL_OR_FF},
+  {"Interp.LogicalOr_TF", LOGICAL_OR_TF},
+  {"Interp.LogicalBang", LOGICAL_BANG},
+  {"Interp.LogicalBangFalse", LOGICAL_BANG_FALSE},
+  {"Interp.IfTaken", IF_TAKEN},
+  {"Interp.IfNotTaken", IF_NOT_TAKEN},
+  {"Interp.IfElseTaken", IF_ELSE_TAKEN},
+  {"Interp.IfElseIfChain", IF_ELSE_IF_CHAIN},
+  {"Interp.WhileBasic", WHILE_BASIC},
+  {"Interp.WhileNotEntered", WHILE_NOT_ENTERED},
+  {"Interp.WhileAccumulator", WHILE_ACCUMULATOR},
+  {"Interp.FuncNoParams", FUNC_NO_PARAMS},
+  {"Interp.FuncWithParams", FUNC_WITH_PARAMS},
+  {"Interp.FuncRecursion", FUNC_RECURSION},
+  {"Interp.FuncReturnsNull", FUNC_RETURNS_NULL},
+  {"Interp.FuncNestedCalls", FUNC_NESTED_CALLS},
+  {"Interp.ArrayEmpty", ARRAY_EMPTY},
+  {"Interp.ArrayLiteral", ARRAY_LITERAL},
+  {"Interp.ArrayIndex", ARRAY_INDEX},
+  {"Interp.ArrayWithExpressions", ARRAY_WITH_EXPRESSIONS},
+  {"Interp.ClassInstantiationNoctor", CLASS_INSTANTIATION_NOCTOR},
+  {"Interp.ClassInstanceFields", CLASS_INSTANCE_FIELDS},
+  {"Interp.ClassFieldWrite", CLASS_FIELD_WRITE},
+  {"Interp.FieldInitializersRunInOrder", FIELD_INITIALIZERS_RUN_IN_ORDER},
+  {"Interp.FieldSiteSeesSeveralLayouts", FIELD_SITE_SEES_SEVERAL_LAYOUTS},
+  {"Interp.MemberAccessOnExpressions", MEMBER_ACCESS_ON_EXPRESSIONS},
+  {"Interp.PolymorphicCallSite", POLYMORPHIC_CALL_SITE},
+  {"Interp.CallSiteSeesInstancesAndNatives", CALL_SITE_SEES_INSTANCES_AND_NATIVES},
+  {"Interp.ClassMethodCall", CLASS_METHOD_CALL},
+  {"Interp.ClassSiblingMethodCall", CLASS_SIBLING_METHOD_CALL},
+  {"Interp.ClassToString", CLASS_TO_STRING},
+  {"Interp.Fibonacci", FIBONACCI},
+  {"Interp.Factorial", FACTORIAL},
+  {"Interp.SumArray", SUM_ARRAY},
+  {"Interp.CounterClass", COUNTER_CLASS},
+  {"Interp.HigherOrderViaWrapper", HIGHER_ORDER_VIA_WRAPPER},
+  {"Interp.StringToInt", STRING_TO_INT},
+  {"Interp.NumToStr", NUM_TO_STR},
+  {"Interp.IndexStr", INDEX_STR},
+  {"Interp.Index2dArray", INDEX2D_ARRAY},
+  {"Interp.LhsArrayAssignment", LHS_ARRAY_ASSIGNMENT},
+  {"Interp.RoundNumber", ROUND_NUMBER},
+  {"Interp.TailRecursionRunsInConstantStack", TAIL_RECURSION_RUNS_IN_CONSTANT_STACK},
+  {"Interp.TailCallToNestedFunctionKeepsFrame", TAIL_CALL_TO_NESTED_FUNCTION_KEEPS_FRAME},
+  {"Interp.OperandsKeepTheirValueAcrossCalls", OPERANDS_KEEP_THEIR_VALUE_ACROSS_CALLS},
+  {"Interp.TailCallToLargerFrame", TAIL_CALL_TO_LARGER_FRAME},
+  {"Interp.DeepRecursionKeepsEveryFrame", DEEP_RECURSION_KEEPS_EVERY_FRAME},
+  {"Array.Insertar", ARRAY_INSERTAR},
+  {"Array.Eliminar", ARRAY_ELIMINAR},
+  {"Array.Contiene", ARRAY_CONTIENE},
+  {"Array.InsertarEn", ARRAY_INSERTAR_EN},
+  {"Continuar.ReturnStillWorksWithContinuar", CONTINUAR_RETURN_STILL_WORKS_WITH_CONTINUAR},
+  {"Continuar.InsideFuncLoop", CONTINUAR_INSIDE_FUNC_LOOP},
+  {"Continuar.OnlyAffectsInnermostLoop", CONTINUAR_ONLY_AFFECTS_INNERMOST_LOOP},
+  {"StrMethod.separar", STR_METHOD_SEPARAR},
+  {"StrMethod.SplitStrLiteral", STR_METHOD_SPLIT_STR_LITERAL},
+  {"StrMethod.ToUpper", STR_METHOD_TO_UPPER},
+  {"StrMethod.ToLower", STR_METHOD_TO_LOWER},
+  {"StrMethod.Find", STR_METHOD_FIND},
+  {"StrMethod.NotFound", STR_METHOD_NOT_FOUND},
+  {"Scoping.FunctionsSeeGlobalsNotCallerLocals", SCOPING_FUNCTIONS_SEE_GLOBALS_NOT_CALLER_LOCALS},
+  {"Scoping.NestedFunctionReadsEnclosingLocals", SCOPING_NESTED_FUNCTION_READS_ENCLOSING_LOCALS},
+  {"Scoping.ThisVisibleInNestedFunction", SCOPING_THIS_VISIBLE_IN_NESTED_FUNCTION},
+  {"Scoping.NestedDeclarationsShadowOnlyTheirScope", SCOPING_NESTED_DECLARATIONS_SHADOW_ONLY_THEIR_SCOPE},
+  {"Memo.StringArgumentsAreKeys", MEMO_STRING_ARGUMENTS_ARE_KEYS},
+};
+
+}  // namespace programs
@@ -627,3 +627,167 @@ TEST(Sema, InnerCtor) {
     );
 }
 
+
+TEST(SemaSlots, ParamsAndLocalsGetFrameSlots) {
+  Parser p{"var g se 1\nfunc f(a, b) var c se a devolver g + c fin"};
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+
+  auto* fn = static_cast<const FunctionDecl*>(ast[1].get());
+  EXPECT_EQ(fn->frame_size, 3u);
+  auto* c = static_cast<const VariableDecl*>(fn->body[0].get());
+  EXPECT_EQ(c->slot.depth, 0u);
+  EXPECT_EQ(c->slot.index, 2u);
+
+  auto* a = static_cast<const Literal*>(c->expr.get());
+  EXPECT_EQ(a->slot.depth, 0u);
+  EXPECT_EQ(a->slot.index, 0u);
+
+  auto* sum = static_cast<const BinaryOp*>(static_cast<const ReturnStatement*>(fn->body[1].get())->expr.get());
+  auto* g   = static_cast<const Literal*>(sum->left.get());
+  EXPECT_EQ(g->slot.depth, 1u);
+  EXPECT_EQ(g->slot.index, 0u);
+}
+
+TEST(SemaSlots, SiblingBlocksShareSlots) {
+  Parser p{"func f() si verdadero haz var a se 1 fin si verdadero haz var b se 2 fin fin"};
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+
+  auto* fn = static_cast<const FunctionDecl*>(ast[0].get());
+  EXPECT_EQ(fn->frame_size, 1u);
+}
+
+TEST(Sema, MarksTailCalls) {
+  Parser p{
+    "func f(n)\n"
+    "  si n > 0 haz devolver f(n - 1) fin\n"
+    "  devolver 1 + f(0)\n"
+    "fin"
+  };
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+  auto* fn      = static_cast<const FunctionDecl*>(ast[0].get());
+  auto* branch  = static_cast<const IfStatement*>(fn->body[0].get());
+  auto* in_tail = static_cast<const ReturnStatement*>(branch->then_body[0].get());
+  auto* not_tail = static_cast<const ReturnStatement*>(fn->body[1].get());
+  EXPECT_TRUE(in_tail->tail_call);
+  EXPECT_FALSE(not_tail->tail_call);
+}
+
+static auto analyzed(std::string_view src) -> StmtsPtr {
+  Parser p{src};
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+  return ast;
+}
+
+static auto var_at(const StmtsPtr& stmts, std::size_t i) -> const VariableDecl* {
+  return static_cast<const VariableDecl*>(stmts[i].get());
+}
+
+TEST(Sema, InfersIntLoopCounter) {
+  auto ast = analyzed(
+    "func f()\n"
+    "  var i se 0\n"
+    "  mientras i < 10 haz i se i + 1 fin\n"
+    "  devolver i\n"
+    "fin"
+  );
+  auto* fn   = static_cast<const FunctionDecl*>(ast[0].get());
+  auto* loop = static_cast<const WhileStatement*>(fn->body[1].get());
+  auto* step = static_cast<const Assignment*>(loop->body[0].get());
+  EXPECT_EQ(var_at(fn->body, 0)->type, StaticType::INT);
+  EXPECT_EQ(static_cast<const BinaryOp*>(loop->condition.get())->operands, StaticType::INT);
+  EXPECT_EQ(static_cast<const BinaryOp*>(step->expr.get())->operands, StaticType::INT);
+}
+
+TEST(Sema, InfersFloatsAndStrings) {
+  auto ast = analyzed("var a se 1.5\nvar b se a * 2.0\nvar c se 'n=' + b\nvar d se a + 1");
+  EXPECT_EQ(var_at(ast, 1)->type, StaticType::FLOAT);
+  EXPECT_EQ(static_cast<const BinaryOp*>(var_at(ast, 1)->expr.get())->operands, StaticType::FLOAT);
+  EXPECT_EQ(var_at(ast, 2)->type, StaticType::STRING);
+  EXPECT_EQ(var_at(ast, 3)->type, StaticType::FLOAT);
+  EXPECT_EQ(static_cast<const BinaryOp*>(var_at(ast, 3)->expr.get())->operands, StaticType::UNKNOWN);
+}
+
+TEST(Sema, AnyLaterAssignmentWidensTheType) {
+  auto ast = analyzed(
+    "var x se 0\n"
+    "var y2 se x + 1\n"
+    "func f() x se 'texto' fin"
+  );
+  EXPECT_EQ(var_at(ast, 0)->type, StaticType::UNKNOWN);
+  EXPECT_EQ(static_cast<const BinaryOp*>(var_at(ast, 1)->expr.get())->operands, StaticType::UNKNOWN);
+}
+
+TEST(Sema, ParametersAndReplGlobalsStayUnknown) {
+  auto ast = analyzed("func f(n) devolver n + 1 fin");
+  auto* fn  = static_cast<const FunctionDecl*>(ast[0].get());
+  auto* ret = static_cast<const ReturnStatement*>(fn->body[0].get());
+  EXPECT_EQ(static_cast<const BinaryOp*>(ret->expr.get())->operands, StaticType::UNKNOWN);
+
+  Sema sema;
+  sema.init_repl();
+  Parser p{"var g se 1"};
+  auto input = p.parse();
+  sema.analyze_incremental(input);
+  EXPECT_EQ(var_at(input, 0)->type, StaticType::UNKNOWN);
+
+  // Nor does a later input that assigns it.
+  Parser later{"escribe(g + 1) g se 2"};
+  auto next = later.parse();
+  sema.analyze_incremental(next);
+  auto* call = static_cast<const FunctionCall*>(next[0].get());
+  EXPECT_EQ(static_cast<const BinaryOp*>(call->exprs[0].get())->operands, StaticType::UNKNOWN);
+}
+
+static auto function_at(const StmtsPtr& stmts, std::size_t i) -> const FunctionDecl* {
+  return static_cast<const FunctionDecl*>(stmts[i].get());
+}
+
+TEST(Sema, MarksPureFunctions) {
+  auto ast = analyzed(
+    "const limite se 10\n"
+    "var contador se 0\n"
+    "func fib(n)\n"
+    "  si n < 2 haz devolver n fin\n"
+    "  devolver fib(n - 1) + fib(n - 2)\n"
+    "fin\n"
+    "func acota(n) devolver min(n, limite) fin\n"
+    "func cuenta() contador se contador + 1 devolver contador fin\n"
+    "func muestra(n) escribe(n) fin\n"
+    "func usa_muestra(n) muestra(n) devolver n fin\n"
+    "func lee() devolver contador fin\n"
+    "func local(n)\n"
+    "  var a se [n]\n"
+    "  a[0] se 1\n"
+    "  devolver a[0]\n"
+    "fin"
+  );
+  EXPECT_TRUE(function_at(ast, 2)->pure);
+  EXPECT_TRUE(function_at(ast, 3)->pure);
+  EXPECT_FALSE(function_at(ast, 4)->pure);
+  EXPECT_FALSE(function_at(ast, 5)->pure);
+  EXPECT_FALSE(function_at(ast, 6)->pure);
+  EXPECT_FALSE(function_at(ast, 7)->pure);
+  EXPECT_FALSE(function_at(ast, 8)->pure);
+}
+
+TEST(Sema, MethodsAndNestedFunctionsAreNotPure) {
+  auto ast = analyzed(
+    "clase C\n"
+    "  func valor() devolver 1 fin\n"
+    "fin\n"
+    "func externa(n)\n"
+    "  func doble(k) devolver k * 2 fin\n"
+    "  devolver doble(n)\n"
+    "fin\n"
+    "func nueva() devolver C() fin"
+  );
+  auto* klass = static_cast<const ClassDecl*>(ast[0].get());
+  EXPECT_FALSE(function_at(klass->members, 0)->pure);
+  EXPECT_FALSE(function_at(ast, 1)->pure);
+  EXPECT_FALSE(function_at(function_at(ast, 1)->body, 0)->pure);
+  EXPECT_FALSE(function_at(ast, 2)->pure);
+}
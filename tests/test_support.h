@@ -0,0 +1,37 @@
+#pragma once
+#include <algorithm>
+#include <initializer_list>
+#include "nodes.h"
+#include "sema.h"
+#include "error_manager.h"
+
+// Sema errors a test expects from its program.
+using AllowedErrors = std::initializer_list<SemanticErrorCode>;
+
+// The harnesses end their programs with a top-level 'devolver', which Sema
+// reports; that is the one error they allow unless the test says otherwise.
+inline constexpr AllowedErrors HARNESS_ERRORS = {SemanticErrorCode::RET_OUTSIDE_FUNC};
+
+// Rethrows 'e' unless every error in it is one of 'allowed'. The tree is
+// fully annotated either way, so the program can still run.
+inline auto allow_only(const SemanticException& e, AllowedErrors allowed) -> void {
+  for (const auto& err : e.errors)
+    if (std::ranges::find(allowed, err.code) == allowed.end()) throw e;
+}
+
+inline auto analyze(const StmtsPtr& ast, AllowedErrors allowed = HARNESS_ERRORS) -> void {
+  try {
+    Sema{}.analyze(ast);
+  } catch (const SemanticException& e) {
+    allow_only(e, allowed);
+  }
+}
+
+// As analyze, for one input of a REPL session.
+inline auto analyze_input(Sema& sema, const StmtsPtr& ast, AllowedErrors allowed = HARNESS_ERRORS) -> void {
+  try {
+    sema.analyze_incremental(ast);
+  } catch (const SemanticException& e) {
+    allow_only(e, allowed);
+  }
+}
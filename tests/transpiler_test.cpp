@@ -0,0 +1,132 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "nodes.h"
+#include "parser.h"
+#include "sema.h"
+#include "interpreter.h"
+#include "transpiler.h"
+#include "error_manager.h"
+#include "programs.h"
+
+static auto translate(std::string_view src) -> std::string {
+  Parser p{src};
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+  return Transpiler{}.translate(ast);
+}
+
+TEST(Transpiler, NestedClassesAreNotSupported) {
+  EXPECT_THROW(translate(
+    "func f()\n"
+    "  clase Interna var x se 1 fin\n"
+    "  devolver Interna()\n"
+    "fin\n"
+    "f()"
+  ), RuntimeError);
+}
+
+// Run after the shared corpus in programs.h: a few programs that lean on
+// the translation itself.
+static constexpr programs::Named TRANSLATION_PROGRAMS[] {
+  {"Transpiler.OperandsWithEffectsKeepTheirOrder",
+    "func uno() escribe('uno') devolver 1 fin\n"
+    "func dos() escribe('dos') devolver 2 fin\n"
+    "func resultado() devolver uno() + dos() fin"},
+  {"Transpiler.SelfTailCallsLoop",
+    "func cuenta(n, acc)\n"
+    "  si n = 0 haz devolver acc fin\n"
+    "  devolver cuenta(n - 1, acc + 1)\n"
+    "fin\n"
+    "func resultado() devolver cuenta(1000000, 0) fin"},
+  {"Transpiler.GlobalsAreReadInsideFunctions",
+    "var x se 'hola'\n"
+    "func resultado() x se x + ' mundo' devolver x fin"},
+};
+
+static auto walker_output(std::string_view src) -> std::string {
+  Parser p{src};
+  auto ast = p.parse();
+  Sema{}.analyze(ast);
+  testing::internal::CaptureStdout();
+  try {
+    Interpreter{}.run(ast);
+  } catch (...) {
+    testing::internal::GetCapturedStdout();
+    throw;
+  }
+  return testing::internal::GetCapturedStdout();
+}
+
+// Every translation in one binary that runs the one its argument names:
+// the includes go first and each translation into a namespace of its own,
+// so one compile covers them all.
+static auto bundle(const std::vector<std::string>& translations) -> std::string {
+  std::string includes, bodies, entries;
+  for (auto i {0uz}; i < translations.size(); ++i) {
+    std::istringstream in{translations[i]};
+    bodies += std::format("namespace p{} {{\n", i);
+    for (std::string line; std::getline(in, line);)
+      (line.starts_with("#include") ? includes : bodies) += line + "\n";
+    bodies  += "}\n";
+    entries += std::format("p{}::main, ", i);
+  }
+  return includes + bodies +
+    "auto main(int argc, char** argv) -> int {\n"
+    "  int (*programs[])() {" + entries + "};\n"
+    "  return argc == 2 ? programs[std::atoi(argv[1])]() : EXIT_FAILURE;\n"
+    "}\n";
+}
+
+static auto run_binary(const std::string& command, int& status) -> std::string {
+  std::string out;
+  auto* pipe = popen(command.c_str(), "r");
+  if (!pipe) return out;
+  char buffer[4096];
+  for (std::size_t n; (n = std::fread(buffer, 1, sizeof buffer, pipe)) > 0;)
+    out.append(buffer, n);
+  status = pclose(pipe);
+  return out;
+}
+
+// Builds the translations against the runtime (OLM_AOT_CXX and
+// OLM_AOT_LIBS come from CMakeLists.txt) and checks that each prints what
+// the tree walker prints.
+TEST(Transpiler, ProgramsPrintWhatTheTreeWalkerPrints) {
+#if !defined(OLM_AOT_CXX) || !defined(OLM_AOT_LIBS)
+  GTEST_SKIP() << "sin compilador para el codigo generado";
+#else
+  std::vector<programs::Named> all{std::begin(programs::ALL), std::end(programs::ALL)};
+  all.insert(all.end(), std::begin(TRANSLATION_PROGRAMS), std::end(TRANSLATION_PROGRAMS));
+
+  std::vector<std::string> expected, translations;
+  for (const auto& [test, src] : all) {
+    auto program = std::string(src) + "\nescribe(resultado())";
+    expected.push_back(walker_output(program));
+    translations.push_back(translate(program));
+  }
+
+  auto dir = std::filesystem::temp_directory_path() / std::format("olm_aot_{}", getpid());
+  std::filesystem::create_directories(dir);
+  auto source = dir / "programas.cpp";
+  auto binary = dir / "programas";
+  std::ofstream{source} << bundle(translations);
+  auto build = std::format("{} {} -o {} {}", OLM_AOT_CXX, source.string(), binary.string(), OLM_AOT_LIBS);
+  ASSERT_EQ(std::system(build.c_str()), 0) << build;
+
+  for (auto i {0uz}; i < all.size(); ++i) {
+    int status = -1;
+    auto got = run_binary(std::format("{} {}", binary.string(), i), status);
+    EXPECT_EQ(status, 0) << all[i].test;
+    EXPECT_EQ(got, expected[i]) << all[i].test;
+  }
+  std::filesystem::remove_all(dir);
+#endif
+}
@@ -0,0 +1,458 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <optional>
+#include "nodes.h"
+#include "parser.h"
+#include "compiler.h"
+#include "vm.h"
+#include "sema.h"
+#include "error_manager.h"
+#include "test_support.h"
+
+// Same contract as the interpreter tests: the program ends with a
+// top-level 'devolver' and the VM hands the value back as a ReturnSignal.
+static auto get_result(std::string_view src) -> std::optional<Value> {
+  std::string trigger = std::string(src) + "\ndevolver resultado()";
+  Parser p{trigger};
+  auto ast = p.parse();
+  Compiler compiler;
+  auto program = compiler.compile(ast);
+  VM vm{program};
+  try {
+    vm.run();
+  } catch (ReturnSignal& rs) {
+    return rs.value;
+  }
+  return std::nullopt;
+}
+
+// As get_result, after Sema has resolved names per scope and marked the
+// tail calls and appends.
+static auto get_analyzed_result(std::string_view src) -> std::optional<Value> {
+  std::string trigger = std::string(src) + "\ndevolver resultado()";
+  Parser p{trigger};
+  auto ast = p.parse();
+  analyze(ast);
+  Compiler compiler;
+  auto program = compiler.compile(ast);
+  VM vm{program};
+  try {
+    vm.run();
+  } catch (ReturnSignal& rs) {
+    return rs.value;
+  }
+  return std::nullopt;
+}
+
+static auto run_error(std::string_view src, std::string_view substr) -> void {
+  Parser p{src};
+  auto ast = p.parse();
+  try {
+    Compiler compiler;
+    auto program = compiler.compile(ast);
+    VM vm{program};
+    vm.run();
+    FAIL() << "Expected RuntimeError containing '" << substr << "'";
+  } catch (const RuntimeError& e) {
+    EXPECT_NE(std::string(e.what()).find(substr), std::string::npos)
+        << "Got: " << e.what();
+  }
+}
+
+#define EXPECT_INT(val, n)    ASSERT_TRUE((val).has_value()); \
+                              EXPECT_TRUE((val)->is_int())    << (val)->to_string(); \
+                              EXPECT_EQ((val)->as_int(), (n))
+#define EXPECT_FLOAT(val, f)  ASSERT_TRUE((val).has_value()); \
+                              EXPECT_TRUE((val)->is_float())  << (val)->to_string(); \
+                              EXPECT_DOUBLE_EQ((val)->as_float(), (f))
+#define EXPECT_BOOL(val, b)   ASSERT_TRUE((val).has_value()); \
+                              EXPECT_TRUE((val)->is_bool())   << (val)->to_string(); \
+                              EXPECT_EQ((val)->as_bool(), (b))
+#define EXPECT_STR(val, s)    ASSERT_TRUE((val).has_value()); \
+                              EXPECT_TRUE((val)->is_string())  << (val)->to_string(); \
+                              EXPECT_EQ((val)->as_string(), (s))
+#define EXPECT_NULL(val)      ASSERT_TRUE((val).has_value()); \
+                              EXPECT_TRUE((val)->is_null())    << (val)->to_string()
+#define EXPECT_ARRAY(val, s)  ASSERT_TRUE((val).has_value()); \
+                              EXPECT_TRUE((val)->is_array()) << (val)->to_string(); \
+                              EXPECT_EQ((val)->to_string(), (s))
+
+TEST(VM, LiteralInt)    { auto v = get_result("func resultado() devolver 42 fin");        EXPECT_INT(v, 42); }
+TEST(VM, LiteralFloat)  { auto v = get_result("func resultado() devolver 3.5 fin");       EXPECT_FLOAT(v, 3.5); }
+TEST(VM, LiteralBool)   { auto v = get_result("func resultado() devolver verdadero fin"); EXPECT_BOOL(v, true); }
+TEST(VM, LiteralString) { auto v = get_result("func resultado() devolver 'hola' fin");    EXPECT_STR(v, "hola"); }
+TEST(VM, LiteralNull)   { auto v = get_result("func resultado() devolver nulo fin");      EXPECT_NULL(v); }
+
+TEST(VM, Arithmetic)     { auto v = get_result("func resultado() devolver (2 + 3) * 4 - 10 / 2 fin"); EXPECT_INT(v, 15); }
+TEST(VM, IntFloatMixed)  { auto v = get_result("func resultado() devolver 1 + 0.5 fin");  EXPECT_FLOAT(v, 1.5); }
+TEST(VM, StringConcat)   { auto v = get_result("func resultado() devolver 'n=' + 42 fin"); EXPECT_STR(v, "n=42"); }
+TEST(VM, Negation)       { auto v = get_result("func resultado() devolver -5 fin");       EXPECT_INT(v, -5); }
+TEST(VM, Comparison)     { auto v = get_result("func resultado() devolver 2 <= 2 fin");   EXPECT_BOOL(v, true); }
+TEST(VM, NotEqual)       { auto v = get_result("func resultado() devolver 5 != 6 fin");   EXPECT_BOOL(v, true); }
+TEST(VM, LogicalAnd)     { auto v = get_result("func resultado() devolver verdadero y falso fin"); EXPECT_BOOL(v, false); }
+TEST(VM, LogicalOr)      { auto v = get_result("func resultado() devolver falso o 1 fin");  EXPECT_BOOL(v, true); }
+TEST(VM, LogicalBang)    { auto v = get_result("func resultado() devolver !falso fin");     EXPECT_BOOL(v, true); }
+
+TEST(VM, ShortCircuitSkipsRight) {
+  auto v = get_result(
+    "var n se 0\n"
+    "func toca() n se n + 1 devolver verdadero fin\n"
+    "var a se falso y toca()\n"
+    "var b se verdadero o toca()\n"
+    "func resultado() devolver n fin"
+  );
+  EXPECT_INT(v, 0);
+}
+
+TEST(VM, GlobalAssignment) {
+  auto v = get_result("var x se 1\nx se 99\nfunc resultado() devolver x fin");
+  EXPECT_INT(v, 99);
+}
+
+TEST(VM, IfElseIfChain) {
+  auto v = get_result(
+    "var n se 2\n"
+    "var r se 0\n"
+    "si n = 1 haz r se 10\n"
+    "sino si n = 2 haz r se 20\n"
+    "sino r se 30\n"
+    "fin\n"
+    "func resultado() devolver r fin"
+  );
+  EXPECT_INT(v, 20);
+}
+
+TEST(VM, WhileAccumulator) {
+  auto v = get_result(
+    "func suma_hasta(n)\n"
+    "  var acc se 0\n"
+    "  var i se 1\n"
+    "  mientras i <= n haz\n"
+    "    acc se acc + i\n"
+    "    i se i + 1\n"
+    "  fin\n"
+    "  devolver acc\n"
+    "fin\n"
+    "func resultado() devolver suma_hasta(100) fin"
+  );
+  EXPECT_INT(v, 5050);
+}
+
+TEST(VM, ContinueSkipsRestOfBody) {
+  auto v = get_result(
+    "func sumar_pares(n)\n"
+    "  var sum se 0\n"
+    "  var i se 0\n"
+    "  mientras i < n haz\n"
+    "    i se i + 1\n"
+    "    si i = 1 o i = 3 o i = 5 haz continuar fin\n"
+    "    sum se sum + i\n"
+    "  fin\n"
+    "  devolver sum\n"
+    "fin\n"
+    "func resultado() devolver sumar_pares(6) fin"
+  );
+  EXPECT_INT(v, 12);
+}
+
+TEST(VM, ReturnFromInsideLoop) {
+  auto v = get_result(
+    "func f()\n"
+    "  var i se 0\n"
+    "  mientras i < 10 haz\n"
+    "    i se i + 1\n"
+    "    var tmp se i * 2\n"
+    "    si tmp = 10 haz devolver i fin\n"
+    "  fin\n"
+    "  devolver 0\n"
+    "fin\n"
+    "func resultado() devolver f() fin"
+  );
+  EXPECT_INT(v, 5);
+}
+
+TEST(VM, Recursion) {
+  auto v = get_result(
+    "func fib(n)\n"
+    "  si n < 2 haz devolver n fin\n"
+    "  devolver fib(n - 1) + fib(n - 2)\n"
+    "fin\n"
+    "func resultado() devolver fib(15) fin"
+  );
+  EXPECT_INT(v, 610);
+}
+
+TEST(VM, TailCallsReuseTheFrame) {
+  Parser p{
+    "func suma(n, acc)\n"
+    "  si n = 0 haz devolver acc fin\n"
+    "  devolver suma(n - 1, acc + n)\n"
+    "fin\n"
+    "var total se suma(1000000, 0)\n"
+    "devolver total"
+  };
+  auto ast = p.parse();
+  analyze(ast);
+  Compiler compiler;
+  auto program = compiler.compile(ast);
+  // TAIL_CALL [u16] [u8], then the implicit PUSH_NIL RETURN.
+  const auto& code = program.functions[0].chunk.code;
+  ASSERT_EQ(static_cast<OpCode>(code.end()[-6]), OpCode::TAIL_CALL);
+  std::optional<Value> v;
+  try {
+    VM{program}.run();
+  } catch (ReturnSignal& rs) {
+    v = rs.value;
+  }
+  EXPECT_INT(v, 500000500000);
+}
+
+TEST(VM, AppendsToUnsharedStringsInPlace) {
+  Parser p{
+    "var t se \"\"\n"
+    "func junta(n)\n"
+    "  var s se \"a\"\n"
+    "  var i se 0\n"
+    "  mientras i < n haz\n"
+    "    s se s + \"-\" + i\n"
+    "    si i = 1 haz t se s fin\n"
+    "    i se i + 1\n"
+    "  fin\n"
+    "  devolver s + \"|\" + t\n"
+    "fin\n"
+    "devolver junta(3)"
+  };
+  auto ast = p.parse();
+  analyze(ast);
+  Compiler compiler;
+  auto program = compiler.compile(ast);
+  std::optional<Value> v;
+  try {
+    VM{program}.run();
+  } catch (ReturnSignal& rs) {
+    v = rs.value;
+  }
+  EXPECT_STR(v, "a-0-1-2|a-0-1");
+}
+
+TEST(VM, FuncReturnsNull) {
+  auto v = get_result("func nada() fin\nfunc resultado() devolver nada() fin");
+  EXPECT_NULL(v);
+}
+
+TEST(VM, Builtins) {
+  auto v = get_result("func resultado() devolver max(entero('7'), longitud([1, 2])) fin");
+  EXPECT_INT(v, 7);
+}
+
+TEST(VM, ArrayIndexAndAssign) {
+  auto v = get_result(
+    "var t se [['#', 'x', '#']]\n"
+    "t[0][1] se '#'\n"
+    "func resultado() devolver t fin"
+  );
+  EXPECT_ARRAY(v, "[[#, #, #]]");
+}
+
+TEST(VM, ArrayMethods) {
+  auto v = get_result(
+    "var x se []\n"
+    "x.insertar(10)\n"
+    "x.insertar_en(0, 'a')\n"
+    "func resultado() devolver x fin"
+  );
+  EXPECT_ARRAY(v, "[a, 10]");
+}
+
+TEST(VM, StringMethods) {
+  auto v = get_result("func resultado() devolver 'hola mundo'.separar(' ') fin");
+  EXPECT_ARRAY(v, "[hola, mundo]");
+}
+
+TEST(VM, StringIndex) {
+  auto v = get_result("var s se 'Holis'\nfunc resultado() devolver s[0] fin");
+  EXPECT_STR(v, "H");
+}
+
+TEST(VM, ClassFieldsAndMethods) {
+  auto v = get_result(
+    "clase Contador\n"
+    "  var n se 0\n"
+    "  func crear(inicio) este.n se inicio fin\n"
+    "  func tick() este.n se este.n + 1 fin\n"
+    "  func valor() devolver este.n fin\n"
+    "fin\n"
+    "var c se Contador(10)\n"
+    "c.tick()\n"
+    "c.tick()\n"
+    "c.n se c.n + 5\n"
+    "func resultado() devolver c.valor() fin"
+  );
+  EXPECT_INT(v, 17);
+}
+
+TEST(VM, ClassSiblingMethodCall) {
+  auto v = get_result(
+    "clase A\n"
+    "  func doble(x) devolver x + x fin\n"
+    "  func cuad(x) devolver este.doble(este.doble(x)) fin\n"
+    "fin\n"
+    "var a se A()\n"
+    "func resultado() devolver a.cuad(3) fin"
+  );
+  EXPECT_INT(v, 12);
+}
+
+TEST(VM, ClassFieldInitializersUseGlobals) {
+  auto v = get_result(
+    "var base se 4\n"
+    "clase P\n"
+    "  var x se base * 2\n"
+    "fin\n"
+    "var p se P()\n"
+    "func resultado() devolver p.x fin"
+  );
+  EXPECT_INT(v, 8);
+}
+
+TEST(VM, MemberChain) {
+  auto v = get_result(
+    "clase Nodo\n"
+    "  var valor se 0\n"
+    "  var sig se nulo\n"
+    "fin\n"
+    "var a se Nodo()\n"
+    "a.sig se Nodo()\n"
+    "a.sig.valor se 7\n"
+    "func resultado() devolver a.sig.valor fin"
+  );
+  EXPECT_INT(v, 7);
+}
+
+TEST(VM, MemberAccessOnCallResult) {
+  auto v = get_result(
+    "clase P\n"
+    "  var x se 5\n"
+    "fin\n"
+    "func resultado() devolver P().x fin"
+  );
+  EXPECT_INT(v, 5);
+}
+
+TEST(VM, LocalsAreLexical) {
+  auto v = get_result(
+    "var x se 1\n"
+    "func leer_x() devolver x fin\n"
+    "func f() var x se 2 devolver leer_x() fin\n"
+    "func resultado() devolver f() fin"
+  );
+  EXPECT_INT(v, 1);
+}
+
+TEST(VM, NestedFunctionReadsAndWritesEnclosingLocals) {
+  auto v = get_analyzed_result(
+    "var base se 100\n"
+    "func f(n)\n"
+    "  var base se 10\n"
+    "  func g(k)\n"
+    "    func h() base se base + 1 devolver n fin\n"
+    "    devolver base + h() + k\n"
+    "  fin\n"
+    "  var r se g(1)\n"
+    "  devolver r * 1000 + base\n"
+    "fin\n"
+    "func resultado() devolver f(5) + base fin"
+  );
+  EXPECT_INT(v, 16'111);
+}
+
+TEST(VM, NestedFunctionSeesTheLatestEnclosingFrame) {
+  auto v = get_analyzed_result(
+    "func f(n)\n"
+    "  func g() devolver n fin\n"
+    "  si n = 0 haz devolver g() fin\n"
+    "  devolver g() * 10 + f(n - 1)\n"
+    "fin\n"
+    "func resultado() devolver f(3) fin"
+  );
+  EXPECT_INT(v, 60);
+}
+
+TEST(VM, ThisVisibleInNestedFunction) {
+  auto v = get_analyzed_result(
+    "clase P\n"
+    "  var x se 3\n"
+    "  func doble()\n"
+    "    func aux() devolver este.x * 2 fin\n"
+    "    devolver aux()\n"
+    "  fin\n"
+    "fin\n"
+    "var p se P()\n"
+    "func resultado() devolver p.doble() fin"
+  );
+  EXPECT_INT(v, 6);
+}
+
+TEST(VM, NestedClassReadsEnclosingLocals) {
+  auto v = get_analyzed_result(
+    "func f(n)\n"
+    "  var paso se 2\n"
+    "  clase C\n"
+    "    var v se n\n"
+    "    func sube() devolver este.v + paso fin\n"
+    "  fin\n"
+    "  devolver C().sube()\n"
+    "fin\n"
+    "func resultado() devolver f(40) fin"
+  );
+  EXPECT_INT(v, 42);
+}
+
+TEST(VM, NestedDeclarationsShadowOnlyTheirScope) {
+  auto v = get_analyzed_result(
+    "func g() devolver 1 fin\n"
+    "func f()\n"
+    "  func g() devolver 2 fin\n"
+    "  devolver g()\n"
+    "fin\n"
+    "func resultado() devolver g() * 100 + f() * 10 + g() fin"
+  );
+  EXPECT_INT(v, 121);
+}
+
+TEST(VM, UndefinedVariable) {
+  run_error("mientras falso haz var x se 1 fin\nvar a se x", "no definida");
+}
+
+TEST(VM, AssignmentToUndeclared) {
+  run_error("x se 1", "no declarada");
+}
+
+TEST(VM, ArityMismatch) {
+  run_error("func f(a, b) devolver a + b fin\nf(1)", "argumento");
+}
+
+TEST(VM, CtorArityMismatch) {
+  run_error("clase P\n  func crear(a, b) fin\nfin\nvar p se P(1)", "argumento");
+}
+
+TEST(VM, DivisionByZero) {
+  run_error("func f() devolver 1 / 0 fin\nf()", "cero");
+}
+
+TEST(VM, IndexOutOfRange) {
+  run_error("var a se [1, 2]\nvar x se a[5]", "fuera de rango");
+}
+
+TEST(VM, UnknownMethod) {
+  run_error("clase A fin\nvar a se A()\na.nada()", "no tiene metodo");
+}
+
+TEST(VM, DeepRecursionOverflowsCleanly) {
+  Parser p{"func f(n) devolver 1 + f(n + 1) fin\nf(0)"};
+  auto ast = p.parse();
+  Compiler compiler;
+  auto program = compiler.compile(ast);
+  VM vm{program, 1000};
+  EXPECT_THROW(vm.run(), RuntimeError);
+}